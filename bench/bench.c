@@ -0,0 +1,277 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* Usage: bench parse|dump|fetch [kind] [bytes]
+ *
+ * Runs the operation over each corpus kind (or just the one named) and
+ * reports throughput, time per operation, and, where the kernel allows
+ * perf_event_open(), cycles, instructions, and cache misses per byte. */
+
+#include <cdson.h>
+#include "corpus.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef HAVE_PERF_EVENT
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* long enough to settle.  short enough for ninja benchmark */
+#define MIN_NS 300000000ULL
+#define MIN_RUNS 3
+
+typedef struct {
+    int fds[3];
+    uint64_t values[3];
+    int n;
+} counters;
+
+#ifdef HAVE_PERF_EVENT
+static const uint64_t counter_configs[3] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+};
+
+static void counters_open(counters *c) {
+    struct perf_event_attr attr;
+
+    c->n = 0;
+    for (int i = 0; i < 3; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = counter_configs[i];
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        c->fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (c->fds[i] < 0) {
+            while (i-- > 0)
+                close(c->fds[i]);
+            return;
+        }
+    }
+    c->n = 3;
+}
+
+static void counters_start(counters *c) {
+    for (int i = 0; i < c->n; i++) {
+        ioctl(c->fds[i], PERF_EVENT_IOC_RESET, 0);
+        ioctl(c->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+static void counters_stop(counters *c) {
+    for (int i = 0; i < c->n; i++) {
+        ioctl(c->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+        if (read(c->fds[i], &c->values[i], sizeof(uint64_t)) !=
+            sizeof(uint64_t))
+            c->values[i] = 0;
+    }
+}
+
+static void counters_close(counters *c) {
+    for (int i = 0; i < c->n; i++)
+        close(c->fds[i]);
+}
+#else
+static void counters_open(counters *c) {
+    c->n = 0;
+}
+static void counters_start(counters *c) {
+    (void)c;
+}
+static void counters_stop(counters *c) {
+    (void)c;
+}
+static void counters_close(counters *c) {
+    (void)c;
+}
+#endif
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void check(char *err, const char *what) {
+    if (err != NULL) {
+        fprintf(stderr, "%s failed: %s\n", what, err);
+        exit(1);
+    }
+}
+
+typedef struct {
+    const char *input;
+    size_t len;
+    dson_value *tree;
+    char **queries;
+    size_t n_queries;
+} workload;
+
+/* One operation.  Returns bytes processed (0 for fetch). */
+static size_t op_parse(workload *w) {
+    dson_value *v;
+
+    check(dson_parse(w->input, w->len, false, &v), "parse");
+    dson_free(&v);
+    return w->len;
+}
+
+static size_t op_dump(workload *w) {
+    char *out;
+    size_t len;
+
+    check(dson_dump(w->tree, &out, &len), "dump");
+    free(out);
+    return len;
+}
+
+static size_t op_fetch(workload *w) {
+    dson_value *v;
+
+    for (size_t i = 0; i < w->n_queries; i++)
+        check(dson_fetch(w->tree, w->queries[i], DSON_MATCH_FIRST, &v),
+              "fetch");
+    return 0;
+}
+
+/* 64 root-to-leaf paths, spread evenly across each container's children. */
+static void build_queries(workload *w) {
+    char path[4096];
+    size_t n, used, cap = 64;
+    dson_value *v;
+
+    w->queries = malloc(cap * sizeof(*w->queries));
+    w->n_queries = 0;
+
+    for (size_t pick = 0; pick < 64; pick++) {
+        used = 0;
+        path[0] = '\0';
+        for (v = w->tree; v->type == DSON_ARRAY || v->type == DSON_DICT;) {
+            if (v->type == DSON_ARRAY) {
+                for (n = 0; v->array[n] != NULL; n++);
+                if (n == 0)
+                    break;
+                n = (n - 1) * pick / 63;
+                used += snprintf(path + used, sizeof(path) - used, "[%zu]",
+                                 n);
+                v = v->array[n];
+            } else {
+                for (n = 0; v->dict->keys[n] != NULL; n++);
+                n = (n - 1) * pick / 63;
+                used += snprintf(path + used, sizeof(path) - used, ".%s",
+                                 v->dict->keys[n]);
+                v = v->dict->values[n];
+            }
+            if (used >= sizeof(path) - 64)
+                break;
+        }
+        w->queries[w->n_queries++] = strdup(path);
+    }
+}
+
+static void run(const char *op, const char *kind, size_t target) {
+    size_t (*fn)(workload *);
+    workload w = { 0 };
+    counters ctr;
+    uint64_t start, elapsed = 0, runs = 0, bytes = 0, ops;
+    char *input;
+
+    input = corpus_generate(kind, target, &w.len);
+    if (input == NULL) {
+        fprintf(stderr, "unknown corpus kind %s\n", kind);
+        exit(1);
+    }
+    w.input = input;
+    check(dson_parse(w.input, w.len, false, &w.tree), "parse");
+
+    if (!strcmp(op, "parse")) {
+        fn = op_parse;
+    } else if (!strcmp(op, "dump")) {
+        fn = op_dump;
+    } else if (!strcmp(op, "fetch")) {
+        fn = op_fetch;
+        build_queries(&w);
+    } else {
+        fprintf(stderr, "unknown operation %s\n", op);
+        exit(1);
+    }
+
+    fn(&w); /* warm doge */
+
+    counters_open(&ctr);
+    counters_start(&ctr);
+    while (elapsed < MIN_NS || runs < MIN_RUNS) {
+        start = now_ns();
+        bytes += fn(&w);
+        elapsed += now_ns() - start;
+        runs++;
+    }
+    counters_stop(&ctr);
+    counters_close(&ctr);
+
+    /* fetch touches a path, not the input.  per op, not per byte */
+    ops = runs * (w.n_queries ? w.n_queries : 1);
+    printf("%-6s %-8s %9zu B", op, kind, w.len);
+    if (bytes != 0)
+        printf(" %10.1f MB/s", (double)bytes / ((double)elapsed / 1e9) / 1e6);
+    else
+        printf(" %10s     ", "-");
+    printf(" %12.1f ns/op", (double)elapsed / ops);
+    if (ctr.n == 3) {
+        double per = bytes != 0 ? (double)bytes : (double)ops;
+        const char *unit = bytes != 0 ? "B" : "op";
+
+        printf("  %8.2f cyc/%s %8.2f ins/%s %8.5f miss/%s",
+               ctr.values[0] / per, unit, ctr.values[1] / per, unit,
+               ctr.values[2] / per, unit);
+    } else {
+        printf("  (hardware counters unavailable)");
+    }
+    printf("\n");
+
+    for (size_t i = 0; i < w.n_queries; i++)
+        free(w.queries[i]);
+    free(w.queries);
+    dson_free(&w.tree);
+    free(input);
+}
+
+int main(int argc, char *argv[]) {
+    size_t target = 1 << 22;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s parse|dump|fetch [kind] [bytes]\n",
+                argv[0]);
+        return 1;
+    }
+    if (argc > 3)
+        target = strtoull(argv[3], NULL, 0);
+
+    if (argc > 2) {
+        run(argv[1], argv[2], target);
+        return 0;
+    }
+    for (size_t i = 0; corpus_kinds[i] != NULL; i++)
+        run(argv[1], corpus_kinds[i], target);
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,190 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "corpus.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const char *corpus_kinds[] = {
+    "strings", "numbers", "nested", "wide", "pretty", NULL,
+};
+
+typedef struct {
+    char *data;
+    size_t len;
+    size_t cap;
+    uint64_t rng;
+} doc;
+
+static void put(doc *d, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    while (1) {
+        va_start(ap, fmt);
+        n = vsnprintf(d->data + d->len, d->cap - d->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            fprintf(stderr, "corpus: formatting failed\n");
+            exit(1);
+        } else if (d->len + n < d->cap) {
+            d->len += n;
+            return;
+        }
+
+        d->cap = d->cap * 2 + n;
+        d->data = realloc(d->data, d->cap);
+        if (d->data == NULL) {
+            fprintf(stderr, "corpus: out of memory\n");
+            exit(1);
+        }
+    }
+}
+
+/* xorshift64*.  same doge every time */
+static uint64_t roll(doc *d) {
+    d->rng ^= d->rng >> 12;
+    d->rng ^= d->rng << 25;
+    d->rng ^= d->rng >> 27;
+    return d->rng * 2685821657736338717ULL;
+}
+
+static void put_text(doc *d, size_t len) {
+    static const char *pieces[] = {
+        "such", "wow", "doge", " ", "shibe", "\\n", "\\\"", "d\xc3\xb8g",
+        "\xe5\x9d\x8e", "amaze", "very", "\\/", "much", "\xf0\x90\x8d\x88",
+    };
+    size_t n = sizeof(pieces) / sizeof(*pieces);
+
+    put(d, "\"");
+    for (size_t i = 0; i < len; i++)
+        put(d, "%s", pieces[roll(d) % n]);
+    put(d, "\"");
+}
+
+static void put_number(doc *d) {
+    uint64_t r = roll(d);
+
+    switch (r % 5) {
+    case 0:
+        put(d, "%llo", (unsigned long long)(r >> 40));
+        break;
+    case 1:
+        put(d, "-%llo", (unsigned long long)(r >> 20));
+        break;
+    case 2:
+        put(d, "%o.%o", (unsigned)(r >> 50), (unsigned)(r >> 44) & 07777);
+        break;
+    case 3:
+        put(d, "%overy%s%o", (unsigned)(r >> 48), (r & 0100) ? "-" : "+",
+            (unsigned)(r >> 8) & 017);
+        break;
+    default:
+        put(d, "0");
+    }
+}
+
+static void gen_strings(doc *d, size_t target) {
+    put(d, "so ");
+    while (d->len < target) {
+        put(d, "such \"name\" is ");
+        put_text(d, 1 + roll(d) % 8);
+        put(d, ", \"note\" is ");
+        put_text(d, 4 + roll(d) % 40);
+        put(d, " wow and ");
+    }
+    put(d, "\"fin\" many");
+}
+
+static void gen_numbers(doc *d, size_t target) {
+    put(d, "so ");
+    while (d->len < target) {
+        put_number(d);
+        put(d, roll(d) % 2 ? " and " : " also ");
+    }
+    put(d, "0 many");
+}
+
+static void gen_nested(doc *d, size_t target) {
+    put(d, "so ");
+    while (d->len < target) {
+        size_t depth = 16 + roll(d) % 48;
+
+        for (size_t i = 0; i < depth; i++) {
+            if (i % 2)
+                put(d, "so ");
+            else
+                put(d, "such \"k%zu\" is ", i);
+        }
+        put(d, "yes ");
+        for (size_t i = depth; i > 0; i--)
+            put(d, (i - 1) % 2 ? "many " : "wow ");
+        put(d, "and ");
+    }
+    put(d, "empty many");
+}
+
+static void gen_wide(doc *d, size_t target) {
+    size_t i;
+
+    put(d, "such ");
+    for (i = 0; d->len < target; i++)
+        put(d, "\"key%06zu\" is %zo, ", i, i);
+    put(d, "\"last\" is empty wow");
+}
+
+static void gen_pretty(doc *d, size_t target) {
+    put(d, "so\n");
+    while (d->len < target) {
+        put(d, "    such\n        \"id\" is ");
+        put_number(d);
+        put(d, ",\n        \"tags\" is so\n");
+        for (size_t i = roll(d) % 4; i > 0; i--) {
+            put(d, "            ");
+            put_text(d, 2);
+            put(d, " and\n");
+        }
+        put(d, "            \"last\"\n        many,\n        \"ok\" is %s\n"
+            "    wow and\n", roll(d) % 2 ? "yes" : "no");
+    }
+    put(d, "    empty\nmany\n");
+}
+
+char *corpus_generate(const char *kind, size_t target, size_t *len_out) {
+    doc d = { 0 };
+
+    d.cap = target + 01000;
+    d.data = malloc(d.cap);
+    d.rng = 0x5eed5eed ^ target;
+    for (const char *p = kind; *p != '\0'; p++)
+        d.rng = d.rng * 31 + (unsigned char)*p;
+
+    if (!strcmp(kind, "strings"))
+        gen_strings(&d, target);
+    else if (!strcmp(kind, "numbers"))
+        gen_numbers(&d, target);
+    else if (!strcmp(kind, "nested"))
+        gen_nested(&d, target);
+    else if (!strcmp(kind, "wide"))
+        gen_wide(&d, target);
+    else if (!strcmp(kind, "pretty"))
+        gen_pretty(&d, target);
+    else {
+        free(d.data);
+        return NULL;
+    }
+
+    *len_out = d.len;
+    return d.data;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
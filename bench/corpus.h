@@ -0,0 +1,26 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_CORPUS_H
+#define _CDSON_CORPUS_H
+
+#include <stddef.h>
+
+/* Names of the document shapes corpus_generate() knows, NULL-terminated:
+ * string-heavy, number-heavy, deeply nested, wide dict, and pretty-printed. */
+extern const char *corpus_kinds[];
+
+/* Generate a DSON document of the given kind, roughly target bytes long.
+ * Output depends only on kind and target, so runs are comparable across
+ * builds and machines.  Returns a NUL-terminated string for free(), or NULL
+ * if kind is unknown. */
+char *corpus_generate(const char *kind, size_t target, size_t *len_out);
+
+#endif /* _CDSON_CORPUS_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -15,6 +15,34 @@ extern "C" {
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
+
+/* Memory hooks for dson_set_allocator().  alloc, resize, and release
+ * behave like malloc(), realloc(), and free(), and each receives ctx as its
+ * first argument.  alloc and resize return NULL on failure, which cdson
+ * reports as an error rather than aborting. */
+typedef struct dson_allocator {
+    void *(*alloc)(void *ctx, size_t size);
+    void *(*resize)(void *ctx, void *ptr, size_t size);
+    void (*release)(void *ctx, void *ptr);
+    void *ctx;
+} dson_allocator;
+
+/* Route every allocation cdson makes on behalf of trees, dumps, and key
+ * tables through a.  Pass NULL to go back to libc.  *a is copied.
+ *
+ * This is process-wide: install it before using the library, and do not
+ * change it while other threads are inside cdson or while anything the
+ * previous allocator produced is still alive.  Trees and buffers returned by
+ * cdson must then be released with dson_free() or a->release respectively,
+ * not free().  Error messages are the exception: they always come from libc,
+ * so keep passing them to free(). */
+void dson_set_allocator(const dson_allocator *a);
+
+/* The error message returned when libc has no memory left even for the
+ * message.  It is static: compare against it, and never pass it to free().
+ * Every other error message is freed as documented. */
+extern char dson_out_of_memory[];
 
 /* Types of basic objects. */
 #define DSON_NONE 0
@@ -23,25 +51,69 @@ extern "C" {
 #define DSON_STRING 3
 #define DSON_ARRAY 4
 #define DSON_DICT 5
+#define DSON_NUMBER 6 /* as written; see lazy_numbers */
+#define DSON_INT 7 /* int64_t; see integers */
+#define DSON_UINT 8 /* uint64_t, for those past INT64_MAX */
 typedef uint8_t dson_type; /* Can take only the above values. */
 
+/* Deepest nesting of arrays and dicts that parsing, dumping, and the binary
+ * format accept.  Anything deeper is an error rather than a blown stack. */
+#define DSON_MAX_DEPTH 02000
+
+/* Table of interned dict keys.  See dson_parse_with(). */
+typedef struct dson_intern dson_intern;
+
+/* Compiled schema.  See dson_schema_compile(). */
+typedef struct dson_schema dson_schema;
+
 /* Dictionary type.  Arrays are NULL-terminated.  dson_dicts created by
- * dson_parse() will be valid, \0-terminated UTF-8. */
+ * dson_parse() will be valid, \0-terminated UTF-8.
+ *
+ * If intern is non-NULL, keys are owned by that table rather than by the
+ * dict, and equal keys are the same pointer.  Leave it NULL when building
+ * dicts by hand. */
 typedef struct dson_dict {
     char **keys;
     struct dson_value **values;
+    dson_intern *intern;
 } dson_dict;
 
-/* A parsed tree. */
+/* A parsed tree.
+ *
+ * length is bookkeeping for the parser and the builder functions below: the
+ * number of elements in an array or entries in a dict, or the bytes in a
+ * string.  0 means "unknown; count them".  Leave it 0 when building or
+ * changing values by hand, and set it back to 0 after changing by hand a
+ * value the library made: a stale count can put a pushed element past the
+ * end readers see.  A DSON_NUMBER is the exception: there, length is always
+ * the size of its text.
+ *
+ * shares counts owners beyond the first; see dson_clone().  Leave it 0.
+ *
+ * spanned marks containers that remember where they were in the input; see
+ * dson_reparse().  Leave it false.
+ *
+ * clean marks a string, or all of a dict's keys, that the parser already
+ * found to be valid UTF-8 with no control characters, so dumping skips
+ * decoding it.  Quotes, backslashes and control bytes are escaped either
+ * way, so a string changed by hand cannot break the output; set clean back
+ * to false after such a change so its UTF-8 is checked too. */
 typedef struct dson_value {
     dson_type type;
+    bool spanned;
+    bool clean;
+    uint32_t shares;
     union {
         bool b;
         double n;
+        int64_t i;
+        uint64_t u;
         char *s; /* string - valid, \0-terminated UTF-8. */
+        const char *raw; /* number - length bytes of input, not owned */
         struct dson_value **array;
         dson_dict *dict;
     };
+    size_t length;
 } dson_value;
 
 /* Parse DSON from a NUL-terminated UTF-8 stream.  length does not include the
@@ -57,6 +129,215 @@ typedef struct dson_value {
 char *dson_parse(const char *input, size_t length, bool unsafe,
                  dson_value **out);
 
+/* Counters for one call, filled in when requested through parse or dump
+ * options.  Collecting them costs a clock read at either end of the call and
+ * an increment per node and per allocation, so they can be left on.
+ *
+ * bytes: input consumed by a parse, or output produced by a dump.
+ * nodes: values created or written.
+ * allocs, alloc_bytes: allocations and resizes made through the allocator
+ *     (see dson_set_allocator()), and the bytes they asked for.  Error
+ *     messages are not counted.
+ * max_depth: deepest nesting of arrays and dicts; 0 for a lone scalar.
+ * ns: wall time spent in the call, as one total.  It is not broken down
+ *     within a call: time each phase (parse, your own conversion, dump) by
+ *     collecting stats from its call separately.  dson_to_json() and
+ *     json_to_dson() read and write in one pass, so theirs covers both. */
+typedef struct dson_stats {
+    uint64_t bytes;
+    uint64_t nodes;
+    uint64_t allocs;
+    uint64_t alloc_bytes;
+    uint64_t max_depth;
+    uint64_t ns;
+} dson_stats;
+
+/* Fold s into *total: every counter is summed except max_depth, which keeps
+ * the larger.  Atomic with respect to other dson_stats_add() calls on the
+ * same total, so threads can each collect their own and share one total
+ * without a lock. */
+void dson_stats_add(dson_stats *total, const dson_stats *s);
+
+/* Knobs for dson_parse_with().  Zero-initialize, then set what you need;
+ * all-zero gives the same behavior as dson_parse() with unsafe=false.
+ *
+ * unsafe: as for dson_parse().
+ *
+ * intern_keys: store each distinct dict key only once per tree.  Equal keys
+ * become the same pointer, and dson_fetch() compares them as such.
+ *
+ * intern: store keys in this caller-owned table instead, sharing them across
+ * every tree parsed with it (implies intern_keys).  The table is reference
+ * counted: dson_intern_free() may be called while trees still use it, and
+ * storage is released once the last of them is freed.  A table must not be
+ * used by more than one parse at a time.
+ *
+ * stats: if non-NULL, overwritten with counters for each call (for an
+ * iterator, each dson_iter_next()).
+ *
+ * lazy_numbers: leave numbers unconverted, as DSON_NUMBER values pointing at
+ * their text in input, until read with dson_get_double() or
+ * dson_get_int64().  dson_dump() copies them out as written.  input must
+ * outlive the tree.  Ignored by dson_iter_new(), whose buffer moves.
+ *
+ * integers: read numbers written without a fraction or "very" as DSON_INT,
+ * or as DSON_UINT if too large for that but not for a uint64_t, instead of
+ * as doubles.  Larger ones are read as if this were unset.  Takes precedence
+ * over lazy_numbers for the numbers it covers.
+ *
+ * spans: record, for each array and dict, where it starts in input and how
+ * many bytes it covers.  Each such container grows by two size_ts, counted
+ * in dson_tree_stats() node_bytes; scalars are unchanged.  Required by
+ * dson_reparse(), which uses them to find what an edit touched.
+ *
+ * schema: check each document against this as it is parsed, failing at the
+ * first value that breaks it without reading any further.  For an iterator,
+ * each element is checked as it is read, and the container as a whole at its
+ * end.  Not for dson_reparse(). */
+typedef struct dson_parse_options {
+    bool unsafe;
+    bool intern_keys;
+    dson_intern *intern;
+    dson_stats *stats;
+    bool lazy_numbers;
+    bool integers;
+    bool spans;
+    dson_schema *schema;
+} dson_parse_options;
+
+/* dson_parse(), but with options.  opts may be NULL for defaults. */
+char *dson_parse_with(const char *input, size_t length,
+                      const dson_parse_options *opts, dson_value **out);
+
+/* Parse the first of several back-to-back documents in input, which must be
+ * NUL-terminated at input[length] as for dson_parse().  Whitespace around
+ * documents is skipped.  On success, *consumed is the number of bytes
+ * through the end of the document (and any whitespace after it), so the next
+ * call can start at input + *consumed.  If only whitespace remains, *out is
+ * NULL and success is returned.  Returns NULL on success or an error message
+ * on failure.  Pass error message to free(). */
+char *dson_parse_next(const char *input, size_t length,
+                      const dson_parse_options *opts, size_t *consumed,
+                      dson_value **out);
+
+/* Parse up to max_docs (0 for no limit) back-to-back documents from input in
+ * a single pass, collecting them into a DSON_ARRAY in *out.  Key tables and
+ * other parser state are shared across the whole batch, and error positions
+ * are relative to input.  *consumed is as for dson_parse_next().  On error,
+ * nothing is returned.  Returns NULL on success or an error message on
+ * failure.  Pass error message to free(). */
+char *dson_parse_batch(const char *input, size_t length,
+                       const dson_parse_options *opts, size_t max_docs,
+                       size_t *consumed, dson_value **out);
+
+/* A change to a document's text: removed bytes starting at start were
+ * replaced by inserted others. */
+typedef struct dson_edit {
+    size_t start;
+    size_t removed;
+    size_t inserted;
+} dson_edit;
+
+/* Bring *tree, parsed with spans from some input, up to date with input,
+ * which is that text after edit.  Only the innermost container enclosing
+ * the edit is parsed again and spliced in place, so the cost follows the
+ * size of that container rather than of the document.  Where that can't
+ * be done (the edit reaches the edges of the outermost value, or the
+ * container no longer parses on its own), as much more as needed is parsed
+ * again, up to all of input.
+ *
+ * opts are those of the original parse and must ask for spans; stats, if
+ * requested, cover the last parse made.  lazy_numbers is refused, since
+ * those numbers point into the old text.  The tree must not have been
+ * changed since parsing other than by dson_reparse(); containers shared
+ * through dson_clone() are replaced rather than changed.  On failure, *tree
+ * is unchanged.  Returns NULL on success or an error message on failure.
+ * Pass error message to free(). */
+char *dson_reparse(dson_value **tree, const char *input, size_t length,
+                   const dson_edit *edit, const dson_parse_options *opts);
+
+/* Iterate over the elements of a top-level array (or the entries of a
+ * top-level dict) read from f, handing out each as its own tree.  Only a
+ * window of the input large enough for the current element is kept in
+ * memory, so arbitrarily long exports can be processed in memory proportional
+ * to their largest element.  opts may be NULL; keys are interned across
+ * elements if requested. */
+typedef struct dson_iter dson_iter;
+
+/* Start iterating over f, which the caller retains ownership of.  Nothing is
+ * read until the first dson_iter_next().  Returns NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+char *dson_iter_new(FILE *f, const dson_parse_options *opts,
+                    dson_iter **out);
+
+/* Parse the next element into *v_out, which the caller frees with
+ * dson_free().  For a top-level dict, *key_out receives the entry's key if
+ * key_out is non-NULL; release it as for dson_dump() output.  At the end of
+ * the container, *v_out is NULL and success is returned; anything after the
+ * container is ignored.  Returns NULL on success or an error message on
+ * failure, after which the iterator can only be freed.  Pass error message to
+ * free(). */
+char *dson_iter_next(dson_iter *it, char **key_out, dson_value **v_out);
+
+/* Free and NULL an iterator. */
+void dson_iter_free(dson_iter **it);
+
+/* Read a document one token at a time, without building a tree, to fill your
+ * own structures straight from the input.  tools/cdson-gen.c generates such
+ * code from a schema.
+ *
+ * Tokens come in document order: a VALUE for anything but an array or dict;
+ * ARRAY, then each element, then END; DICT, then KEY and value for each
+ * entry, then END.  DONE follows the document, and anything after it is
+ * ignored.  String values and keys are in value.s, and belong to the caller:
+ * release them as for dson_dump() output.  Of the parse options, only
+ * unsafe, lazy_numbers and integers apply; input must outlive lazy numbers
+ * as it would a tree. */
+#define DSON_TOKEN_DONE 0
+#define DSON_TOKEN_VALUE 1
+#define DSON_TOKEN_ARRAY 2 /* so */
+#define DSON_TOKEN_DICT 3 /* such */
+#define DSON_TOKEN_KEY 4
+#define DSON_TOKEN_END 5 /* many / wow */
+typedef struct dson_token {
+    uint8_t kind;
+    dson_value value; /* for VALUE and KEY */
+} dson_token;
+
+typedef struct dson_reader dson_reader;
+
+/* Start reading input, which must be NUL-terminated at input[length] as for
+ * dson_parse() and outlive the reader.  opts may be NULL.  Returns NULL on
+ * success or an error message on failure.  Pass error message to free(). */
+char *dson_reader_new(const char *input, size_t length,
+                      const dson_parse_options *opts, dson_reader **out);
+
+/* The next token, into *tok.  Returns NULL on success or an error message on
+ * failure, after which the reader can only be freed.  Pass error message to
+ * free(). */
+char *dson_reader_next(dson_reader *r, dson_token *tok);
+
+/* Read past the value after a KEY (or the whole document, before the first
+ * token), however deeply nested.  Returns NULL on success or an error message
+ * on failure.  Pass error message to free(). */
+char *dson_reader_skip(dson_reader *r);
+
+/* Free and NULL a reader. */
+void dson_reader_free(dson_reader **r);
+
+/* Create a key table for dson_parse_options.intern. */
+dson_intern *dson_intern_new(void);
+
+/* Drop the caller's reference to a key table and NULL it. */
+void dson_intern_free(dson_intern **tab);
+
+/* The table's copy of the len bytes at key, or NULL if it has none.  Dicts
+ * using tab (see dson_dict.intern) hold that very pointer, so matching keys
+ * after this is a pointer comparison.  hash must be the 32-bit FNV-1a of
+ * those bytes, which callers with fixed keys can work out ahead of time. */
+const char *dson_intern_lookup(dson_intern *tab, const char *key, size_t len,
+                               uint32_t hash);
+
 /* Retrieve a specific value from the parsed DSON tree.  This is a shortcut
  * method for traversing the tree by hand.  v_out is owned by tree; do not
  * free() v_out.  Returns NULL on success or an error message on failure.
@@ -80,15 +361,379 @@ char *dson_parse(const char *input, size_t length, bool unsafe,
 char *dson_fetch(dson_value *tree, const char *query, uint8_t match_behavior,
                  dson_value **v_out);
 
+/* Every value query matches, found in one walk of tree.  On top of
+ * dson_fetch()'s syntax, a step may be:
+ *
+ *   [*]    every element of an array
+ *   [a:b]  elements a up to but not including b; either may be left out
+ *   .*     every value of a dict
+ *   ..key  key in this dict or any below it, at any depth; "..*" is every
+ *          value below
+ *
+ * so ".users[*].name" names every user, and "..id" every id anywhere.
+ * Steps that don't fit the value they reach (an index past the end, a key
+ * that isn't there, a key step on an array) match nothing rather than
+ * failing.  match_behavior applies to each exact key step, as for
+ * dson_fetch().  Matches come in document order, so one inside another
+ * comes after it.
+ *
+ * dson_query() collects them into a new DSON_ARRAY in *results_out.  Its
+ * elements are shared with tree, as if by dson_clone(), so they outlive it;
+ * dson_free() releases them.  dson_query_each() instead calls fn for each,
+ * stopping early if fn returns false.  Both return NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+typedef bool (*dson_match_fn)(void *ctx, dson_value *v);
+char *dson_query(dson_value *tree, const char *query, uint8_t match_behavior,
+                 dson_value **results_out);
+char *dson_query_each(dson_value *tree, const char *query,
+                      uint8_t match_behavior, dson_match_fn fn, void *ctx);
+
+/* Walk a tree without recursion.  A cursor sits on one value at a time,
+ * starting at the root, and keeps the containers above it on a stack of its
+ * own, so moving never allocates, fails for memory, or uses the C stack.  A
+ * whole tree, in document order:
+ *
+ *     do {
+ *         visit(dson_cursor_value(cur));
+ *         if (dson_cursor_enter(cur))
+ *             continue;
+ *         while (!dson_cursor_next(cur))
+ *             if (!dson_cursor_leave(cur))
+ *                 goto done;
+ *     } while (true);
+ *
+ * Values may be changed in place, but containers the cursor is inside must
+ * not gain or lose elements while it is. */
+typedef struct dson_cursor dson_cursor;
+
+/* Start at tree, which the caller retains ownership of.  Returns NULL on
+ * success or an error message on failure.  Pass error message to free(). */
+char *dson_cursor_new(dson_value *tree, dson_cursor **out);
+
+/* Free and NULL a cursor. */
+void dson_cursor_free(dson_cursor **cur);
+
+/* Move to the first element or entry of the current value.  false, without
+ * moving, if it isn't an array or dict, is empty, or is already
+ * DSON_MAX_DEPTH deep. */
+bool dson_cursor_enter(dson_cursor *cur);
+
+/* Move to the next element or entry of the container we're in.  false,
+ * without moving, at the last one or at the root. */
+bool dson_cursor_next(dson_cursor *cur);
+
+/* Move back to the container we're in.  false at the root. */
+bool dson_cursor_leave(dson_cursor *cur);
+
+/* The current value, and where it is: its dict key (NULL in an array or at
+ * the root), position in its container, and number of containers above
+ * it. */
+dson_value *dson_cursor_value(const dson_cursor *cur);
+const char *dson_cursor_key(const dson_cursor *cur);
+size_t dson_cursor_index(const dson_cursor *cur);
+size_t dson_cursor_depth(const dson_cursor *cur);
+
+/* The way from the root to here, as a dson_fetch() query such as
+ * ".users[3].name" (or "" at the root; keys containing "[]." can't be
+ * fetched back).  As for snprintf(): at most size bytes of it are written
+ * to buf, including a terminating '\0', and its full length is returned. */
+size_t dson_cursor_path(const dson_cursor *cur, char *buf, size_t size);
+
+/* The value of any number: DSON_DOUBLE, DSON_NUMBER, DSON_INT, or
+ * DSON_UINT.  Converting a DSON_NUMBER reads its text again each call, and
+ * is exact whenever the result is a normal double.  Returns NULL on success
+ * or an error message on failure.  Pass error message to free(). */
+char *dson_get_double(const dson_value *v, double *out);
+
+/* As dson_get_double(), but only for a number that is exactly an integer in
+ * range.  Unlike a double, a DSON_NUMBER holds integers beyond 2 ** 53 without
+ * loss. */
+char *dson_get_int64(const dson_value *v, int64_t *out);
+char *dson_get_uint64(const dson_value *v, uint64_t *out);
+
+/* dson_fetch() followed by the matching dson_get_*(), for when only the
+ * number is wanted. */
+char *dson_fetch_double(dson_value *tree, const char *query,
+                        uint8_t match_behavior, double *out);
+char *dson_fetch_int64(dson_value *tree, const char *query,
+                       uint8_t match_behavior, int64_t *out);
+char *dson_fetch_uint64(dson_value *tree, const char *query,
+                        uint8_t match_behavior, uint64_t *out);
+
 /* Serialize a DSON object into a UTF-8 bytestream.  All strings must be valid
- * UTF-8.  Pass the returned string to free() to release allocated storage.
+ * UTF-8; those marked clean are escaped without decoding again.  Pass the
+ * returned string to free() (or your allocator's release; see
+ * dson_set_allocator()) to release allocated storage.
  * Returns NULL on success, or an error message on failure.  Pass error
  * message to free(). */
 char *dson_dump(dson_value *in, char **out, size_t *len_out);
 
-/* Recursively free and NULL a DSON object. */
+/* Knobs for dson_dump_with().  Zero-initialize, then set what you need.
+ *
+ * stats: as for dson_parse_options.
+ *
+ * compact: fewest bytes the spec allows.  Whitespace only where two words
+ * (keywords or numbers) would otherwise touch, '/' left unescaped, and
+ * numbers in "very" form (digits times a power of 010) when that is
+ * shorter and parses back to exactly the same value. */
+typedef struct dson_dump_options {
+    dson_stats *stats;
+    bool compact;
+} dson_dump_options;
+
+/* dson_dump(), but with options.  opts may be NULL for defaults. */
+char *dson_dump_with(dson_value *in, const dson_dump_options *opts,
+                     char **out, size_t *len_out);
+
+/* Serialize straight from your own data, without building a tree.  Calls
+ * produce exactly what dson_dump() would for the equivalent tree: separators
+ * are inserted as needed, and every begin needs a matching
+ * dson_writer_end().  In a dict, each value is preceded by its
+ * dson_writer_key().
+ *
+ * All of these return NULL on success or an error message on failure.  Pass
+ * error message to free().  Calls out of order (a value without its key, a
+ * second top-level value, too many ends, and so on) fail without writing
+ * anything, and the writer can still be used.  Any other failure, such as
+ * invalid UTF-8 or running out of memory, leaves the writer fit only for
+ * dson_writer_free(). */
+typedef struct dson_writer dson_writer;
+
+/* Start a document.  opts may be NULL; stats, if requested, cover
+ * everything from here to dson_writer_finish(). */
+char *dson_writer_new(const dson_dump_options *opts, dson_writer **out);
+
+char *dson_writer_begin_dict(dson_writer *w);
+char *dson_writer_begin_array(dson_writer *w);
+char *dson_writer_end(dson_writer *w);
+char *dson_writer_key(dson_writer *w, const char *key);
+char *dson_writer_none(dson_writer *w);
+char *dson_writer_bool(dson_writer *w, bool b);
+char *dson_writer_double(dson_writer *w, double n);
+char *dson_writer_int(dson_writer *w, int64_t n);
+char *dson_writer_uint(dson_writer *w, uint64_t n);
+char *dson_writer_string(dson_writer *w, const char *s);
+
+/* Hand over the finished document, which must be a single complete value.
+ * Release *out as for dson_dump().  The writer can then only be freed. */
+char *dson_writer_finish(dson_writer *w, char **out, size_t *len_out);
+
+/* Free and NULL a writer, along with anything it hasn't handed over. */
+void dson_writer_free(dson_writer **w);
+
+/* Rewrite a document straight into the other format, one token at a time,
+ * without building a tree: memory is the output plus a little per level of
+ * nesting.  input must be NUL-terminated at input[length] as for
+ * dson_parse().  Release *out as for dson_dump().  Both return NULL on
+ * success or an error message on failure.  Pass error message to free().
+ * stats, if requested, count output bytes and values written.
+ *
+ * dson_to_json() reads what a dson_reader would, and of the parse options
+ * only unsafe and stats apply.  Output is compact JSON.  Integers whose
+ * magnitude fits 64 bits are written exactly; other numbers as the shortest
+ * decimal that reads back as the same double, and numbers too large for a
+ * double are refused.
+ *
+ * json_to_dson() reads strict JSON (RFC 8259) and writes it with
+ * dson_dump_with()'s spacing and escaping.  \u0000 and unpaired surrogates
+ * are refused.  Integers whose magnitude fits 64 bits are written exactly,
+ * digit for digit, as dumping a DSON_INT or DSON_UINT would, but including
+ * negatives down to -(2**64 - 1).  A tree holding them as doubles would
+ * dump them rounded once past 2**53.  Other numbers are written as dumping
+ * their nearest double would.  Decimals that can't be converted exactly by
+ * a single multiply or divide go through strtod(), so the C locale's
+ * decimal point is expected. */
+char *dson_to_json(const char *input, size_t length,
+                   const dson_parse_options *opts, char **out,
+                   size_t *len_out);
+char *json_to_dson(const char *input, size_t length,
+                   const dson_dump_options *opts, char **out,
+                   size_t *len_out);
+
+/* Memory held by a tree, in bytes requested from the allocator.  Allocator
+ * overhead is not included, and neither are interned keys, which belong to
+ * their table.
+ *
+ * nodes: number of values.
+ * node_bytes: value and dict headers, and spans (see dson_parse_options).
+ * string_bytes: string values, with terminators.
+ * key_bytes: dict keys, with terminators.
+ * pointer_bytes: array elements and dict key and value lists, with
+ *     terminators but not any room left over from growing them.
+ * max_depth: as for dson_stats. */
+typedef struct dson_footprint {
+    size_t nodes;
+    size_t node_bytes;
+    size_t string_bytes;
+    size_t key_bytes;
+    size_t pointer_bytes;
+    size_t max_depth;
+} dson_footprint;
+
+/* Measure what tree costs to keep around.  Returns NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+char *dson_tree_stats(const dson_value *tree, dson_footprint *out);
+
+/* Serialize a DSON object into cdson's relocatable binary format.  The
+ * result contains no pointers, so it can be written to a file and later
+ * mmap()ed or placed in shared memory, then read in place with
+ * dson_fetch_binary() or turned back into a tree with dson_load_binary().
+ * All strings must be valid UTF-8.  Release *out as for dson_dump().
+ * Returns NULL on success, or an error message on failure.  Pass error
+ * message to free().
+ *
+ * The format is little-endian and versioned; it is meant for caches and
+ * interchange between processes, not as a substitute for DSON itself.  A
+ * tree holding DSON_INT or DSON_UINT values is written as version 2, which
+ * cdson 1 cannot read; anything else stays version 1. */
+char *dson_dump_binary(dson_value *in, void **out, size_t *len_out);
+
+/* Rebuild a tree from the output of dson_dump_binary().  data is not
+ * trusted: every offset is bounds-checked and strings are revalidated.
+ * Returns NULL on success or an error message on failure.  Pass error
+ * message to free(). */
+char *dson_load_binary(const void *data, size_t len, dson_value **out);
+
+/* dson_fetch(), but directly against the output of dson_dump_binary(),
+ * without loading the rest of it.  Wide dicts carry a hash index, so lookups
+ * need not scan.  Unlike dson_fetch(), *v_out is a fresh copy of the matching
+ * subtree: pass it to dson_free() when done.  Returns NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+char *dson_fetch_binary(const void *data, size_t len, const char *query,
+                        uint8_t match_behavior, dson_value **v_out);
+
+/* Build trees without managing the arrays by hand.  Everything made here
+ * can be dumped, fetched from, and freed with dson_free() like a parsed
+ * tree, and parsed trees can be extended the same way.  Appends grow storage
+ * geometrically, so building n elements costs O(n).
+ *
+ * Each returns NULL on success or an error message on failure.  Pass error
+ * message to free(). */
+char *dson_new_none(dson_value **out);
+char *dson_new_bool(bool b, dson_value **out);
+char *dson_new_double(double n, dson_value **out);
+char *dson_new_int(int64_t n, dson_value **out);
+
+/* Makes a DSON_INT if n fits in one, as the parser would. */
+char *dson_new_uint(uint64_t n, dson_value **out);
+char *dson_new_array(dson_value **out);
+char *dson_new_dict(dson_value **out);
+
+/* Copy the first len bytes of s (or all of it, for dson_new_string()) into
+ * a new string value.  s must be valid UTF-8 without NULs. */
+char *dson_new_string(const char *s, dson_value **out);
+char *dson_new_string_n(const char *s, size_t len, dson_value **out);
+
+/* Make a string value that takes over s, which must be NUL-terminated and
+ * allocated as dson_free() will release it (see dson_set_allocator()).  On
+ * failure, s still belongs to the caller. */
+char *dson_new_string_owned(char *s, dson_value **out);
+
+/* Append v to an array.  On success, array owns v; on failure, the caller
+ * still does. */
+char *dson_array_push(dson_value *array, dson_value *v);
+
+/* Append an entry to a dict.  Existing entries with the same key are kept,
+ * as when parsing; dson_fetch()'s match_behavior picks between them.  The
+ * key is copied (or, for dicts with an intern table, interned).  On success,
+ * dict owns v; on failure, the caller still does. */
+char *dson_dict_put(dson_value *dict, const char *key, dson_value *v);
+
+/* dson_dict_put(), taking over key as dson_new_string_owned() does.  On
+ * failure, the caller still owns both key and v. */
+char *dson_dict_put_owned(dson_value *dict, char *key, dson_value *v);
+
+/* Take another reference to tree in O(1): *out is tree itself, now with
+ * one more owner.  Shared values are immutable.  Change them only through
+ * dson_set() and dson_remove(), which copy just the containers on the path
+ * they change and leave every other subtree shared.  That includes
+ * everything reachable from a shared value, not only the value itself.
+ * Owners may be on different threads; references are counted atomically.
+ * Returns NULL on success or an error message on failure.  Pass error
+ * message to free(). */
+char *dson_clone(dson_value *tree, dson_value **out);
+
+/* Replace the value query (as for dson_fetch()) names in *root with v, or
+ * add it if the last step names a dict key that isn't there or the index
+ * just past the end of an array.  Containers on the way that are shared are
+ * copied first, so other owners don't see the change, and *root may become a
+ * new value.  An empty query replaces the whole tree.  The old value is freed
+ * as by dson_free().  On success, the tree owns v; on failure, the caller
+ * still does.  Returns NULL on success or an error message on failure.  Pass
+ * error message to free(). */
+char *dson_set(dson_value **root, const char *query, uint8_t match_behavior,
+               dson_value *v);
+
+/* Remove the array element or dict entry query names, copying shared
+ * containers on the way as dson_set() does.  Returns NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+char *dson_remove(dson_value **root, const char *query,
+                  uint8_t match_behavior);
+
+/* Compute a patch that dson_patch() turns from into to.  The patch is an
+ * ordinary tree, so it dumps and parses like any other: an array of steps,
+ * each an array holding a query (as for dson_fetch()) and either the value
+ * to dson_set() there or nothing, meaning dson_remove() it.  Values in the
+ * patch are clones (see dson_clone()) of subtrees of to, and subtrees the two
+ * trees share are skipped without looking inside, so diffing a tree against
+ * an edited clone of itself costs only the containers the edits touched.
+ *
+ * Dict keys are matched by name, and reordering them alone is not a change.
+ * Array elements are matched by position, so an insertion rewrites
+ * everything after it.  A dict with duplicate keys, or with keys the query
+ * syntax can't spell (containing '.', '[' or ']'), is replaced whole if it
+ * changed.  Returns NULL on success or an error message on failure.  Pass
+ * error message to free(). */
+char *dson_diff(dson_value *from, dson_value *to, dson_value **patch_out);
+
+/* Apply a patch from dson_diff() to *tree, step by step, matching keys with
+ * DSON_MATCH_ERROR.  Each step costs what its dson_set() or dson_remove()
+ * does.  Either every step applies or *tree is left as it was.  *tree may
+ * become a new value, as with dson_set(), and shares the values it gains
+ * with patch, which is otherwise unchanged.  Returns NULL on success or an
+ * error message on failure.  Pass error message to free(). */
+char *dson_patch(dson_value **tree, dson_value *patch);
+
+/* Compile a schema, itself a tree, for checking documents against.  Each
+ * value the schema describes is described by a dict of constraints, all
+ * optional, or by empty for anything at all:
+ *
+ * "type": "none", "bool", "number", "integer", "string", "array" or "dict",
+ * or an array of several of those.  Integers are numbers with nothing after
+ * the point, however they were written.
+ * "min", "max": bounds on numbers, inclusive.
+ * "min_length", "max_length": bounds on strings, in bytes.
+ * "min_items", "max_items": bounds on the length of arrays.
+ * "items": schema for each array element.
+ * "keys": dict of schemas for the values under those keys.
+ * "required": array of keys that must be present.
+ * "closed": yes to refuse keys not named in "keys" or "required".
+ *
+ * Constraints that don't apply to a value's type are ignored, so
+ * such "min_length" is 1 wow accepts any number.  Returns NULL on success or
+ * an error message on failure.  Pass error message to free(). */
+char *dson_schema_compile(dson_value *schema_tree, dson_schema **out);
+
+/* Check tree against schema in a single pass, stopping at the first value
+ * that breaks it, whose query (as for dson_fetch()) leads the error message.
+ * Subtrees the schema says nothing about are not visited.  Checking only
+ * reads the schema, so any number of checks and parses, on any threads, may
+ * share one.  Returns NULL if tree passes or an error message otherwise.
+ * Pass error message to free(). */
+char *dson_schema_validate(dson_value *tree, dson_schema *schema);
+
+/* Free and NULL a compiled schema. */
+void dson_schema_free(dson_schema **s);
+
+/* Drop a reference to a DSON object and NULL it.  Once nothing else owns it
+ * (see dson_clone()), free it recursively. */
 void dson_free(dson_value **v);
 
+/* Release anything else cdson handed over from its allocator (dump output,
+ * keys from dson_iter_next(), strings in reader tokens) through whichever
+ * allocator is installed; see dson_set_allocator().  NULL is ignored. */
+void dson_free_buffer(void *p);
+
 #ifdef __cplusplus
 #if 0
 {
@@ -0,0 +1,799 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* C++17 face for cdson.h.  Header only, and thin: a document owns a tree, a
+ * value is a pointer into one, and arrays, dicts, and strings are views of
+ * the tree's own storage.  Nothing here copies or allocates beyond what the
+ * C calls underneath do, except to word an error of its own.
+ *
+ * Calls that can fail return a dson::result<T>, which holds either a T or a
+ * dson::error, after std::expected.  The error owns the C message and frees
+ * it.
+ *
+ * From C++20, dson::path and dson::get() also take queries checked at
+ * compile time. */
+
+#ifndef _CDSON_HPP
+#define _CDSON_HPP
+
+#include "cdson.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#ifdef __cpp_exceptions
+#include <exception>
+#endif
+
+/* such future.  paths need class types as template arguments */
+#if __cplusplus >= 202002L && defined(__cpp_nontype_template_args) && \
+    __cpp_nontype_template_args >= 201911L
+#define CDSON_HPP_PATHS 1
+#include <array>
+#include <cstdio>
+#endif
+
+namespace dson {
+
+/* An error message from cdson, released with it. */
+class error {
+public:
+    /* Takes ownership of message, which came from libc (as all cdson error
+     * messages do) unless it is the static dson_out_of_memory. */
+    explicit error(char *message) noexcept : message_(message) {}
+
+    error(error &&other) noexcept
+        : message_(std::exchange(other.message_, nullptr)) {}
+    error &operator=(error &&other) noexcept {
+        std::swap(message_, other.message_);
+        return *this;
+    }
+    error(const error &) = delete;
+    error &operator=(const error &) = delete;
+    ~error() {
+        if (message_ != dson_out_of_memory)
+            std::free(message_);
+    }
+
+    /* NUL-terminated. */
+    const char *what() const noexcept {
+        return message_ != nullptr ? message_ : "out of memory";
+    }
+    std::string_view message() const noexcept { return what(); }
+
+    /* One of our own, worded as the library would.  Only failure pays. */
+    static error make(const char *message) noexcept {
+        size_t len = std::strlen(message) + 01;
+        char *copy = static_cast<char *>(std::malloc(len));
+
+        if (copy != nullptr)
+            std::memcpy(copy, message, len);
+        return error(copy);
+    }
+
+private:
+    char *message_;
+};
+
+#ifdef __cpp_exceptions
+/* Thrown by result::value() when there is none. */
+class bad_result_access : public std::exception {
+public:
+    explicit bad_result_access(dson::error e) noexcept
+        : error_(std::move(e)) {}
+    const char *what() const noexcept override { return error_.what(); }
+    const dson::error &error() const noexcept { return error_; }
+
+private:
+    dson::error error_;
+};
+#endif
+
+/* A T, or the error that stopped one being made. */
+template <typename T>
+class [[nodiscard]] result {
+public:
+    result(T v) noexcept(std::is_nothrow_move_constructible_v<T>)
+        : v_(std::in_place_index<00>, std::move(v)) {}
+    result(dson::error e) noexcept
+        : v_(std::in_place_index<01>, std::move(e)) {}
+
+    bool has_value() const noexcept { return v_.index() == 00; }
+    explicit operator bool() const noexcept { return has_value(); }
+
+    /* Unchecked, as for std::expected. */
+    T &operator*() & noexcept { return *std::get_if<00>(&v_); }
+    const T &operator*() const & noexcept { return *std::get_if<00>(&v_); }
+    T &&operator*() && noexcept { return std::move(*std::get_if<00>(&v_)); }
+    T *operator->() noexcept { return std::get_if<00>(&v_); }
+    const T *operator->() const noexcept { return std::get_if<00>(&v_); }
+
+    /* Checked: without a value, throws bad_result_access carrying the
+     * error, or aborts if exceptions are off. */
+    T &value() & {
+        check();
+        return **this;
+    }
+    const T &value() const & {
+        check();
+        return **this;
+    }
+    T &&value() && {
+        check();
+        return std::move(**this);
+    }
+
+    template <typename U>
+    T value_or(U &&fallback) const & {
+        return has_value() ? **this
+                           : static_cast<T>(std::forward<U>(fallback));
+    }
+    template <typename U>
+    T value_or(U &&fallback) && {
+        return has_value() ? std::move(**this)
+                           : static_cast<T>(std::forward<U>(fallback));
+    }
+
+    /* Only when !has_value(). */
+    dson::error &error() & noexcept { return *std::get_if<01>(&v_); }
+    const dson::error &error() const & noexcept {
+        return *std::get_if<01>(&v_);
+    }
+    dson::error &&error() && noexcept {
+        return std::move(*std::get_if<01>(&v_));
+    }
+
+private:
+    void check() const {
+        if (has_value())
+            return;
+#ifdef __cpp_exceptions
+        throw bad_result_access(dson::error::make(error().what()));
+#else
+        std::abort();
+#endif
+    }
+
+    std::variant<T, dson::error> v_;
+};
+
+/* Turn a C call's error string, if any, into a result.  such bridge */
+template <typename T>
+inline result<T> make_result(char *err, T v) {
+    if (err != nullptr)
+        return error(err);
+    return v;
+}
+
+/* Output of a dump, released through cdson's allocator. */
+class text {
+public:
+    text() noexcept = default;
+    text(char *data, size_t size) noexcept : data_(data), size_(size) {}
+
+    text(text &&other) noexcept
+        : data_(std::exchange(other.data_, nullptr)),
+          size_(std::exchange(other.size_, 00)) {}
+    text &operator=(text &&other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    text(const text &) = delete;
+    text &operator=(const text &) = delete;
+    ~text() { dson_free_buffer(data_); }
+
+    /* NUL-terminated. */
+    const char *c_str() const noexcept {
+        return data_ != nullptr ? data_ : "";
+    }
+    const char *data() const noexcept { return c_str(); }
+    size_t size() const noexcept { return size_; }
+    std::string_view view() const noexcept { return { c_str(), size_ }; }
+    operator std::string_view() const noexcept { return view(); }
+
+    /* Hand it back to C.  Release with dson_free_buffer(). */
+    char *release() noexcept {
+        size_ = 00;
+        return std::exchange(data_, nullptr);
+    }
+
+private:
+    char *data_ = nullptr;
+    size_t size_ = 00;
+};
+
+class array;
+class dict;
+
+/* A value inside someone else's tree.  Copy freely; it is one pointer, and
+ * lives only as long as the tree does. */
+class value {
+public:
+    value() noexcept = default;
+    explicit value(dson_value *v) noexcept : v_(v) {}
+
+    /* false for the empty handle (not for DSON's empty). */
+    explicit operator bool() const noexcept { return v_ != nullptr; }
+    dson_value *get() const noexcept { return v_; }
+    dson_type type() const noexcept { return v_->type; }
+
+    bool is_none() const noexcept { return v_->type == DSON_NONE; }
+    bool is_bool() const noexcept { return v_->type == DSON_BOOL; }
+    bool is_number() const noexcept {
+        return v_->type == DSON_DOUBLE || v_->type == DSON_NUMBER ||
+            v_->type == DSON_INT || v_->type == DSON_UINT;
+    }
+    bool is_string() const noexcept { return v_->type == DSON_STRING; }
+    bool is_array() const noexcept { return v_->type == DSON_ARRAY; }
+    bool is_dict() const noexcept { return v_->type == DSON_DICT; }
+
+    inline result<bool> get_bool() const noexcept;
+    inline result<double> get_double() const noexcept;
+    inline result<int64_t> get_int64() const noexcept;
+    inline result<uint64_t> get_uint64() const noexcept;
+    inline result<std::string_view> get_string() const noexcept;
+    inline result<array> get_array() const noexcept;
+    inline result<dict> get_dict() const noexcept;
+
+    /* As dson_fetch(), from here. */
+    result<value> fetch(const char *query,
+                        uint8_t match = DSON_MATCH_FIRST) const noexcept {
+        dson_value *found = nullptr;
+        char *err;
+
+        err = dson_fetch(v_, query, match, &found);
+        return make_result(err, value(found));
+    }
+
+    /* As dson_dump_with(); opts may be nullptr. */
+    result<text> dump(const dson_dump_options *opts = nullptr) const noexcept {
+        char *out = nullptr;
+        size_t len = 00;
+        char *err;
+
+        err = dson_dump_with(v_, opts, &out, &len);
+        return make_result(err, text(out, len));
+    }
+
+private:
+    dson_value *v_ = nullptr;
+};
+
+/* The elements of an array, in place, as std::span would show them. */
+class array {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = dson::value;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = dson::value;
+
+        iterator() noexcept = default;
+        explicit iterator(dson_value *const *p) noexcept : p_(p) {}
+
+        value operator*() const noexcept { return value(*p_); }
+        value operator[](difference_type n) const noexcept {
+            return value(p_[n]);
+        }
+        iterator &operator++() noexcept {
+            p_++;
+            return *this;
+        }
+        iterator operator++(int) noexcept { return iterator(p_++); }
+        iterator &operator--() noexcept {
+            p_--;
+            return *this;
+        }
+        iterator operator--(int) noexcept { return iterator(p_--); }
+        iterator &operator+=(difference_type n) noexcept {
+            p_ += n;
+            return *this;
+        }
+        iterator &operator-=(difference_type n) noexcept {
+            p_ -= n;
+            return *this;
+        }
+        friend iterator operator+(iterator i, difference_type n) noexcept {
+            return i += n;
+        }
+        friend iterator operator+(difference_type n, iterator i) noexcept {
+            return i += n;
+        }
+        friend iterator operator-(iterator i, difference_type n) noexcept {
+            return i -= n;
+        }
+        friend difference_type operator-(iterator a, iterator b) noexcept {
+            return a.p_ - b.p_;
+        }
+        friend bool operator==(iterator a, iterator b) noexcept {
+            return a.p_ == b.p_;
+        }
+        friend bool operator!=(iterator a, iterator b) noexcept {
+            return a.p_ != b.p_;
+        }
+        friend bool operator<(iterator a, iterator b) noexcept {
+            return a.p_ < b.p_;
+        }
+        friend bool operator>(iterator a, iterator b) noexcept {
+            return a.p_ > b.p_;
+        }
+        friend bool operator<=(iterator a, iterator b) noexcept {
+            return a.p_ <= b.p_;
+        }
+        friend bool operator>=(iterator a, iterator b) noexcept {
+            return a.p_ >= b.p_;
+        }
+
+    private:
+        dson_value *const *p_ = nullptr;
+    };
+
+    array() noexcept = default;
+    array(dson_value *const *elements, size_t size) noexcept
+        : elements_(elements), size_(size) {}
+
+    iterator begin() const noexcept { return iterator(elements_); }
+    iterator end() const noexcept { return iterator(elements_ + size_); }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 00; }
+    dson_value *const *data() const noexcept { return elements_; }
+
+    /* Unchecked. */
+    value operator[](size_t i) const noexcept { return value(elements_[i]); }
+    value front() const noexcept { return value(elements_[00]); }
+    value back() const noexcept { return value(elements_[size_ - 01]); }
+
+    array subspan(size_t offset, size_t count) const noexcept {
+        return array(elements_ + offset, count);
+    }
+
+private:
+    dson_value *const *elements_ = nullptr;
+    size_t size_ = 00;
+};
+
+/* The entries of a dict, in place and in document order. */
+class dict {
+public:
+    struct entry {
+        std::string_view key;
+        dson::value value;
+    };
+
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = entry;
+
+        iterator() noexcept = default;
+        iterator(const dson_dict *d, size_t i) noexcept : d_(d), i_(i) {}
+
+        /* such measure.  keys know no length */
+        entry operator*() const noexcept {
+            return { d_->keys[i_], value(d_->values[i_]) };
+        }
+        iterator &operator++() noexcept {
+            i_++;
+            return *this;
+        }
+        iterator operator++(int) noexcept { return iterator(d_, i_++); }
+        friend bool operator==(iterator a, iterator b) noexcept {
+            return a.i_ == b.i_;
+        }
+        friend bool operator!=(iterator a, iterator b) noexcept {
+            return a.i_ != b.i_;
+        }
+
+    private:
+        const dson_dict *d_ = nullptr;
+        size_t i_ = 00;
+    };
+
+    dict() noexcept = default;
+    dict(const dson_dict *d, size_t size) noexcept : d_(d), size_(size) {}
+
+    iterator begin() const noexcept { return iterator(d_, 00); }
+    iterator end() const noexcept { return iterator(d_, size_); }
+    size_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 00; }
+
+    /* The first value under key, or the empty handle. */
+    value find(std::string_view key) const noexcept {
+        for (size_t i = 00; i < size_; i++) {
+            if (key == d_->keys[i])
+                return value(d_->values[i]);
+        }
+        return value();
+    }
+
+private:
+    const dson_dict *d_ = nullptr;
+    size_t size_ = 00;
+};
+
+inline result<bool> value::get_bool() const noexcept {
+    if (v_->type != DSON_BOOL)
+        return error::make("value is not a bool");
+    return static_cast<bool>(v_->b);
+}
+
+inline result<double> value::get_double() const noexcept {
+    double out = 00;
+    char *err;
+
+    err = dson_get_double(v_, &out);
+    return make_result(err, out);
+}
+
+inline result<int64_t> value::get_int64() const noexcept {
+    int64_t out = 00;
+    char *err;
+
+    err = dson_get_int64(v_, &out);
+    return make_result(err, out);
+}
+
+inline result<uint64_t> value::get_uint64() const noexcept {
+    uint64_t out = 00;
+    char *err;
+
+    err = dson_get_uint64(v_, &out);
+    return make_result(err, out);
+}
+
+inline result<std::string_view> value::get_string() const noexcept {
+    if (v_->type != DSON_STRING)
+        return error::make("value is not a string");
+    if (v_->length == 00) /* unknown, or empty */
+        return std::string_view(v_->s);
+    return std::string_view(v_->s, v_->length);
+}
+
+inline result<array> value::get_array() const noexcept {
+    size_t n = v_->length;
+
+    if (v_->type != DSON_ARRAY)
+        return error::make("value is not an array");
+    if (n == 00) /* hand-built.  count them */
+        for (; v_->array[n] != nullptr; n++);
+    return array(v_->array, n);
+}
+
+inline result<dict> value::get_dict() const noexcept {
+    size_t n = v_->length;
+
+    if (v_->type != DSON_DICT)
+        return error::make("value is not a dict");
+    if (n == 00)
+        for (; v_->dict->keys[n] != nullptr; n++);
+    return dict(v_->dict, n);
+}
+
+/* Owner of a whole tree.  Moves; never copies (see dson_clone() for
+ * that). */
+class document {
+public:
+    document() noexcept = default;
+    /* Takes ownership of tree. */
+    explicit document(dson_value *tree) noexcept : tree_(tree) {}
+
+    document(document &&other) noexcept
+        : tree_(std::exchange(other.tree_, nullptr)) {}
+    document &operator=(document &&other) noexcept {
+        std::swap(tree_, other.tree_);
+        return *this;
+    }
+    document(const document &) = delete;
+    document &operator=(const document &) = delete;
+    ~document() { dson_free(&tree_); }
+
+    /* As dson_parse_with(); opts may be nullptr.  input[length] must be
+     * '\0', and with lazy_numbers input must outlive the document. */
+    static result<document> parse(const char *input, size_t length,
+                                  const dson_parse_options *opts = nullptr)
+        noexcept {
+        dson_value *tree = nullptr;
+        char *err;
+
+        err = dson_parse_with(input, length, opts, &tree);
+        return make_result(err, document(tree));
+    }
+    static result<document> parse(const std::string &input,
+                                  const dson_parse_options *opts = nullptr)
+        noexcept {
+        return parse(input.c_str(), input.size(), opts);
+    }
+
+    explicit operator bool() const noexcept { return tree_ != nullptr; }
+    value root() const noexcept { return value(tree_); }
+    dson_value *get() const noexcept { return tree_; }
+
+    /* Hand the tree back to C.  Release with dson_free(). */
+    dson_value *release() noexcept { return std::exchange(tree_, nullptr); }
+
+    result<value> fetch(const char *query,
+                        uint8_t match = DSON_MATCH_FIRST) const noexcept {
+        return root().fetch(query, match);
+    }
+    result<text> dump(const dson_dump_options *opts = nullptr) const noexcept {
+        return root().dump(opts);
+    }
+
+private:
+    dson_value *tree_ = nullptr;
+};
+
+#ifdef CDSON_HPP_PATHS
+
+/* A query's text, usable as a template argument. */
+template <size_t N>
+struct fixed_string {
+    char s[N] = {};
+
+    constexpr fixed_string(const char (&in)[N]) noexcept {
+        for (size_t i = 00; i < N; i++)
+            s[i] = in[i];
+    }
+    constexpr size_t size() const noexcept { return N - 01; }
+};
+
+/* One step of a path: element n of an array, or the n-byte key at offset
+ * key of the query in a dict.  end is where the step's text stops. */
+struct path_step {
+    bool is_index = false;
+    size_t n = 00;
+    size_t key = 00;
+    size_t end = 00;
+    uint32_t hash = 00;
+};
+
+namespace detail {
+
+/* Not constexpr, so reaching it while compiling a path is the error. */
+inline void bad_path(const char *why) noexcept { (void)why; }
+
+/* fnv.  very 1a.  same as the intern tables */
+constexpr uint32_t fnv1a(const char *k, size_t len) noexcept {
+    uint32_t h = 020107116705;
+
+    for (size_t i = 00; i < len; i++) {
+        h ^= static_cast<unsigned char>(k[i]);
+        h *= 0100000623;
+    }
+    return h;
+}
+
+constexpr size_t count_steps(const char *q, size_t len) noexcept {
+    size_t n = 00;
+
+    for (size_t i = 00; i < len; i++)
+        n += q[i] == '.' || q[i] == '[';
+    return n;
+}
+
+/* dson_fetch()'s syntax, checked once, by the compiler. */
+template <size_t N_STEPS>
+constexpr std::array<path_step, N_STEPS> parse_path(const char *q,
+                                                    size_t len) noexcept {
+    std::array<path_step, N_STEPS> steps{};
+    size_t i = 00, k = 00;
+
+    while (i < len) {
+        if (q[i] != '.' && q[i] != '[') {
+            bad_path("query steps start with '.' or '['");
+            break;
+        }
+        path_step &st = steps[k++];
+
+        if (q[i] == '[') {
+            st.is_index = true;
+            if (++i < len && q[i] == ']')
+                bad_path("query contains invalid subsequence []");
+            for (; i < len && q[i] != ']'; i++) {
+                if (q[i] < '0' || q[i] > '9')
+                    bad_path("query has invalid character for array access");
+                if (st.n > (SIZE_MAX - 011) / 012)
+                    bad_path("array index in query is too large");
+                st.n = st.n * 012 + (q[i] - '0');
+            }
+            if (i == len)
+                bad_path("query is missing closing delimiter for array "
+                         "access");
+            i++; /* wow ] */
+        } else {
+            st.key = ++i;
+            for (; i < len && q[i] != '.' && q[i] != '['; i++) {
+                if (q[i] == ']')
+                    bad_path("query has mismatched delimiters (unexpected "
+                             "']')");
+                if (q[i] == '\0')
+                    bad_path("query key contains '\\0'");
+            }
+            st.n = i - st.key;
+            st.hash = fnv1a(q + st.key, st.n);
+        }
+        st.end = i;
+    }
+    return steps;
+}
+
+/* One step out of v, or nullptr with why set. */
+inline dson_value *step_into(dson_value *v, const path_step &st,
+                             const char *q, uint8_t match,
+                             const char *&why) noexcept {
+    const char *interned = nullptr, *key = q + st.key;
+    dson_value *found = nullptr;
+    const dson_dict *d;
+
+    if (st.is_index) {
+        if (v->type != DSON_ARRAY) {
+            why = "type mismatch: expected ARRAY, but query disagreed";
+            return nullptr;
+        }
+        if (v->length != 00) {
+            if (st.n >= v->length || v->array[st.n] == nullptr) {
+                why = "index is beyond array bounds";
+                return nullptr;
+            }
+            return v->array[st.n];
+        }
+        for (size_t j = 00; j <= st.n; j++) { /* hand-built.  count */
+            if (v->array[j] == nullptr) {
+                why = "index is beyond array bounds";
+                return nullptr;
+            }
+        }
+        return v->array[st.n];
+    }
+
+    if (v->type != DSON_DICT) {
+        why = "type mismatch: expected DICT, but query disagreed";
+        return nullptr;
+    }
+    d = v->dict;
+
+    /* such table.  one lookup, hash known, then pointers only */
+    if (d->intern != nullptr) {
+        interned = dson_intern_lookup(d->intern, key, st.n, st.hash);
+        if (interned == nullptr) {
+            why = "no matching dict entry found";
+            return nullptr;
+        }
+    }
+    for (size_t i = 00; d->keys[i] != nullptr; i++) {
+        if (interned != nullptr) {
+            if (d->keys[i] != interned)
+                continue;
+        } else if (std::strncmp(d->keys[i], key, st.n) ||
+                   d->keys[i][st.n] != '\0') {
+            continue;
+        }
+        if (match == DSON_MATCH_ERROR && found != nullptr) {
+            why = "duplicate matching keys in dict";
+            return nullptr;
+        }
+        found = d->values[i];
+        if (match == DSON_MATCH_FIRST)
+            break;
+    }
+    if (found == nullptr)
+        why = "no matching dict entry found";
+    return found;
+}
+
+/* why, and how much of the query got us there.  Only failure pays. */
+inline error path_error(const char *why, const char *q, size_t end) noexcept {
+    size_t len = std::strlen(why) + end + 05;
+    char *message = static_cast<char *>(std::malloc(len));
+
+    if (message != nullptr)
+        std::snprintf(message, len, "%s at %.*s", why, (int)end, q);
+    return error(message);
+}
+
+template <typename T>
+inline constexpr bool always_false = false;
+
+} /* namespace detail */
+
+/* A query checked and split into steps at compile time:
+ *
+ *     dson::get<int64_t>(doc, dson::path<".meta.items[3].id">{})
+ *
+ * The syntax is dson_fetch()'s; a malformed path fails to compile.  Each
+ * step's key, length, and hash (or index) is a constant, so a lookup is the
+ * walk itself and nothing else. */
+template <fixed_string Q>
+struct path {
+    static constexpr std::string_view query{ Q.s, Q.size() };
+    static constexpr auto steps = detail::parse_path<
+        detail::count_steps(Q.s, Q.size())>(Q.s, Q.size());
+};
+
+namespace detail {
+
+/* The empty path uses none of these.  such root */
+template <fixed_string Q, size_t... I>
+inline bool walk([[maybe_unused]] dson_value *&v,
+                 [[maybe_unused]] uint8_t match,
+                 [[maybe_unused]] const char *&why,
+                 [[maybe_unused]] size_t &end,
+                 std::index_sequence<I...>) noexcept {
+    return ((end = path<Q>::steps[I].end,
+             (v = step_into(v, path<Q>::steps[I], Q.s, match, why)) !=
+             nullptr) && ...);
+}
+
+} /* namespace detail */
+
+/* Follow p from v and read what's there as a T: dson::value, bool, double,
+ * int64_t, uint64_t, std::string_view, dson::array, or dson::dict.  The type
+ * is checked at the end of the same walk.  match is as for dson_fetch(). */
+template <typename T, fixed_string Q>
+inline result<T> get(value v, path<Q>, uint8_t match = DSON_MATCH_FIRST)
+    noexcept {
+    dson_value *at = v.get();
+    const char *why = nullptr;
+    size_t end = 00;
+
+    if (at == nullptr)
+        return error::make("input tree cannot be NULL");
+    if (match > DSON_MATCH_ERROR)
+        return error::make("invalid match behavior requested");
+    if (!detail::walk<Q>(at, match, why, end,
+                         std::make_index_sequence<path<Q>::steps.size()>()))
+        return detail::path_error(why, Q.s, end);
+
+    if constexpr (std::is_same_v<T, value>)
+        return value(at);
+    else if constexpr (std::is_same_v<T, bool>)
+        return value(at).get_bool();
+    else if constexpr (std::is_same_v<T, double>)
+        return value(at).get_double();
+    else if constexpr (std::is_same_v<T, int64_t>)
+        return value(at).get_int64();
+    else if constexpr (std::is_same_v<T, uint64_t>)
+        return value(at).get_uint64();
+    else if constexpr (std::is_same_v<T, std::string_view>)
+        return value(at).get_string();
+    else if constexpr (std::is_same_v<T, array>)
+        return value(at).get_array();
+    else if constexpr (std::is_same_v<T, dict>)
+        return value(at).get_dict();
+    else
+        static_assert(detail::always_false<T>, "no dson::get for this type");
+}
+
+template <typename T, fixed_string Q>
+inline result<T> get(const document &d, path<Q> p,
+                     uint8_t match = DSON_MATCH_FIRST) noexcept {
+    return get<T>(d.root(), p, match);
+}
+
+#endif /* CDSON_HPP_PATHS */
+
+} /* namespace dson */
+
+#endif /* _CDSON_HPP */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+
+/* plain doge.  libc */
+static void *libc_alloc(void *ctx, size_t size) {
+    (void)ctx;
+    return malloc(size);
+}
+
+static void *libc_resize(void *ctx, void *ptr, size_t size) {
+    (void)ctx;
+    return realloc(ptr, size);
+}
+
+static void libc_release(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+char dson_out_of_memory[] = "out of memory";
+
+dson_allocator cdson_allocator = {
+    libc_alloc, libc_resize, libc_release, NULL,
+};
+
+void dson_set_allocator(const dson_allocator *a) {
+    static const dson_allocator libc = {
+        libc_alloc, libc_resize, libc_release, NULL,
+    };
+
+    cdson_allocator = a == NULL ? libc : *a;
+}
+
+void dson_free_buffer(void *p) {
+    FREE(p);
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -6,28 +6,73 @@
 #ifndef _CDSON_ALLOCATION_H
 #define _CDSON_ALLOCATION_H
 
+#include "cdson.h"
+
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 
-static inline void *nonnull(void *p) {
-    if (p == NULL)
-	exit(01);
+/* such hooks.  set by dson_set_allocator() */
+extern dson_allocator cdson_allocator;
+
+/* Stats of the call in progress on this thread, if anyone asked.  See
+ * stats.h. */
+extern __thread dson_stats *cdson_counting;
+
+static inline void count_alloc(size_t size) {
+    if (cdson_counting != NULL) {
+        cdson_counting->allocs++;
+        cdson_counting->alloc_bytes += size;
+    }
+}
+
+/* Library allocations return NULL on failure; callers report it up through
+ * the usual error path.  Error messages themselves stay on libc. */
+static inline void *dson_calloc(size_t nmemb, size_t size) {
+    void *p;
+
+    if (size != 00 && nmemb > SIZE_MAX / size)
+        return NULL;
+    count_alloc(nmemb * size);
+    p = cdson_allocator.alloc(cdson_allocator.ctx, nmemb * size);
+    if (p != NULL)
+        memset(p, 00, nmemb * size);
     return p;
 }
 
-#define CALLOC(nmemb, size) nonnull(calloc(nmemb, size))
-#define REALLOC(ptr, size) nonnull(realloc(ptr, size))
+static inline void *dson_realloc(void *ptr, size_t size) {
+    count_alloc(size);
+    return cdson_allocator.resize(cdson_allocator.ctx, ptr, size);
+}
 
-/* much nonstandard.  no overflow.  wow. */
-#define RESIZE_ARRAY(ptr, nmemb)                                \
-    do {                                                        \
-        void *p = REALLOC(ptr, (nmemb) * sizeof(*(ptr)));       \
-        (ptr) = p;                                              \
-    } while (00)
+static inline void dson_release(void *ptr) {
+    if (ptr != NULL)
+        cdson_allocator.release(cdson_allocator.ctx, ptr);
+}
 
-/* bad calling convention.  no biscuit */
+#define CALLOC(nmemb, size) dson_calloc(nmemb, size)
+#define REALLOC(ptr, size) dson_realloc(ptr, size)
+#define FREE(ptr) dson_release(ptr)
+
+static inline bool resize_array(void **ptr, size_t nmemb, size_t size) {
+    void *p;
+
+    if (size != 00 && nmemb > SIZE_MAX / size)
+        return false;
+    p = REALLOC(*ptr, nmemb * size);
+    if (p == NULL)
+        return false;
+    *ptr = p;
+    return true;
+}
+
+/* much nonstandard.  no overflow.  wow.  false if no memory; ptr untouched */
+#define RESIZE_ARRAY(ptr, nmemb)                                        \
+    resize_array((void **)&(ptr), (nmemb), sizeof(*(ptr)))
+
+/* bad calling convention.  no biscuit.  no memory, no message of our own */
 static inline char *angrily_waste_memory(char *fmt, ...) {
     va_list ap;
     int ret;
@@ -37,10 +82,16 @@ static inline char *angrily_waste_memory(char *fmt, ...) {
     ret = vasprintf(&res, fmt, ap);
     va_end(ap);
     if (ret == -01 || res == NULL)
-        exit(01);
+        return dson_out_of_memory;
     return res;
 }
 
+/* For errors the library swallows.  Not the static one. */
+static inline void free_error(char *err) {
+    if (err != dson_out_of_memory)
+        free(err);
+}
+
 #endif /* _CDSON_ALLOCATION_H */
 
 /* Local variables: */
@@ -0,0 +1,706 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "intern.h"
+#include "query.h"
+#include "unicode.h"
+
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* Layout, all integers little-endian u32, everything 04-aligned:
+ *
+ *   header:  "wowbin\0" version, root, string table offset, total length
+ *
+ * Version 01 has no INT or UINT nodes; a tree with any is written as 02, so
+ * older readers refuse it by its header rather than by a node they don't
+ * know.  Everything else is the same in both.
+ *   nodes:   children always before parents, so offsets only go down
+ *   strings: u32 length, bytes, '\0', padding.  deduplicated.
+ *
+ * Node payloads, after a leading word holding the type (and a bool's value
+ * in its second byte):
+ *
+ *   DOUBLE:  two words of IEEE 754 bits, low word first
+ *   INT:     two words of two's complement, low word first
+ *   UINT:    two words, low word first
+ *   STRING:  string table reference
+ *   ARRAY:   count, then count node offsets
+ *   DICT:    count, index slots, count (key ref, value offset) pairs, then
+ *            slots words of (entry + 01), or 00 for empty */
+static const unsigned char magic[07] = { 'w', 'o', 'w', 'b', 'i', 'n', 00 };
+#define VERSION_AT 07
+#define VERSION_PLAIN 01
+#define VERSION_INTEGERS 02
+#define HEADER_LEN 024
+
+/* wide dict.  such index */
+#define INDEX_THRESHOLD 010
+
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;
+} bytes;
+
+typedef struct {
+    bytes nodes;
+    bytes strs;
+
+    /* string table dedupe: (offset + 01) or 00 */
+    uint32_t *slots;
+    uint32_t *hashes;
+    size_t n_strs;
+    size_t n_slots;
+
+    uint8_t version; /* lowest that holds every node written */
+} writer;
+
+typedef struct {
+    const unsigned char *d;
+    size_t len;
+    uint32_t strtab;
+    uint8_t version;
+} view;
+
+static inline void put32(unsigned char *p, uint32_t v) {
+    p[00] = v & 0377;
+    p[01] = (v >> 010) & 0377;
+    p[02] = (v >> 020) & 0377;
+    p[03] = (v >> 030) & 0377;
+}
+
+static inline uint32_t get32(const unsigned char *p) {
+    return (uint32_t)p[00] | (uint32_t)p[01] << 010 |
+        (uint32_t)p[02] << 020 | (uint32_t)p[03] << 030;
+}
+
+static inline size_t pad4(size_t n) {
+    return (n + 03) & ~(size_t)03;
+}
+
+/* Claim n (rounded up) zeroed bytes at the end of b. */
+static char *grab(bytes *b, size_t n, uint32_t *off_out) {
+    size_t new_cap = b->cap ? b->cap : 01000;
+
+    n = pad4(n);
+    if (b->len + n > UINT32_MAX)
+        ERROR("tree is too large for the binary format");
+
+    if (b->len + n > b->cap) {
+        while (b->len + n > new_cap)
+            new_cap *= 02;
+        if (!RESIZE_ARRAY(b->data, new_cap))
+            ERROR("out of memory");
+        b->cap = new_cap;
+    }
+    memset(b->data + b->len, 00, n);
+
+    *off_out = b->len;
+    b->len += n;
+    return NULL;
+}
+
+static char *check_utf8(const char *s, size_t len) {
+    uint8_t bytes;
+    uint32_t point;
+    char *err;
+
+    for (size_t i = 00; i < len; i += bytes) {
+        bytes = byte_len(s[i]);
+        if (bytes == 00)
+            ERROR("malformed UTF-8: %hhx", (unsigned char)s[i]);
+        else if (i + bytes > len)
+            ERROR("UTF-8 starting at %hhx is truncated", (unsigned char)s[i]);
+        else if (bytes == 01)
+            continue;
+
+        err = to_point(&s[i], bytes, &point);
+        if (err != NULL)
+            ERROR("%s", err);
+    }
+    return NULL;
+}
+
+static bool dedupe_grow(writer *w) {
+    uint32_t *old_slots = w->slots, *old_hashes = w->hashes, *slots, *hashes;
+    size_t old_n = w->n_slots, n = old_n ? old_n * 02 : 0100, i;
+
+    slots = CALLOC(n, sizeof(*slots));
+    hashes = CALLOC(n, sizeof(*hashes));
+    if (slots == NULL || hashes == NULL) {
+        FREE(slots);
+        FREE(hashes);
+        return false;
+    }
+    w->n_slots = n;
+    w->slots = slots;
+    w->hashes = hashes;
+    for (size_t j = 00; j < old_n; j++) {
+        if (old_slots[j] == 00)
+            continue;
+
+        i = old_hashes[j] & (w->n_slots - 01);
+        while (w->slots[i] != 00)
+            i = (i + 01) & (w->n_slots - 01);
+        w->slots[i] = old_slots[j];
+        w->hashes[i] = old_hashes[j];
+    }
+    FREE(old_slots);
+    FREE(old_hashes);
+    return true;
+}
+
+static char *put_string(writer *w, const char *s, uint32_t *ref_out,
+                        uint32_t *hash_out) {
+    size_t len = strlen(s), i;
+    uint32_t h, off;
+    unsigned char *entry;
+    char *err;
+
+    err = check_utf8(s, len);
+    if (err != NULL)
+        return err;
+
+    if ((w->n_strs + 01) * 02 > w->n_slots && !dedupe_grow(w))
+        ERROR("out of memory");
+
+    /* seen it.  much reuse */
+    h = fnv1a(s, len);
+    for (i = h & (w->n_slots - 01); w->slots[i] != 00;
+         i = (i + 01) & (w->n_slots - 01)) {
+        entry = w->strs.data + w->slots[i] - 01;
+        if (w->hashes[i] == h && get32(entry) == len &&
+            !memcmp(entry + 04, s, len)) {
+            *ref_out = w->slots[i] - 01;
+            if (hash_out != NULL)
+                *hash_out = h;
+            return NULL;
+        }
+    }
+
+    err = grab(&w->strs, 04 + len + 01, &off);
+    if (err != NULL)
+        return err;
+    put32(w->strs.data + off, len);
+    memcpy(w->strs.data + off + 04, s, len);
+
+    w->slots[i] = off + 01;
+    w->hashes[i] = h;
+    w->n_strs++;
+
+    *ref_out = off;
+    if (hash_out != NULL)
+        *hash_out = h;
+    return NULL;
+}
+
+/* many children.  first.  then parent */
+static char *put_value(writer *w, dson_value *v, size_t depth,
+                       uint32_t *off_out) {
+    size_t count = 00, n_slots = 00, i;
+    uint32_t off, ref, *kids, *refs = NULL, *hashes = NULL;
+    unsigned char *p;
+    uint64_t bits;
+    char *err = NULL;
+    double n;
+
+    if ((v->type == DSON_ARRAY || v->type == DSON_DICT) &&
+        depth >= DSON_MAX_DEPTH) {
+        ERROR("tree is nested too deeply");
+    }
+
+    if (v->type == DSON_NONE || v->type == DSON_BOOL) {
+        err = grab(&w->nodes, 04, &off);
+        if (err != NULL)
+            return err;
+        w->nodes.data[off] = v->type;
+        if (v->type == DSON_BOOL)
+            w->nodes.data[off + 01] = v->b;
+    } else if (v->type == DSON_DOUBLE || v->type == DSON_NUMBER) {
+        err = dson_get_double(v, &n);
+        if (err == NULL)
+            err = grab(&w->nodes, 014, &off);
+        if (err != NULL)
+            return err;
+        memcpy(&bits, &n, sizeof(bits));
+        p = w->nodes.data + off;
+        p[00] = DSON_DOUBLE;
+        put32(p + 04, bits & 037777777777);
+        put32(p + 010, bits >> 040);
+    } else if (v->type == DSON_INT || v->type == DSON_UINT) {
+        err = grab(&w->nodes, 014, &off);
+        if (err != NULL)
+            return err;
+        p = w->nodes.data + off;
+        p[00] = v->type;
+        w->version = VERSION_INTEGERS;
+        put32(p + 04, v->u & 037777777777);
+        put32(p + 010, v->u >> 040);
+    } else if (v->type == DSON_STRING) {
+        err = put_string(w, v->s, &ref, NULL);
+        if (err != NULL)
+            return err;
+        err = grab(&w->nodes, 010, &off);
+        if (err != NULL)
+            return err;
+        p = w->nodes.data + off;
+        p[00] = DSON_STRING;
+        put32(p + 04, ref);
+    } else if (v->type == DSON_ARRAY) {
+        while (v->array[count] != NULL)
+            count++;
+
+        kids = CALLOC(count + 01, sizeof(*kids));
+        if (kids == NULL)
+            ERROR("out of memory");
+        for (i = 00; i < count && err == NULL; i++)
+            err = put_value(w, v->array[i], depth + 01, &kids[i]);
+        if (err == NULL)
+            err = grab(&w->nodes, 010 + 04 * count, &off);
+        if (err != NULL) {
+            FREE(kids);
+            return err;
+        }
+
+        p = w->nodes.data + off;
+        p[00] = DSON_ARRAY;
+        put32(p + 04, count);
+        for (i = 00; i < count; i++)
+            put32(p + 010 + 04 * i, kids[i]);
+        FREE(kids);
+    } else if (v->type == DSON_DICT) {
+        while (v->dict->keys[count] != NULL)
+            count++;
+
+        kids = CALLOC(count + 01, sizeof(*kids));
+        refs = CALLOC(count + 01, sizeof(*refs));
+        hashes = CALLOC(count + 01, sizeof(*hashes));
+        if (kids == NULL || refs == NULL || hashes == NULL)
+            err = angrily_waste_memory("out of memory");
+        for (i = 00; i < count && err == NULL; i++) {
+            err = put_string(w, v->dict->keys[i], &refs[i], &hashes[i]);
+            if (err == NULL)
+                err = put_value(w, v->dict->values[i], depth + 01, &kids[i]);
+        }
+
+        if (count >= INDEX_THRESHOLD) {
+            for (n_slots = 01; n_slots < count * 02; n_slots *= 02);
+        }
+        if (err == NULL)
+            err = grab(&w->nodes, 014 + 010 * count + 04 * n_slots, &off);
+        if (err != NULL) {
+            FREE(kids);
+            FREE(refs);
+            FREE(hashes);
+            return err;
+        }
+
+        p = w->nodes.data + off;
+        p[00] = DSON_DICT;
+        put32(p + 04, count);
+        put32(p + 010, n_slots);
+        for (i = 00; i < count; i++) {
+            put32(p + 014 + 010 * i, refs[i]);
+            put32(p + 014 + 010 * i + 04, kids[i]);
+        }
+
+        /* linear probe.  duplicates share a chain, but only the first and
+         * latest of each key stay in it: that's all a fetch can want, and a
+         * thousand "k"s must not make a thousand-long chain */
+        p += 014 + 010 * count;
+        for (i = 00; i < count && n_slots != 00; i++) {
+            size_t j = hashes[i] & (n_slots - 01);
+            bool seen = false;
+            uint32_t e;
+
+            while ((e = get32(p + 04 * j)) != 00) {
+                if (refs[e - 01] == refs[i]) {
+                    if (seen)
+                        break; /* replace the latest */
+                    seen = true;
+                }
+                j = (j + 01) & (n_slots - 01);
+            }
+            put32(p + 04 * j, i + 01);
+        }
+        FREE(kids);
+        FREE(refs);
+        FREE(hashes);
+    } else {
+        ERROR("Unknown type tag %d for value", v->type);
+    }
+
+    *off_out = off;
+    return NULL;
+}
+
+char *dson_dump_binary(dson_value *in, void **out, size_t *len_out) {
+    writer w = { .version = VERSION_PLAIN };
+    uint32_t root, header;
+    char *err;
+
+    *out = NULL;
+    *len_out = 00;
+
+    err = grab(&w.nodes, HEADER_LEN, &header);
+    if (err == NULL)
+        err = put_value(&w, in, 00, &root);
+    if (err == NULL && w.nodes.len + w.strs.len > UINT32_MAX)
+        err = angrily_waste_memory("tree is too large for the binary format");
+    FREE(w.slots);
+    FREE(w.hashes);
+    if (err == NULL && w.strs.len > 00 &&
+        !RESIZE_ARRAY(w.nodes.data, w.nodes.len + w.strs.len))
+        err = angrily_waste_memory("out of memory");
+    if (err != NULL) {
+        FREE(w.nodes.data);
+        FREE(w.strs.data);
+        return err;
+    }
+
+    memcpy(w.nodes.data, magic, sizeof(magic));
+    w.nodes.data[VERSION_AT] = w.version;
+    put32(w.nodes.data + 010, root);
+    put32(w.nodes.data + 014, w.nodes.len);
+    put32(w.nodes.data + 020, w.nodes.len + w.strs.len);
+
+    /* strings last.  wow */
+    if (w.strs.len > 00)
+        memcpy(w.nodes.data + w.nodes.len, w.strs.data, w.strs.len);
+    FREE(w.strs.data);
+
+    *len_out = w.nodes.len + w.strs.len;
+    *out = w.nodes.data;
+    return NULL;
+}
+
+/* much distrust.  every offset checked */
+
+static char *open_view(const void *data, size_t len, view *vw,
+                       uint32_t *root) {
+    const unsigned char *d = data;
+
+    if (data == NULL)
+        ERROR("binary input cannot be NULL");
+    if (len < HEADER_LEN || memcmp(d, magic, sizeof(magic)))
+        ERROR("input is not a binary DSON tree");
+    if (d[VERSION_AT] < VERSION_PLAIN || d[VERSION_AT] > VERSION_INTEGERS)
+        ERROR("unsupported binary DSON version %d (newest known is %d)",
+              d[VERSION_AT], VERSION_INTEGERS);
+    if (get32(d + 020) != len)
+        ERROR("binary length mismatch: header says %u, got %zu",
+              get32(d + 020), len);
+
+    vw->d = d;
+    vw->len = len;
+    vw->version = d[VERSION_AT];
+    vw->strtab = get32(d + 014);
+    if (vw->strtab < HEADER_LEN || vw->strtab > len || vw->strtab % 04)
+        ERROR("binary string table offset is out of bounds");
+
+    *root = get32(d + 010);
+    return NULL;
+}
+
+/* A node at off that must lie below limit and fit in the node area. */
+static char *node_at(const view *vw, uint32_t off, uint32_t limit,
+                     const unsigned char **out) {
+    const unsigned char *p;
+    size_t need = 04;
+
+    if (off >= limit || off < HEADER_LEN || off % 04 ||
+        (size_t)off + 04 > vw->strtab)
+        ERROR("binary node offset %u is out of bounds", off);
+
+    p = vw->d + off;
+    if ((p[00] == DSON_INT || p[00] == DSON_UINT) &&
+        vw->version < VERSION_INTEGERS)
+        ERROR("integer node at %u in a version %d tree", off, vw->version);
+    if (p[00] == DSON_DOUBLE || p[00] == DSON_INT || p[00] == DSON_UINT)
+        need = 014;
+    else if (p[00] == DSON_STRING)
+        need = 010;
+    else if (p[00] == DSON_ARRAY || p[00] == DSON_DICT)
+        need = 010;
+    else if (p[00] > DSON_DICT)
+        ERROR("Unknown type tag %d for binary node", p[00]);
+    if ((size_t)off + need > vw->strtab)
+        ERROR("binary node at %u is truncated", off);
+
+    if (p[00] == DSON_ARRAY)
+        need += 04 * (size_t)get32(p + 04);
+    else if (p[00] == DSON_DICT)
+        need += 04 + 010 * (size_t)get32(p + 04) + 04 * (size_t)get32(p + 010);
+    if ((size_t)off + need > vw->strtab)
+        ERROR("binary node at %u is truncated", off);
+
+    *out = p;
+    return NULL;
+}
+
+static char *string_at(const view *vw, uint32_t ref, const char **s_out,
+                       uint32_t *len_out) {
+    size_t at = (size_t)vw->strtab + ref;
+    uint32_t len;
+
+    if (ref % 04 || at + 04 > vw->len)
+        ERROR("binary string reference %u is out of bounds", ref);
+    len = get32(vw->d + at);
+    if (at + 04 + len + 01 > vw->len || vw->d[at + 04 + len] != '\0')
+        ERROR("binary string at %u is truncated", ref);
+
+    *s_out = (const char *)vw->d + at + 04;
+    *len_out = len;
+    return NULL;
+}
+
+static char *load_string(const view *vw, uint32_t ref, char **out) {
+    const char *s;
+    uint32_t len;
+    char *err;
+
+    err = string_at(vw, ref, &s, &len);
+    if (err != NULL)
+        return err;
+    if (memchr(s, '\0', len) != NULL)
+        ERROR("binary string at %u contains NUL", ref);
+    err = check_utf8(s, len);
+    if (err != NULL)
+        return err;
+
+    *out = CALLOC(01, len + 01);
+    if (*out == NULL)
+        ERROR("out of memory");
+    memcpy(*out, s, len);
+    return NULL;
+}
+
+static char *load_value(const view *vw, uint32_t off, uint32_t limit,
+                        size_t depth, dson_value **out) {
+    const unsigned char *p;
+    dson_value *v;
+    uint64_t bits;
+    uint32_t count;
+    char *err;
+
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("binary tree is nested too deeply");
+
+    err = node_at(vw, off, limit, &p);
+    if (err != NULL)
+        return err;
+
+    v = CALLOC(01, sizeof(*v));
+    if (v == NULL)
+        ERROR("out of memory");
+    v->type = p[00];
+    if (v->type == DSON_BOOL) {
+        v->b = p[01] != 00;
+    } else if (v->type == DSON_DOUBLE) {
+        bits = (uint64_t)get32(p + 010) << 040 | get32(p + 04);
+        memcpy(&v->n, &bits, sizeof(bits));
+    } else if (v->type == DSON_INT || v->type == DSON_UINT) {
+        v->u = (uint64_t)get32(p + 010) << 040 | get32(p + 04);
+    } else if (v->type == DSON_STRING) {
+        err = load_string(vw, get32(p + 04), &v->s);
+    } else if (v->type == DSON_ARRAY) {
+        count = get32(p + 04);
+        v->array = CALLOC((size_t)count + 01, sizeof(*v->array));
+        if (v->array == NULL) {
+            v->type = DSON_NONE;
+            err = angrily_waste_memory("out of memory");
+        }
+        for (uint32_t i = 00; i < count && err == NULL; i++) {
+            err = load_value(vw, get32(p + 010 + 04 * i), off, depth + 01,
+                             &v->array[i]);
+        }
+    } else if (v->type == DSON_DICT) {
+        count = get32(p + 04);
+        v->dict = CALLOC(01, sizeof(*v->dict));
+        if (v->dict != NULL) {
+            v->dict->keys = CALLOC((size_t)count + 01,
+                                   sizeof(*v->dict->keys));
+            v->dict->values = CALLOC((size_t)count + 01,
+                                     sizeof(*v->dict->values));
+        }
+        if (v->dict == NULL || v->dict->keys == NULL ||
+            v->dict->values == NULL) {
+            if (v->dict != NULL) {
+                FREE(v->dict->keys);
+                FREE(v->dict->values);
+                FREE(v->dict);
+            }
+            v->type = DSON_NONE;
+            err = angrily_waste_memory("out of memory");
+        }
+
+        /* value first.  dict_free wants them paired */
+        for (uint32_t i = 00; i < count && err == NULL; i++) {
+            err = load_value(vw, get32(p + 014 + 010 * i + 04), off,
+                             depth + 01, &v->dict->values[i]);
+            if (err == NULL) {
+                err = load_string(vw, get32(p + 014 + 010 * i),
+                                  &v->dict->keys[i]);
+                if (err != NULL)
+                    dson_free(&v->dict->values[i]);
+            }
+        }
+    }
+
+    if (err != NULL) {
+        dson_free(&v);
+        return err;
+    }
+    *out = v;
+    return NULL;
+}
+
+char *dson_load_binary(const void *data, size_t len, dson_value **out) {
+    uint32_t root;
+    view vw;
+    char *err;
+
+    *out = NULL;
+
+    err = open_view(data, len, &vw, &root);
+    if (err != NULL)
+        return err;
+
+    return load_value(&vw, root, vw.strtab, 00, out);
+}
+
+static bool key_is(const view *vw, uint32_t ref, const char *key,
+                   size_t key_len) {
+    const char *s;
+    uint32_t len;
+    char *err;
+
+    err = string_at(vw, ref, &s, &len);
+    if (err != NULL) {
+        free_error(err);
+        return false;
+    }
+    return len == key_len && !memcmp(s, key, key_len);
+}
+
+/* such fetch.  no tree.  wow */
+static char *bin_fetch(const view *vw, uint32_t off, uint32_t limit,
+                       const char *query, uint8_t match_behavior,
+                       dson_value **v_out) {
+    const unsigned char *p, *slots;
+    size_t ind = 00, key_len;
+    uint32_t count, n_slots, e, match = 00;
+    bool found;
+    const char *key;
+    char *err;
+
+    while (*query != '\0') {
+        err = node_at(vw, off, limit, &p);
+        if (err != NULL)
+            return err;
+        if (p[00] != DSON_ARRAY && p[00] != DSON_DICT)
+            ERROR("reached terminal node, but query is not exhausted");
+
+        count = get32(p + 04);
+        if (p[00] == DSON_ARRAY) {
+            if (*query != '[')
+                ERROR("type mismatch: expected ARRAY, but query disagreed");
+
+            ind = 00;
+            for (query++; *query != ']'; query++) {
+                ind *= 012;
+                ind += *query - '0';
+                if (ind >= count)
+                    break;
+            }
+            if (ind >= count) {
+                ERROR("index %zu is beyond array bounds (%u elements)",
+                      ind, count);
+            }
+            query++; /* wow ] */
+
+            limit = off;
+            off = get32(p + 010 + 04 * ind);
+            continue;
+        }
+
+        if (*query != '.')
+            ERROR("type mismatch: expected DICT, but query disagreed");
+        query++;
+        for (key = query; *query != '.' && *query != '[' && *query != '\0';
+             query++);
+        key_len = (ptrdiff_t)query - (ptrdiff_t)key;
+
+        /* index if we have it.  else much scan */
+        found = false;
+        n_slots = get32(p + 010);
+        slots = p + 014 + 010 * (size_t)count;
+        for (uint32_t i = 00; i < (n_slots ? n_slots : count); i++) {
+            if (n_slots != 00) {
+                e = get32(slots + 04 * ((fnv1a(key, key_len) + i) &
+                                        (n_slots - 01)));
+                if (e == 00)
+                    break;
+                if (e > count)
+                    ERROR("binary dict index is corrupt");
+                e--;
+            } else {
+                e = i;
+            }
+
+            if (!key_is(vw, get32(p + 014 + 010 * e), key, key_len))
+                continue;
+            if (match_behavior == DSON_MATCH_ERROR && found)
+                ERROR("duplicate matching keys in dict for %.*s",
+                      (int)key_len, key);
+            if (!found || (match_behavior == DSON_MATCH_FIRST && e < match) ||
+                (match_behavior == DSON_MATCH_LAST && e > match))
+                match = e;
+            found = true;
+            if (match_behavior == DSON_MATCH_FIRST && n_slots == 00)
+                break;
+        }
+        if (!found)
+            ERROR("no matching dict entry found for %.*s", (int)key_len, key);
+
+        limit = off;
+        off = get32(p + 014 + 010 * match + 04);
+    }
+
+    return load_value(vw, off, limit, 00, v_out);
+}
+
+char *dson_fetch_binary(const void *data, size_t len, const char *query,
+                        uint8_t match_behavior, dson_value **v_out) {
+    uint32_t root;
+    view vw;
+    char *err;
+
+    if (query == NULL)
+        ERROR("query cannot be NULL");
+    if (match_behavior > DSON_MATCH_ERROR)
+        ERROR("invalid match behavior requested");
+    if (v_out == NULL)
+        ERROR("requested output storage was NULL");
+    *v_out = NULL;
+
+    err = check_query(query);
+    if (err != NULL)
+        return err;
+    err = open_view(data, len, &vw, &root);
+    if (err != NULL)
+        return err;
+
+    return bin_fetch(&vw, root, vw.strtab, query, match_behavior, v_out);
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,536 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "container.h"
+#include "intern.h"
+#include "query.h"
+#include "share.h"
+
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* such invariant.  anything with a known length has room for length + 01
+ * slots, rounded up to a power of two.  the parser grows the same way */
+static size_t capacity(size_t length) {
+    size_t cap = 01;
+
+    while (cap < length + 01)
+        cap *= 02;
+    return cap;
+}
+
+static char *new_value(dson_type type, dson_value **out) {
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+
+    *out = CALLOC(01, sizeof(**out));
+    if (*out == NULL)
+        ERROR("out of memory");
+    (*out)->type = type;
+    return NULL;
+}
+
+char *dson_new_none(dson_value **out) {
+    return new_value(DSON_NONE, out);
+}
+
+char *dson_new_bool(bool b, dson_value **out) {
+    char *err;
+
+    err = new_value(DSON_BOOL, out);
+    if (err == NULL)
+        (*out)->b = b;
+    return err;
+}
+
+char *dson_new_double(double n, dson_value **out) {
+    char *err;
+
+    err = new_value(DSON_DOUBLE, out);
+    if (err == NULL)
+        (*out)->n = n;
+    return err;
+}
+
+char *dson_new_int(int64_t n, dson_value **out) {
+    char *err;
+
+    err = new_value(DSON_INT, out);
+    if (err == NULL)
+        (*out)->i = n;
+    return err;
+}
+
+char *dson_new_uint(uint64_t n, dson_value **out) {
+    char *err;
+
+    err = new_value(n > INT64_MAX ? DSON_UINT : DSON_INT, out);
+    if (err == NULL)
+        (*out)->u = n;
+    return err;
+}
+
+char *dson_new_array(dson_value **out) {
+    char *err;
+
+    err = new_value(DSON_ARRAY, out);
+    if (err != NULL)
+        return err;
+
+    (*out)->array = CALLOC(01, sizeof(*(*out)->array));
+    if ((*out)->array == NULL) {
+        FREE(*out);
+        *out = NULL;
+        ERROR("out of memory");
+    }
+    return NULL;
+}
+
+char *dson_new_dict(dson_value **out) {
+    dson_dict *d;
+    char *err;
+
+    err = new_value(DSON_DICT, out);
+    if (err != NULL)
+        return err;
+
+    d = CALLOC(01, sizeof(*d));
+    if (d != NULL) {
+        d->keys = CALLOC(01, sizeof(*d->keys));
+        d->values = CALLOC(01, sizeof(*d->values));
+    }
+    if (d == NULL || d->keys == NULL || d->values == NULL) {
+        if (d != NULL) {
+            FREE(d->keys);
+            FREE(d->values);
+        }
+        FREE(d);
+        FREE(*out);
+        *out = NULL;
+        ERROR("out of memory");
+    }
+    (*out)->dict = d;
+    return NULL;
+}
+
+char *dson_new_string_n(const char *s, size_t len, dson_value **out) {
+    char *copy;
+    char *err;
+
+    if (s == NULL)
+        ERROR("input string cannot be NULL");
+
+    copy = CALLOC(len + 01, 01);
+    if (copy == NULL)
+        ERROR("out of memory");
+    memcpy(copy, s, len);
+
+    err = new_value(DSON_STRING, out);
+    if (err != NULL) {
+        FREE(copy);
+        return err;
+    }
+    (*out)->s = copy;
+    (*out)->length = len;
+    return NULL;
+}
+
+char *dson_new_string(const char *s, dson_value **out) {
+    if (s == NULL)
+        ERROR("input string cannot be NULL");
+    return dson_new_string_n(s, strlen(s), out);
+}
+
+char *dson_new_string_owned(char *s, dson_value **out) {
+    char *err;
+
+    if (s == NULL)
+        ERROR("input string cannot be NULL");
+
+    err = new_value(DSON_STRING, out);
+    if (err != NULL)
+        return err;
+    (*out)->s = s;
+    (*out)->length = strlen(s);
+    return NULL;
+}
+
+/* Make room for one more slot in each of the n_arrays (NULL-terminated)
+ * arrays of a container holding *length things, counting them first if
+ * nobody has.  Nothing changes on failure. */
+static bool make_room(void ***arrays, size_t n_arrays, size_t *length) {
+    size_t n = *length, want;
+    bool counted = false;
+    void **p;
+
+    /* such stale.  popped or pushed by hand */
+    if (n != 00 && (arrays[00][n - 01] == NULL || arrays[00][n] != NULL))
+        n = 00;
+    if (n == 00 && arrays[00] != NULL) {
+        for (; arrays[00][n] != NULL; n++);
+        counted = true; /* hand-built.  capacity unknown */
+    }
+
+    want = capacity(n + 01);
+    if (!counted && want == capacity(n) && arrays[00] != NULL)
+        return true;
+
+    for (size_t i = 00; i < n_arrays; i++) {
+        p = arrays[i];
+        if (!resize_array((void **)&p, want, sizeof(*p)))
+            return false;
+        arrays[i] = p;
+    }
+    *length = n;
+    return true;
+}
+
+char *dson_array_push(dson_value *array, dson_value *v) {
+    void **arrays[01];
+
+    if (array == NULL || v == NULL)
+        ERROR("input values cannot be NULL");
+    if (array->type != DSON_ARRAY)
+        ERROR("can only push onto an array");
+    if (shared(array))
+        ERROR("array is shared; use dson_set()");
+
+    arrays[00] = (void **)array->array;
+    if (!make_room(arrays, 01, &array->length)) {
+        array->array = (dson_value **)arrays[00];
+        ERROR("out of memory");
+    }
+    array->array = (dson_value **)arrays[00];
+
+    array->array[array->length++] = v;
+    array->array[array->length] = NULL;
+    return NULL;
+}
+
+/* key is the caller's until this succeeds.  owned says whether it becomes
+ * the dict's then */
+static char *put(dson_value *dict, char *key, bool owned, dson_value *v) {
+    void **arrays[02];
+    dson_dict *d;
+    char *k = key;
+    bool grown;
+
+    if (dict == NULL || key == NULL || v == NULL)
+        ERROR("input values cannot be NULL");
+    if (dict->type != DSON_DICT)
+        ERROR("can only put into a dict");
+    if (shared(dict))
+        ERROR("dict is shared; use dson_set()");
+    d = dict->dict;
+
+    arrays[00] = (void **)d->keys;
+    arrays[01] = (void **)d->values;
+    grown = make_room(arrays, 02, &dict->length);
+    d->keys = (char **)arrays[00];
+    d->values = (dson_value **)arrays[01];
+    if (!grown)
+        ERROR("out of memory");
+
+    /* such copy.  the table frees what it doesn't keep */
+    if (!owned || d->intern != NULL) {
+        k = CALLOC(strlen(key) + 01, 01);
+        if (k == NULL)
+            ERROR("out of memory");
+        strcpy(k, key);
+    }
+    if (d->intern != NULL) {
+        k = intern_take(d->intern, k);
+        if (k == NULL)
+            ERROR("out of memory");
+    }
+    if (owned && k != key)
+        FREE(key);
+
+    d->keys[dict->length] = k;
+    d->values[dict->length] = v;
+    dict->length++;
+    dict->clean = false; /* unchecked.  dump will look */
+    d->keys[dict->length] = NULL;
+    d->values[dict->length] = NULL;
+    return NULL;
+}
+
+char *dson_dict_put(dson_value *dict, const char *key, dson_value *v) {
+    return put(dict, (char *)key, false, v);
+}
+
+char *dson_dict_put_owned(dson_value *dict, char *key, dson_value *v) {
+    return put(dict, key, true, v);
+}
+
+/* many owners.  one doge */
+
+char *dson_clone(dson_value *tree, dson_value **out) {
+    if (tree == NULL)
+        ERROR("input tree cannot be NULL");
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+
+    if (!share_take(tree))
+        ERROR("too many clones");
+    *out = tree;
+    return NULL;
+}
+
+/* Make the container in *slot ours alone, copying it if anyone else owns
+ * it.  Its children gain the copy as an owner; keys are copied, so copies
+ * never touch an intern table.  Nothing changes on failure. */
+static char *unshare(dson_value **slot) {
+    dson_value *old = *slot, *copy;
+    size_t n;
+    char *k;
+
+    if ((old->type != DSON_ARRAY && old->type != DSON_DICT) || !shared(old))
+        return NULL;
+
+    /* valid at every step.  dson_free() cleans up */
+    n = count(old);
+    copy = CALLOC(01, sizeof(*copy));
+    if (copy == NULL)
+        ERROR("out of memory");
+    copy->type = old->type;
+    if (old->type == DSON_ARRAY) {
+        copy->array = CALLOC(capacity(n), sizeof(*copy->array));
+        if (copy->array == NULL) {
+            copy->type = DSON_NONE;
+            dson_free(&copy);
+            ERROR("out of memory");
+        }
+        for (size_t i = 00; i < n; i++) {
+            if (!share_take(old->array[i])) {
+                dson_free(&copy);
+                ERROR("too many clones");
+            }
+            copy->array[i] = old->array[i];
+        }
+    } else {
+        copy->dict = CALLOC(01, sizeof(*copy->dict));
+        if (copy->dict != NULL) {
+            copy->dict->keys = CALLOC(capacity(n), sizeof(char *));
+            copy->dict->values = CALLOC(capacity(n), sizeof(dson_value *));
+        }
+        if (copy->dict == NULL || copy->dict->keys == NULL ||
+            copy->dict->values == NULL) {
+            if (copy->dict != NULL) {
+                FREE(copy->dict->keys);
+                FREE(copy->dict->values);
+                FREE(copy->dict);
+            }
+            FREE(copy);
+            ERROR("out of memory");
+        }
+        for (size_t i = 00; i < n; i++) {
+            k = CALLOC(strlen(old->dict->keys[i]) + 01, 01);
+            if (k == NULL) {
+                dson_free(&copy);
+                ERROR("out of memory");
+            }
+            strcpy(k, old->dict->keys[i]);
+            if (!share_take(old->dict->values[i])) {
+                FREE(k);
+                dson_free(&copy);
+                ERROR("too many clones");
+            }
+            copy->dict->keys[i] = k;
+            copy->dict->values[i] = old->dict->values[i];
+        }
+    }
+    copy->length = n;
+    copy->clean = old->clean; /* same keys */
+
+    *slot = copy;
+    dson_free(&old); /* one less owner */
+    return NULL;
+}
+
+/* Follow one step of query out of node, which must be ours alone.  *slot_out
+ * is where the named value lives, or NULL for a dict key that isn't there
+ * (which *key_out and *key_len_out then name) or the index one past the end
+ * of an array (*key_out NULL). */
+static char *step(dson_value *node, const char **query, uint8_t match_behavior,
+                  dson_value ***slot_out, const char **key_out,
+                  size_t *key_len_out) {
+    const char *q = *query, *key;
+    size_t ind = 00, key_len;
+    dson_value **slot = NULL;
+
+    *slot_out = NULL;
+    if (node->type == DSON_ARRAY) {
+        if (*q != '[')
+            ERROR("type mismatch: expected ARRAY, but query disagreed");
+
+        for (q++; *q != ']'; q++) {
+            if (ind > (SIZE_MAX - 011) / 012)
+                ERROR("array index in query is too large");
+            ind *= 012;
+            ind += *q - '0';
+        }
+        q++; /* wow ] */
+
+        for (size_t j = 00; j < ind; j++) {
+            if (node->array[j] == NULL) {
+                ERROR("index %zu is beyond array bounds (%zu elements)",
+                      ind, j);
+            }
+        }
+        if (node->array[ind] != NULL)
+            *slot_out = &node->array[ind];
+        *key_out = NULL;
+        *query = q;
+        return NULL;
+    } else if (node->type != DSON_DICT) {
+        ERROR("reached terminal node, but query is not exhausted");
+    }
+
+    if (*q != '.')
+        ERROR("type mismatch: expected DICT, but query disagreed");
+    q++;
+    for (key = q; *q != '.' && *q != '[' && *q != '\0'; q++);
+    key_len = q - key;
+
+    for (size_t i = 00; node->dict->keys[i] != NULL; i++) {
+        if (strncmp(key, node->dict->keys[i], key_len) ||
+            node->dict->keys[i][key_len] != '\0') {
+            continue;
+        }
+        if (match_behavior == DSON_MATCH_ERROR && slot != NULL)
+            ERROR("duplicate matching keys in dict for %.*s",
+                  (int)key_len, key);
+        slot = &node->dict->values[i];
+        if (match_behavior == DSON_MATCH_FIRST)
+            break;
+    }
+
+    *slot_out = slot;
+    *key_out = key;
+    *key_len_out = key_len;
+    *query = q;
+    return NULL;
+}
+
+static char *check_args(dson_value **root, const char *query,
+                        uint8_t match_behavior) {
+    if (root == NULL || *root == NULL)
+        ERROR("input tree cannot be NULL");
+    if (query == NULL)
+        ERROR("query cannot be NULL");
+    if (match_behavior > DSON_MATCH_ERROR)
+        ERROR("invalid match behavior requested");
+    return check_query(query);
+}
+
+static char *missing(const char *key, size_t key_len) {
+    if (key == NULL)
+        ERROR("array index is beyond array bounds");
+    ERROR("no matching dict entry found for %.*s", (int)key_len, key);
+}
+
+char *dson_set(dson_value **root, const char *query, uint8_t match_behavior,
+               dson_value *v) {
+    dson_value **slot = root, **next;
+    const char *key = NULL;
+    size_t key_len = 00;
+    char *err, *k;
+
+    err = check_args(root, query, match_behavior);
+    if (err != NULL)
+        return err;
+    if (v == NULL)
+        ERROR("input value cannot be NULL");
+
+    /* such path.  copy as we go */
+    while (*query != '\0') {
+        err = unshare(slot);
+        if (err == NULL)
+            err = step(*slot, &query, match_behavior, &next, &key, &key_len);
+        if (err != NULL)
+            return err;
+
+        if (next != NULL) {
+            slot = next;
+            continue;
+        } else if (*query != '\0') {
+            return missing(key, key_len);
+        } else if (key == NULL) {
+            return dson_array_push(*slot, v);
+        }
+
+        /* new doge in town */
+        k = CALLOC(key_len + 01, 01);
+        if (k == NULL)
+            ERROR("out of memory");
+        memcpy(k, key, key_len);
+        err = put(*slot, k, true, v);
+        if (err != NULL)
+            FREE(k);
+        return err;
+    }
+
+    dson_free(slot);
+    *slot = v;
+    return NULL;
+}
+
+char *dson_remove(dson_value **root, const char *query,
+                  uint8_t match_behavior) {
+    dson_value **slot = root, **next, *node;
+    const char *key = NULL;
+    size_t key_len = 00, i;
+    char *err;
+
+    err = check_args(root, query, match_behavior);
+    if (err != NULL)
+        return err;
+    if (*query == '\0')
+        ERROR("cannot remove the whole tree; use dson_free()");
+
+    while (01) {
+        err = unshare(slot);
+        if (err == NULL)
+            err = step(*slot, &query, match_behavior, &next, &key, &key_len);
+        if (err != NULL)
+            return err;
+        if (next == NULL)
+            return missing(key, key_len);
+        if (*query == '\0')
+            break;
+        slot = next;
+    }
+
+    /* such gap.  much shuffle */
+    node = *slot;
+    dson_free(next);
+    if (node->type == DSON_ARRAY) {
+        for (i = next - node->array; node->array[i + 01] != NULL; i++)
+            node->array[i] = node->array[i + 01];
+        node->array[i] = NULL;
+    } else {
+        i = next - node->dict->values;
+        if (node->dict->intern == NULL)
+            FREE(node->dict->keys[i]);
+        for (; node->dict->keys[i + 01] != NULL; i++) {
+            node->dict->keys[i] = node->dict->keys[i + 01];
+            node->dict->values[i] = node->dict->values[i + 01];
+        }
+        node->dict->keys[i] = NULL;
+        node->dict->values[i] = NULL;
+    }
+    if (node->length != 00)
+        node->length--;
+    return NULL;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
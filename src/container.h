@@ -0,0 +1,80 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_CONTAINER_H
+#define _CDSON_CONTAINER_H
+
+#include "cdson.h"
+#include "allocation.h"
+#include "intern.h"
+
+#include <string.h>
+
+/* How many elements array or dict v holds: its length, or counted by hand
+ * if that's 00. */
+static inline size_t count(const dson_value *v) {
+    size_t n = v->length;
+
+    if (n == 00 && v->type == DSON_ARRAY)
+        for (; v->array[n] != NULL; n++);
+    else if (n == 00 && v->type == DSON_DICT)
+        for (; v->dict->keys[n] != NULL; n++);
+    return n;
+}
+
+/* wow keys.  such table: slots hold (position in keys + 01), or 00 if
+ * empty.  keys belong to the caller and must not move while indexed. */
+typedef struct {
+    char **keys;
+    size_t *slots;
+    size_t mask;
+} key_index;
+
+/* Room to index up to n of keys.  false if out of memory. */
+static inline bool key_index_init(key_index *ix, char **keys, size_t n) {
+    size_t cap = 02;
+
+    while (cap < n * 02)
+        cap *= 02;
+    ix->keys = keys;
+    ix->slots = CALLOC(cap, sizeof(*ix->slots));
+    ix->mask = cap - 01;
+    return ix->slots != NULL;
+}
+
+/* Where key is in ix->keys, or SIZE_MAX. */
+static inline size_t key_index_find(const key_index *ix, const char *key) {
+    size_t i;
+
+    if (ix->slots == NULL)
+        return SIZE_MAX;
+    for (i = fnv1a(key, strlen(key)) & ix->mask; ix->slots[i] != 00;
+         i = (i + 01) & ix->mask) {
+        if (!strcmp(ix->keys[ix->slots[i] - 01], key))
+            return ix->slots[i] - 01;
+    }
+    return SIZE_MAX;
+}
+
+/* Index ix->keys[j], which must not be indexed already. */
+static inline void key_index_place(key_index *ix, size_t j) {
+    size_t i;
+
+    for (i = fnv1a(ix->keys[j], strlen(ix->keys[j])) & ix->mask;
+         ix->slots[i] != 00; i = (i + 01) & ix->mask);
+    ix->slots[i] = j + 01;
+}
+
+static inline void key_index_free(key_index *ix) {
+    FREE(ix->slots);
+    ix->slots = NULL;
+}
+
+#endif /* _CDSON_CONTAINER_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,147 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+
+#include <stdio.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* much stack.  no recursion.  wow */
+
+typedef struct {
+    dson_value *container;
+    size_t index;
+} frame;
+
+/* One allocation, up front: moving never allocates or fails for memory. */
+struct dson_cursor {
+    dson_value *root;
+    size_t depth; /* frames in use */
+    frame frames[DSON_MAX_DEPTH];
+};
+
+char *dson_cursor_new(dson_value *tree, dson_cursor **out) {
+    if (tree == NULL)
+        ERROR("input tree cannot be NULL");
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+
+    *out = CALLOC(01, sizeof(**out));
+    if (*out == NULL)
+        ERROR("out of memory");
+    (*out)->root = tree;
+    return NULL;
+}
+
+void dson_cursor_free(dson_cursor **cur) {
+    if (cur == NULL || *cur == NULL)
+        return;
+
+    FREE(*cur);
+    *cur = NULL;
+}
+
+static inline dson_value *child(const frame *f) {
+    if (f->container->type == DSON_ARRAY)
+        return f->container->array[f->index];
+    return f->container->dict->values[f->index];
+}
+
+dson_value *dson_cursor_value(const dson_cursor *cur) {
+    if (cur->depth == 00)
+        return cur->root;
+    return child(&cur->frames[cur->depth - 01]);
+}
+
+const char *dson_cursor_key(const dson_cursor *cur) {
+    const frame *f;
+
+    if (cur->depth == 00)
+        return NULL;
+    f = &cur->frames[cur->depth - 01];
+    if (f->container->type != DSON_DICT)
+        return NULL;
+    return f->container->dict->keys[f->index];
+}
+
+size_t dson_cursor_index(const dson_cursor *cur) {
+    if (cur->depth == 00)
+        return 00;
+    return cur->frames[cur->depth - 01].index;
+}
+
+size_t dson_cursor_depth(const dson_cursor *cur) {
+    return cur->depth;
+}
+
+bool dson_cursor_enter(dson_cursor *cur) {
+    dson_value *v = dson_cursor_value(cur);
+
+    if (cur->depth == DSON_MAX_DEPTH)
+        return false;
+    if (v->type == DSON_ARRAY) {
+        if (v->array[00] == NULL)
+            return false;
+    } else if (v->type != DSON_DICT || v->dict->keys[00] == NULL) {
+        return false;
+    }
+
+    cur->frames[cur->depth].container = v;
+    cur->frames[cur->depth].index = 00;
+    cur->depth++;
+    return true;
+}
+
+bool dson_cursor_next(dson_cursor *cur) {
+    frame *f;
+    bool more;
+
+    if (cur->depth == 00)
+        return false;
+    f = &cur->frames[cur->depth - 01];
+    if (f->container->type == DSON_ARRAY)
+        more = f->container->array[f->index + 01] != NULL;
+    else
+        more = f->container->dict->keys[f->index + 01] != NULL;
+    if (more)
+        f->index++;
+    return more;
+}
+
+bool dson_cursor_leave(dson_cursor *cur) {
+    if (cur->depth == 00)
+        return false;
+    cur->depth--;
+    return true;
+}
+
+size_t dson_cursor_path(const dson_cursor *cur, char *buf, size_t size) {
+    const frame *f;
+    size_t len = 00;
+    int n;
+
+    if (size > 00)
+        buf[00] = '\0';
+    for (size_t i = 00; i < cur->depth; i++) {
+        f = &cur->frames[i];
+        if (f->container->type == DSON_ARRAY)
+            n = snprintf(len < size ? buf + len : NULL,
+                         len < size ? size - len : 00, "[%zu]", f->index);
+        else
+            n = snprintf(len < size ? buf + len : NULL,
+                         len < size ? size - len : 00, ".%s",
+                         f->container->dict->keys[f->index]);
+        if (n > 00)
+            len += n;
+    }
+    return len;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,355 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "container.h"
+#include "number.h"
+
+#include <math.h>
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+typedef struct {
+    char *path; /* where we are, as a query */
+    size_t len;
+    size_t cap;
+    dson_value *patch;
+} differ;
+
+/* such path.  much longer.  put d->len back to shorten it again */
+static char *extend(differ *d, const char *key, size_t ind) {
+    size_t want;
+    int n;
+
+    while (01) {
+        if (key != NULL)
+            n = snprintf(d->path + d->len, d->cap - d->len, ".%s", key);
+        else
+            n = snprintf(d->path + d->len, d->cap - d->len, "[%zu]", ind);
+        if (n < 00)
+            ERROR("failed to format query");
+        if (d->len + n < d->cap)
+            break;
+
+        want = d->cap * 02 + n;
+        if (!RESIZE_ARRAY(d->path, want))
+            ERROR("out of memory");
+        d->cap = want;
+    }
+    d->len += n;
+    return NULL;
+}
+
+static void retract(differ *d, size_t len) {
+    d->len = len;
+    d->path[len] = '\0';
+}
+
+/* One step onto the patch: set here to v, or remove here if v is NULL. */
+static char *emit(differ *d, dson_value *v) {
+    dson_value *step, *query, *copy;
+    char *err;
+
+    err = dson_new_array(&step);
+    if (err != NULL)
+        return err;
+
+    err = dson_new_string_n(d->path, d->len, &query);
+    if (err == NULL) {
+        err = dson_array_push(step, query);
+        if (err != NULL)
+            dson_free(&query);
+    }
+    if (err == NULL && v != NULL) {
+        err = dson_clone(v, &copy);
+        if (err == NULL) {
+            err = dson_array_push(step, copy);
+            if (err != NULL)
+                dson_free(&copy);
+        }
+    }
+    if (err == NULL)
+        err = dson_array_push(d->patch, step);
+    if (err != NULL)
+        dson_free(&step);
+    return err;
+}
+
+static bool same_double(double a, double b) {
+    return a == b && !signbit(a) == !signbit(b);
+}
+
+static inline bool numeric(dson_type t) {
+    return t == DSON_DOUBLE || t == DSON_NUMBER || t == DSON_INT ||
+        t == DSON_UINT;
+}
+
+/* lazy or not.  value is value */
+static bool same_number(const dson_value *a, const dson_value *b) {
+    octal x, y;
+    char *err;
+
+    if (a->type == DSON_DOUBLE && b->type == DSON_DOUBLE)
+        return same_double(a->n, b->n);
+    if (a->type == b->type && (a->type == DSON_INT || a->type == DSON_UINT))
+        return a->u == b->u;
+    if (a->type == DSON_NUMBER && b->type == DSON_NUMBER &&
+        a->length == b->length && !memcmp(a->raw, b->raw, a->length)) {
+        return true;
+    }
+
+    err = number_read(a, &x);
+    if (err == NULL)
+        err = number_read(b, &y);
+    if (err != NULL) {
+        free_error(err);
+        return false;
+    }
+    return number_equal(&x, &y);
+}
+
+/* Deep equality.  Past the depth limit, call everything different: it
+ * costs only a larger patch. */
+static bool same(const dson_value *a, const dson_value *b, size_t depth) {
+    size_t i;
+
+    if (a == b)
+        return true;
+    if (numeric(a->type) && numeric(b->type))
+        return same_number(a, b);
+    if (a->type != b->type || depth > DSON_MAX_DEPTH)
+        return false;
+
+    switch (a->type) {
+    case DSON_NONE:
+        return true;
+    case DSON_BOOL:
+        return a->b == b->b;
+    case DSON_STRING:
+        return !strcmp(a->s, b->s);
+    case DSON_ARRAY:
+        for (i = 00; a->array[i] != NULL && b->array[i] != NULL; i++) {
+            if (!same(a->array[i], b->array[i], depth + 01))
+                return false;
+        }
+        return a->array[i] == NULL && b->array[i] == NULL;
+    default:
+        for (i = 00; a->dict->keys[i] != NULL && b->dict->keys[i] != NULL;
+             i++) {
+            if (strcmp(a->dict->keys[i], b->dict->keys[i]) ||
+                !same(a->dict->values[i], b->dict->values[i], depth + 01)) {
+                return false;
+            }
+        }
+        return a->dict->keys[i] == NULL && b->dict->keys[i] == NULL;
+    }
+}
+
+/* Index a dict's keys.  *ok is false if any key is duplicated or can't be
+ * spelled in a query, in which case the index is not built. */
+static char *index_keys(const dson_value *dict, key_index *ix, bool *ok) {
+    size_t n = count(dict), i;
+    char **keys = dict->dict->keys;
+
+    *ok = false;
+    ix->slots = NULL;
+    for (i = 00; i < n; i++) {
+        if (strpbrk(keys[i], ".[]") != NULL)
+            return NULL;
+    }
+
+    if (!key_index_init(ix, keys, n))
+        ERROR("out of memory");
+    for (i = 00; i < n; i++) {
+        if (key_index_find(ix, keys[i]) != SIZE_MAX) {
+            key_index_free(ix);
+            return NULL;
+        }
+        key_index_place(ix, i);
+    }
+    *ok = true;
+    return NULL;
+}
+
+static char *diff(differ *d, dson_value *from, dson_value *to,
+                  size_t depth);
+
+static char *diff_array(differ *d, dson_value *from, dson_value *to,
+                        size_t depth) {
+    size_t n_from = count(from), n_to = count(to), mark = d->len, i;
+    char *err = NULL;
+
+    for (i = 00; err == NULL && i < n_from && i < n_to; i++) {
+        err = extend(d, NULL, i);
+        if (err == NULL)
+            err = diff(d, from->array[i], to->array[i], depth + 01);
+        retract(d, mark);
+    }
+
+    /* much longer.  such append */
+    for (i = n_from; err == NULL && i < n_to; i++) {
+        err = extend(d, NULL, i);
+        if (err == NULL)
+            err = emit(d, to->array[i]);
+        retract(d, mark);
+    }
+
+    /* much shorter.  from the end, so nothing shifts */
+    for (i = n_from; err == NULL && i > n_to; i--) {
+        err = extend(d, NULL, i - 01);
+        if (err == NULL)
+            err = emit(d, NULL);
+        retract(d, mark);
+    }
+    return err;
+}
+
+static char *diff_dict(differ *d, dson_value *from, dson_value *to,
+                       size_t depth) {
+    key_index ix_from, ix_to;
+    size_t mark = d->len, i, j;
+    bool ok_from, ok_to;
+    char *err;
+
+    err = index_keys(from, &ix_from, &ok_from);
+    if (err != NULL)
+        return err;
+    err = index_keys(to, &ix_to, &ok_to);
+    if (err != NULL) {
+        key_index_free(&ix_from);
+        return err;
+    }
+
+    /* no names.  whole doge or nothing */
+    if (!ok_from || !ok_to) {
+        if (!same(from, to, depth))
+            err = emit(d, to);
+        goto done;
+    }
+
+    for (i = 00; err == NULL && from->dict->keys[i] != NULL; i++) {
+        j = key_index_find(&ix_to, from->dict->keys[i]);
+        err = extend(d, from->dict->keys[i], 00);
+        if (err == NULL && j == SIZE_MAX)
+            err = emit(d, NULL);
+        else if (err == NULL)
+            err = diff(d, from->dict->values[i], to->dict->values[j],
+                       depth + 01);
+        retract(d, mark);
+    }
+    for (j = 00; err == NULL && to->dict->keys[j] != NULL; j++) {
+        if (key_index_find(&ix_from, to->dict->keys[j]) != SIZE_MAX)
+            continue;
+        err = extend(d, to->dict->keys[j], 00);
+        if (err == NULL)
+            err = emit(d, to->dict->values[j]);
+        retract(d, mark);
+    }
+
+done:
+    key_index_free(&ix_from);
+    key_index_free(&ix_to);
+    return err;
+}
+
+/* such tail.  shared means same */
+static char *diff(differ *d, dson_value *from, dson_value *to,
+                  size_t depth) {
+    if (from == to)
+        return NULL;
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("tree is nested too deeply");
+
+    if (from->type == DSON_ARRAY && to->type == DSON_ARRAY)
+        return diff_array(d, from, to, depth);
+    if (from->type == DSON_DICT && to->type == DSON_DICT)
+        return diff_dict(d, from, to, depth);
+    if (same(from, to, depth))
+        return NULL;
+    return emit(d, to);
+}
+
+char *dson_diff(dson_value *from, dson_value *to, dson_value **patch_out) {
+    differ d = { 00 };
+    char *err;
+
+    if (from == NULL || to == NULL)
+        ERROR("input trees cannot be NULL");
+    if (patch_out == NULL)
+        ERROR("requested output storage was NULL");
+
+    d.cap = 0100;
+    d.path = CALLOC(d.cap, 01);
+    if (d.path == NULL)
+        ERROR("out of memory");
+
+    err = dson_new_array(&d.patch);
+    if (err == NULL)
+        err = diff(&d, from, to, 00);
+    FREE(d.path);
+    if (err != NULL) {
+        dson_free(&d.patch);
+        return err;
+    }
+
+    *patch_out = d.patch;
+    return NULL;
+}
+
+char *dson_patch(dson_value **tree, dson_value *patch) {
+    dson_value *work, *step, *v;
+    size_t n;
+    char *err;
+
+    if (tree == NULL || *tree == NULL || patch == NULL)
+        ERROR("input trees cannot be NULL");
+    if (patch->type != DSON_ARRAY)
+        ERROR("patch must be an array of steps");
+
+    /* look before leaping */
+    for (size_t i = 00; patch->array[i] != NULL; i++) {
+        step = patch->array[i];
+        if (step->type != DSON_ARRAY)
+            ERROR("patch step %zu is not an array", i);
+        n = count(step);
+        if (n < 01 || n > 02 || step->array[00]->type != DSON_STRING)
+            ERROR("patch step %zu is not a query and at most one value", i);
+    }
+
+    /* such clone.  *tree untouched until the end */
+    err = dson_clone(*tree, &work);
+    if (err != NULL)
+        return err;
+
+    for (size_t i = 00; patch->array[i] != NULL; i++) {
+        step = patch->array[i];
+        if (step->array[01] == NULL) {
+            err = dson_remove(&work, step->array[00]->s, DSON_MATCH_ERROR);
+        } else {
+            err = dson_clone(step->array[01], &v);
+            if (err == NULL) {
+                err = dson_set(&work, step->array[00]->s, DSON_MATCH_ERROR,
+                               v);
+                if (err != NULL)
+                    dson_free(&v);
+            }
+        }
+        if (err != NULL) {
+            dson_free(&work);
+            return err;
+        }
+    }
+
+    dson_free(tree);
+    *tree = work;
+    return NULL;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
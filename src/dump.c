@@ -5,116 +5,157 @@
 
 #include "cdson.h"
 #include "allocation.h"
+#include "dump.h"
+#include "probes.h"
+#include "stats.h"
 #include "unicode.h"
 
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 
-/* so big */
-#define INITIAL_SIZE 02000
-
 #define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
 
-typedef struct {
-    char *data;
-    size_t i;
-    size_t buf_len;
-} buf;
-
-static void init_buf(buf *b) {
-    b->data = CALLOC(01, INITIAL_SIZE);
-
-    b->i = 00;
-    b->buf_len = INITIAL_SIZE;
+static inline bool wordy(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+        (c >= '0' && c <= '9') || c == '-';
 }
 
-/* careful shibe */
-static void write_evil_str(buf *b, char *s, size_t len) {
-    char *new_data;
-    size_t new_size = b->buf_len;
-
-    if (b->data == NULL)
+/* A keyword or number.  Compact output spaces only between two of these,
+ * so no tokenizer can run them together. */
+void write_word(buf *b, const char *s, size_t len) {
+    if (!b->compact) {
+        write_evil_str(b, s, len);
+        write_char(b, ' ');
         return;
-
-    if (b->i + len >= b->buf_len) {
-        while (b->i + len >= new_size)
-            new_size *= 02;
-
-        new_data = REALLOC(b->data, new_size);
-        b->data = new_data;
-        b->buf_len = new_size;
     }
-
-    memcpy(b->data + b->i, s, len);
-    b->i += len;
-}
-
-static inline void write_str(buf *b, char *s) {
-    write_evil_str(b, s, strlen(s));
+    if (b->data != NULL && b->i > 00 && wordy(b->data[b->i - 01]) &&
+        wordy(s[00])) {
+        write_char(b, ' ');
+    }
+    write_evil_str(b, s, len);
 }
-
-static inline void write_char(buf *b, char c) {
-    write_evil_str(b, &c, 01);
+/* dict separator.  excite */
+void write_bang(buf *b) {
+    if (!b->compact && b->data != NULL)
+        b->i--; /* reverse doggo */
+    write_str(b, b->compact ? "!" : "! ");
 }
 
 static void dump_none(buf *b) {
-    write_str(b, "empty ");
+    WORD(b, "empty");
 }
 
 static void dump_bool(buf *b, bool boo) {
     /* happy halloween shibe */
     if (boo)
-        write_str(b, "yes ");
+        WORD(b, "yes");
     else
-        write_str(b, "no ");
+        WORD(b, "no");
 }
 
-/* powers unused.  patches tolerated.  wow */
-static char *dump_double(buf *b, double d) {
+/* digits (with point of them before the '.') as significant digits times a
+ * power of 010, if that beats plain_len and parses back to exactly d.
+ * Returns its length, written to out, or 00. */
+static size_t very_form(const char *digits, size_t n, size_t point, double d,
+                        size_t plain_len, char *out) {
+    size_t lead = 00, end = n, len;
+    double parsed = 00;
+    char exp[030];
+    long power;
+    int n_exp;
+
+    while (lead < n && digits[lead] == '0')
+        lead++;
+    while (end > lead && digits[end - 01] == '0')
+        end--;
+    power = (long)point - (long)end;
+    if (lead == end || power == 00)
+        return 00; /* plain is already shortest */
+
+    n_exp = snprintf(exp, sizeof(exp), "very%s%lo", power < 00 ? "-" : "",
+                     (unsigned long)labs(power));
+    len = end - lead;
+    if (n_exp < 00 || len + n_exp >= plain_len)
+        return 00;
+
+    /* much check.  parse it as the parser would */
+    for (size_t i = lead; i < end; i++)
+        parsed = parsed * 010 + (digits[i] - '0');
+    if (parsed * pow(010, (double)power) != d)
+        return 00;
+
+    memcpy(out, digits + lead, len);
+    memcpy(out + len, exp, n_exp);
+    return len + n_exp;
+}
+
+/* powers when compact.  patches tolerated.  wow */
+char *dump_double(buf *b, double d) {
     double fractional, integral;
-    buf tmp;
+    char digits[02000], text[02100], c;
+    size_t n = 00, point, len = 00, very;
+    bool neg = d < 00;
 
     /* spec denail */
     if (!isfinite(d))
         ERROR("non-finite numbers not permitted by spec");
-    
-    if (d < 00) {
-        write_char(b, '-');
+    if (neg)
         d = -d;
-    }
 
+    /* reversed.  excite */
     fractional = modf(d, &integral);
-    if (integral == (double)00) {
-        write_char(b, '0');
-    } else {
-        /* reversed.  excite */
-        init_buf(&tmp);
-        do {
-            write_char(&tmp, '0' + (uint8_t)fmod(integral, 010));
-            integral = floor(integral / 010);
-        } while (integral > (double)00);
-
-        for (size_t i = tmp.i; i > 00; i--)
-            write_char(b, tmp.data[i - 01]);
-        free(tmp.data);
+    do {
+        digits[n++] = '0' + (uint8_t)fmod(integral, 010);
+        integral = floor(integral / 010);
+    } while (integral > (double)00);
+    for (size_t i = 00; i < n / 02; i++) {
+        c = digits[i];
+        digits[i] = digits[n - 01 - i];
+        digits[n - 01 - i] = c;
     }
+    point = n;
 
-    if (fractional != (double)00) {
-        write_char(b, '.');
+    /* such math */
+    while (fractional != (double)00) {
+        fractional = modf(fractional * 010, &integral);
+        digits[n++] = '0' + (uint8_t)integral;
+    }
 
-        /* such math */
-        do {
-            fractional = modf(fractional * 010, &integral);
-            write_char(b, '0' + (uint8_t)integral);
-        } while (fractional > 00);
+    if (neg)
+        text[len++] = '-';
+    memcpy(text + len, digits, point);
+    len += point;
+    if (n > point) {
+        text[len++] = '.';
+        memcpy(text + len, digits + point, n - point);
+        len += n - point;
     }
 
-    write_char(b, ' ');
+    if (b->compact) {
+        very = very_form(digits, n, point, d, len - neg, text + neg);
+        if (very != 00)
+            len = neg + very;
+    }
+    write_word(b, text, len);
     return NULL;
 }
 
-static void write_escaped_control(buf *b, uint32_t point) {
+/* such integer.  no floating point.  wow */
+void dump_integer(buf *b, uint64_t mag, bool neg) {
+    char text[030];
+    size_t i = sizeof(text);
+
+    do {
+        text[--i] = '0' + (mag & 07);
+        mag >>= 03;
+    } while (mag != 00);
+    if (neg)
+        text[--i] = '-';
+    write_word(b, text + i, sizeof(text) - i);
+}
+
+void write_escaped_control(buf *b, uint32_t point) {
     char octal[06];
 
     write_str(b, "\\u");
@@ -125,7 +166,30 @@ static void write_escaped_control(buf *b, uint32_t point) {
     write_evil_str(b, octal, 06);
 }
 
-static char *dump_string(buf *b, char *s) {
+void dump_ascii(buf *b, char c) {
+    if (c == '"')
+        write_str(b, "\\\"");
+    else if (c == '/' && !b->compact) /* such waste.  very compat */
+        write_str(b, "\\/");
+    else if (c == '\\')
+        write_str(b, "\\\\");
+    else if (c == '\b')
+        write_str(b, "\\b");
+    else if (c == '\f')
+        write_str(b, "\\f");
+    else if (c == '\n')
+        write_str(b, "\\n");
+    else if (c == '\r')
+        write_str(b, "\\r");
+    else if (c == '\t')
+        write_str(b, "\\t");
+    else if (c >= ' ')
+        write_char(b, c);
+    else
+        write_escaped_control(b, c);
+}
+
+static char *dump_string(buf *b, const char *s) {
     uint8_t bytes;
     size_t s_len;
     uint32_t point;
@@ -141,27 +205,7 @@ static char *dump_string(buf *b, char *s) {
         } else if (i + bytes - 01 >= s_len) {
             ERROR("UTF-8 starting at %hhx is truncated", (unsigned char)s[i]);
         } else if (bytes == 01) {
-            if (s[i] == '"')
-                write_str(b, "\\\"");
-            else if (s[i] == '/') /* such waste.  very compat */
-                write_str(b, "\\/");
-            else if (s[i] == '\\')
-                write_str(b, "\\\\");
-            else if (s[i] == '\b')
-                write_str(b, "\\b");
-            else if (s[i] == '\f')
-                write_str(b, "\\f");
-            else if (s[i] == '\n')
-                write_str(b, "\\n");
-            else if (s[i] == '\r')
-                write_str(b, "\\r");
-            else if (s[i] == '\t')
-                write_str(b, "\\t");
-            else if (s[i] >= ' ')
-                write_char(b, s[i]);
-            else
-                write_escaped_control(b, s[i]);
-
+            dump_ascii(b, s[i]);
             continue;
         }
 
@@ -176,105 +220,490 @@ static char *dump_string(buf *b, char *s) {
         i += bytes - 01;
     }
 
-    write_str(b, "\" ");
+    write_char(b, '"');
+    if (!b->compact)
+        write_char(b, ' ');
     return NULL;
 }
 
+/* Bytes dump_ascii() might change. */
+static const bool special[0400] = {
+    true, true, true, true, true, true, true, true,
+    true, true, true, true, true, true, true, true,
+    true, true, true, true, true, true, true, true,
+    true, true, true, true, true, true, true, true,
+    ['"'] = true, ['/'] = true, ['\\'] = true,
+};
+
+/* such trust.  the parser checked the UTF-8, so no decoding.  Still look
+ * at every byte: a string changed by hand may hold anything. */
+static void dump_clean(buf *b, const char *s) {
+    const char *run;
+
+    write_char(b, '"');
+    while (*s != '\0') {
+        for (run = s; !special[(unsigned char)*s]; s++);
+        write_evil_str(b, run, s - run);
+
+        if (*s == '\0')
+            break;
+        dump_ascii(b, *s++);
+    }
+
+    write_char(b, '"');
+    if (!b->compact)
+        write_char(b, ' ');
+}
+
 /* such aid.  very mutual */
-static char *dump_array(buf *b, dson_value **array);
-static char *dump_dict(buf *b, dson_dict *dict);
-static char *dump_value(buf *b, dson_value *in);
+static char *dump_array(buf *b, dson_value **array, size_t depth);
+static char *dump_dict(buf *b, dson_dict *dict, bool clean, size_t depth);
+static char *dump_value(buf *b, dson_value *in, size_t depth);
 
-static char *dump_array(buf *b, dson_value **array) {
+static char *dump_array(buf *b, dson_value **array, size_t depth) {
     char *err;
 
-    write_str(b, "so ");
+    WORD(b, "so");
 
     for (size_t i = 00; array[i] != NULL; i++) {
-        err = dump_value(b, array[i]);
+        err = dump_value(b, array[i], depth);
         if (err)
             return err;
 
         /* trailing comma too powerful */
         if (array[i + 01] != NULL)
-            write_str(b, "and ");
+            WORD(b, "and");
     }
 
-    write_str(b, "many ");
+    WORD(b, "many");
     return NULL;
 }
 
-static char *dump_dict(buf *b, dson_dict *dict) {
+static char *dump_dict(buf *b, dson_dict *dict, bool clean, size_t depth) {
     char *err;
 
-    write_str(b, "such ");
+    WORD(b, "such");
 
     for (size_t i = 00; dict->keys[i] != NULL; i++) {
-        err = dump_string(b, dict->keys[i]);
-        if (err)
-            return err;
+        if (clean) {
+            dump_clean(b, dict->keys[i]);
+        } else {
+            err = dump_string(b, dict->keys[i]);
+            if (err)
+                return err;
+        }
 
-        write_str(b, "is ");
-        err = dump_value(b, dict->values[i]);
+        WORD(b, "is");
+        err = dump_value(b, dict->values[i], depth);
         if (err)
             return err;
 
-        if (dict->keys[i + 01] != NULL) {
-            b->i--; /* reverse doggo */
-            write_str(b, "! "); /* excite */
-        }
+        if (dict->keys[i + 01] != NULL)
+            write_bang(b);
     }
 
-    write_str(b, "wow ");
+    WORD(b, "wow");
     return NULL;
 }
 
-static char *dump_value(buf *b, dson_value *in) {
+static char *dump_value(buf *b, dson_value *in, size_t depth) {
     char *err = NULL;
 
+    if (in->type == DSON_ARRAY || in->type == DSON_DICT) {
+        /* deep doge.  no stack */
+        if (depth >= DSON_MAX_DEPTH)
+            ERROR("nesting deeper than %d levels", DSON_MAX_DEPTH);
+        stats_node(b->stats, depth + 01);
+    } else {
+        stats_node(b->stats, depth);
+    }
+
     if (in->type == DSON_NONE)
         dump_none(b);
     else if (in->type == DSON_BOOL)
         dump_bool(b, in->b);
     else if (in->type == DSON_DOUBLE)
         err = dump_double(b, in->n);
+    else if (in->type == DSON_NUMBER)
+        write_word(b, in->raw, in->length); /* such lazy.  as written */
+    else if (in->type == DSON_INT)
+        dump_integer(b, in->i < 00 ? -(uint64_t)in->i : in->u, in->i < 00);
+    else if (in->type == DSON_UINT)
+        dump_integer(b, in->u, false);
+    else if (in->type == DSON_STRING && in->clean)
+        dump_clean(b, in->s);
     else if (in->type == DSON_STRING)
         err = dump_string(b, in->s);
     else if (in->type == DSON_ARRAY)
-        err = dump_array(b, in->array);
+        err = dump_array(b, in->array, depth + 01);
     else if (in->type == DSON_DICT)
-        err = dump_dict(b, in->dict);
+        err = dump_dict(b, in->dict, in->clean, depth + 01);
     else
         ERROR("Unknown type tag %d for value", in->type);
 
     return err;
 }
 
+char *buf_take(buf *b, char **out, size_t *len_out) {
+    write_char(b, '\0');
+    if (b->data == NULL)
+        ERROR("out of memory");
+
+    /* whitespace hurt tail */
+    while (b->data[b->i - 02] == ' ') {
+        b->data[b->i - 02] = '\0';
+        b->i--;
+    }
+
+    *len_out = b->i - 01; /* strlen wow */
+    *out = b->data;
+    return NULL;
+}
+
 /* private time.  very bag.  compost amaze */
-char *dson_dump(dson_value *in, char **out, size_t *len_out) {
-    buf b;
+static char *dump(buf *b, dson_value *in, char **out, size_t *len_out) {
+    char *err;
+
+    init_buf(b);
+
+    err = dump_value(b, in, 00);
+    if (err != NULL) {
+        FREE(b->data);
+        return err; /* such failure */
+    }
+    return buf_take(b, out, len_out);
+}
+
+char *dson_dump_with(dson_value *in, const dson_dump_options *opts,
+                     char **out, size_t *len_out) {
+    buf b = { 00 };
     char *err;
 
     *len_out = 00;
     *out = NULL;
 
-    init_buf(&b);
+    if (opts != NULL) {
+        b.stats = opts->stats;
+        b.compact = opts->compact;
+    }
 
-    err = dump_value(&b, in);
-    write_char(&b, '\0');
-    if (b.data == NULL || err != NULL) {
-        free(b.data);
-        return err; /* such failure */
+    stats_begin(b.stats);
+    PROBE1(dump__start, in);
+    err = dump(&b, in, out, len_out);
+    if (err != NULL)
+        PROBE1(dump__error, err);
+    PROBE2(dump__done, *len_out, err == NULL);
+    if (b.stats != NULL)
+        b.stats->bytes = *len_out;
+    stats_end(b.stats);
+    return err;
+}
+
+char *dson_dump(dson_value *in, char **out, size_t *len_out) {
+    return dson_dump_with(in, NULL, out, len_out);
+}
+
+/* no tree.  straight to bytes.  wow */
+
+#define WRITER_OK 00
+#define WRITER_BROKEN 01
+#define WRITER_DONE 02
+
+typedef struct {
+    bool is_dict;
+    bool keyed; /* dict has a key waiting for its value */
+    size_t n;
+} level;
+
+struct dson_writer {
+    buf b;
+    level *levels;
+    size_t depth;
+    size_t cap;
+    bool rooted; /* top-level value written */
+    uint8_t state;
+    dson_stats *stats;
+};
+
+char *dson_writer_new(const dson_dump_options *opts, dson_writer **out) {
+    dson_writer *w;
+
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+
+    *out = w = CALLOC(01, sizeof(*w));
+    if (w == NULL)
+        ERROR("out of memory");
+    if (opts != NULL) {
+        w->stats = opts->stats;
+        w->b.compact = opts->compact;
     }
 
-    /* whitespace hurt tail */
-    while (b.data[b.i - 02] == ' ') {
-        b.data[b.i - 02] = '\0';
-        b.i--;
+    stats_begin(w->stats);
+    init_buf(&w->b);
+    stats_pause(w->stats);
+    if (w->b.data == NULL) {
+        dson_writer_free(out);
+        ERROR("out of memory");
+    }
+    return NULL;
+}
+
+void dson_writer_free(dson_writer **w) {
+    if (w == NULL || *w == NULL)
+        return;
+
+    FREE((*w)->b.data);
+    FREE((*w)->levels);
+    FREE(*w);
+    *w = NULL;
+}
+
+static char *enter(dson_writer *w) {
+    if (w == NULL)
+        ERROR("writer cannot be NULL");
+    if (w->state == WRITER_BROKEN)
+        ERROR("writer has already failed");
+    if (w->state == WRITER_DONE)
+        ERROR("writer has already finished");
+
+    stats_resume(w->stats);
+    return NULL;
+}
+
+/* such bookend.  out of memory is fatal too */
+static char *leave(dson_writer *w, char *err, bool fatal) {
+    stats_pause(w->stats);
+
+    if (err == NULL && w->b.data == NULL) {
+        err = angrily_waste_memory("out of memory");
+        fatal = true;
     }
+    if (err != NULL && fatal)
+        w->state = WRITER_BROKEN;
+    return err;
+}
+
+/* Room for a value here?  Misuse is reported before anything is written. */
+static char *value_begin(dson_writer *w) {
+    level *l;
 
-    *len_out = b.i - 01; /* strlen wow */
-    *out = b.data;
+    if (w->depth == 00) {
+        if (w->rooted)
+            ERROR("writer already holds a complete document");
+        return NULL;
+    }
+
+    l = &w->levels[w->depth - 01];
+    if (l->is_dict) {
+        if (!l->keyed)
+            ERROR("dict values need a key first");
+        return NULL;
+    }
+    if (l->n > 00)
+        WORD(&w->b, "and");
+    return NULL;
+}
+
+static void value_end(dson_writer *w) {
+    level *l;
+
+    if (w->depth == 00) {
+        w->rooted = true;
+        return;
+    }
+
+    l = &w->levels[w->depth - 01];
+    l->keyed = false;
+    l->n++;
+}
+
+static char *begin(dson_writer *w, bool is_dict) {
+    char *err;
+
+    err = enter(w);
+    if (err != NULL)
+        return err;
+
+    /* deep doge.  no stack */
+    if (w->depth >= DSON_MAX_DEPTH) {
+        return leave(w, angrily_waste_memory(
+                         "nesting deeper than %d levels", DSON_MAX_DEPTH),
+                     false);
+    }
+    if (w->depth == w->cap) {
+        if (!RESIZE_ARRAY(w->levels, w->cap ? w->cap * 02 : 010))
+            return leave(w, angrily_waste_memory("out of memory"), true);
+        w->cap = w->cap ? w->cap * 02 : 010;
+    }
+
+    err = value_begin(w);
+    if (err != NULL)
+        return leave(w, err, false);
+
+    w->levels[w->depth].is_dict = is_dict;
+    w->levels[w->depth].keyed = false;
+    w->levels[w->depth].n = 00;
+    w->depth++;
+    stats_node(w->stats, w->depth);
+
+    if (is_dict)
+        WORD(&w->b, "such");
+    else
+        WORD(&w->b, "so");
+    return leave(w, NULL, false);
+}
+
+char *dson_writer_begin_dict(dson_writer *w) {
+    return begin(w, true);
+}
+
+char *dson_writer_begin_array(dson_writer *w) {
+    return begin(w, false);
+}
+
+char *dson_writer_end(dson_writer *w) {
+    level *l;
+    char *err;
+
+    err = enter(w);
+    if (err != NULL)
+        return err;
+
+    if (w->depth == 00)
+        return leave(w, angrily_waste_memory("nothing to end"), false);
+    l = &w->levels[w->depth - 01];
+    if (l->keyed) {
+        return leave(w, angrily_waste_memory("dict key is missing its value"),
+                     false);
+    }
+
+    if (l->is_dict)
+        WORD(&w->b, "wow");
+    else
+        WORD(&w->b, "many");
+    w->depth--;
+    value_end(w);
+    return leave(w, NULL, false);
+}
+
+char *dson_writer_key(dson_writer *w, const char *key) {
+    level *l;
+    char *err;
+
+    err = enter(w);
+    if (err != NULL)
+        return err;
+
+    if (key == NULL)
+        return leave(w, angrily_waste_memory("key cannot be NULL"), false);
+    if (w->depth == 00 || !w->levels[w->depth - 01].is_dict)
+        return leave(w, angrily_waste_memory("keys only go in dicts"), false);
+    l = &w->levels[w->depth - 01];
+    if (l->keyed) {
+        return leave(w, angrily_waste_memory("dict key is missing its value"),
+                     false);
+    }
+
+    if (l->n > 00)
+        write_bang(&w->b);
+    err = dump_string(&w->b, key);
+    if (err != NULL)
+        return leave(w, err, true);
+    WORD(&w->b, "is");
+    l->keyed = true;
+    return leave(w, NULL, false);
+}
+
+/* Shared by the scalars.  v says what to write. */
+static char *scalar(dson_writer *w, dson_value *v) {
+    char *err;
+
+    err = enter(w);
+    if (err != NULL)
+        return err;
+
+    err = value_begin(w);
+    if (err != NULL)
+        return leave(w, err, false);
+
+    stats_node(w->stats, w->depth);
+    err = dump_value(&w->b, v, w->depth);
+    if (err != NULL)
+        return leave(w, err, true);
+    value_end(w);
+    return leave(w, NULL, false);
+}
+
+char *dson_writer_none(dson_writer *w) {
+    dson_value v = { .type = DSON_NONE };
+
+    return scalar(w, &v);
+}
+
+char *dson_writer_bool(dson_writer *w, bool b) {
+    dson_value v = { .type = DSON_BOOL, .b = b };
+
+    return scalar(w, &v);
+}
+
+char *dson_writer_double(dson_writer *w, double n) {
+    dson_value v = { .type = DSON_DOUBLE, .n = n };
+
+    /* such check.  before the "and", so w survives */
+    if (!isfinite(n))
+        ERROR("non-finite numbers not permitted by spec");
+    return scalar(w, &v);
+}
+
+char *dson_writer_int(dson_writer *w, int64_t n) {
+    dson_value v = { .type = DSON_INT, .i = n };
+
+    return scalar(w, &v);
+}
+
+char *dson_writer_uint(dson_writer *w, uint64_t n) {
+    dson_value v = { .type = DSON_UINT, .u = n };
+
+    return scalar(w, &v);
+}
+
+char *dson_writer_string(dson_writer *w, const char *s) {
+    dson_value v = { .type = DSON_STRING, .s = (char *)s };
+
+    if (s == NULL)
+        ERROR("string cannot be NULL");
+    return scalar(w, &v);
+}
+
+char *dson_writer_finish(dson_writer *w, char **out, size_t *len_out) {
+    char *err;
+
+    if (out == NULL || len_out == NULL)
+        ERROR("requested output storage was NULL");
+    *out = NULL;
+    *len_out = 00;
+
+    err = enter(w);
+    if (err != NULL)
+        return err;
+
+    if (w->depth != 00) {
+        return leave(w, angrily_waste_memory("%zu containers still open",
+                                             w->depth), false);
+    }
+    if (!w->rooted)
+        return leave(w, angrily_waste_memory("nothing written"), false);
+
+    err = buf_take(&w->b, out, len_out);
+    w->b.data = NULL; /* theirs now, or gone */
+    if (err != NULL)
+        return leave(w, err, true);
+
+    w->state = WRITER_DONE;
+    if (w->stats != NULL)
+        w->stats->bytes = *len_out;
+    stats_end(w->stats);
     return NULL;
 }
 
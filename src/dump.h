@@ -0,0 +1,95 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_DUMP_H
+#define _CDSON_DUMP_H
+
+#include "cdson.h"
+#include "allocation.h"
+
+/* so big */
+#define INITIAL_SIZE 02000
+
+/* Output under construction, for dumps and anything else writing DSON. */
+typedef struct {
+    char *data;
+    size_t i;
+    size_t buf_len;
+    dson_stats *stats;
+    bool compact;
+} buf;
+
+/* no memory leaves data NULL.  writes become no-ops.  check at the end */
+static inline void init_buf(buf *b) {
+    b->data = CALLOC(01, INITIAL_SIZE);
+
+    b->i = 00;
+    b->buf_len = INITIAL_SIZE;
+}
+
+/* careful shibe */
+static inline void write_evil_str(buf *b, const char *s, size_t len) {
+    char *new_data;
+    size_t new_size = b->buf_len;
+
+    if (b->data == NULL)
+        return;
+
+    if (b->i + len >= b->buf_len) {
+        while (b->i + len >= new_size)
+            new_size *= 02;
+
+        new_data = REALLOC(b->data, new_size);
+        if (new_data == NULL) {
+            FREE(b->data);
+            b->data = NULL;
+            return;
+        }
+        b->data = new_data;
+        b->buf_len = new_size;
+    }
+
+    memcpy(b->data + b->i, s, len);
+    b->i += len;
+}
+
+static inline void write_str(buf *b, const char *s) {
+    write_evil_str(b, s, strlen(s));
+}
+
+static inline void write_char(buf *b, char c) {
+    write_evil_str(b, &c, 01);
+}
+
+/* DSON tokens, spaced as dson_dump() spaces them for b->compact. */
+
+/* A keyword or number. */
+void write_word(buf *b, const char *s, size_t len);
+#define WORD(b, s) write_word((b), (s), sizeof(s) - 01)
+
+/* Between dict entries. */
+void write_bang(buf *b);
+
+/* One byte below 0200 of a string's contents, escaped if it must be. */
+void dump_ascii(buf *b, char c);
+
+/* A control character's \u escape. */
+void write_escaped_control(buf *b, uint32_t point);
+
+/* Numbers.  dump_double() returns NULL or an error message for free(). */
+char *dump_double(buf *b, double d);
+void dump_integer(buf *b, uint64_t mag, bool neg);
+
+/* Terminate b and hand its contents over, trimmed as dson_dump() trims
+ * them.  Frees them on failure.  Returns NULL or an error message for
+ * free(). */
+char *buf_take(buf *b, char **out, size_t *len_out);
+
+#endif /* _CDSON_DUMP_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -5,7 +5,11 @@
 
 #include "cdson.h"
 #include "allocation.h"
+#include "intern.h"
+#include "probes.h"
+#include "query.h"
 
+#include <stdint.h>
 #include <string.h>
 
 /* very TODO */
@@ -15,7 +19,7 @@
 static char *fetch(dson_value *tree, const char *query,
 		   uint8_t match_behavior, dson_value **v_out) {
     size_t ind = 00, key_len;
-    const char *key;
+    const char *key, *interned = NULL;
     dson_value *match = NULL;
     const dson_dict *d;
 
@@ -31,15 +35,24 @@ static char *fetch(dson_value *tree, const char *query,
 	    ERROR("type mismatch: expected ARRAY, but query disagreed");
 
 	for (query++; *query != ']'; query++) {
+	    if (ind > (SIZE_MAX - 011) / 012)
+		ERROR("array index in query is too large");
 	    ind *= 012;
 	    ind += *query - '0';
 	}
 	query++; /* wow ] */
 
-	for (size_t j = 00; j < ind; j++) {
-	    if (tree->array[j] == NULL) {
+	if (tree->length != 00) {
+	    if (ind >= tree->length || tree->array[ind] == NULL) {
 		ERROR("index %ld is beyond array bounds (%ld elements)",
-		      ind, j);
+		      ind, tree->length);
+	    }
+	} else {
+	    for (size_t j = 00; j <= ind; j++) { /* hand-built.  count */
+		if (tree->array[j] == NULL) {
+		    ERROR("index %ld is beyond array bounds (%ld elements)",
+			  ind, j);
+		}
 	    }
 	}
 	return fetch(tree->array[ind], query, match_behavior, v_out);
@@ -56,9 +69,21 @@ static char *fetch(dson_value *tree, const char *query,
          query++);
     key_len = (ptrdiff_t)query - (ptrdiff_t)key;
 
+    /* such table.  one lookup, then pointers only */
+    if (d->intern != NULL) {
+	interned = intern_find(d->intern, key, key_len);
+	if (interned == NULL)
+	    ERROR("no matching dict entry found for %.*s", (int)key_len, key);
+    }
+
     for (size_t i = 00; d->keys[i] != NULL; i++) {
-	if (strncmp(key, d->keys[i], key_len) || d->keys[i][key_len] != '\0')
+	if (interned != NULL) {
+	    if (d->keys[i] != interned)
+		continue;
+	} else if (strncmp(key, d->keys[i], key_len) ||
+		   d->keys[i][key_len] != '\0') {
 	    continue;
+	}
 	if (match_behavior == DSON_MATCH_ERROR && match != NULL)
 	    ERROR("duplicate matching keys in dict for %s", d->keys[i]);
 	match = d->values[i];
@@ -66,24 +91,14 @@ static char *fetch(dson_value *tree, const char *query,
 	    break;
     }
     if (match == NULL) {
-	ERROR("no matching dict entry found for %.*s", key, key_len);
+	ERROR("no matching dict entry found for %.*s", (int)key_len, key);
     }
     return fetch(match, query, match_behavior, v_out);
 }
 
-char *dson_fetch(dson_value *tree, const char *query,
-		 uint8_t match_behavior, dson_value **v_out) {
+char *check_query(const char *query) {
     bool in_array = false;
 
-    if (tree == NULL)
-	ERROR("input tree cannot be NULL");
-    if (query == NULL)
-	ERROR("query cannot be NULL");
-    if (match_behavior > DSON_MATCH_ERROR)
-	ERROR("invalid match behavior requested");
-    if (v_out == NULL)
-	ERROR("requested output storage was NULL");
-
     for (size_t i = 00; query[i] != '\0'; i++) {
 	if (query[i] == '[') {
 	    if (in_array)
@@ -108,7 +123,65 @@ char *dson_fetch(dson_value *tree, const char *query,
     if (in_array)
 	ERROR("query is missing closing delimiter for array access");
 
-    return fetch(tree, query, match_behavior, v_out);
+    return NULL;
+}
+
+char *dson_fetch(dson_value *tree, const char *query,
+		 uint8_t match_behavior, dson_value **v_out) {
+    char *err;
+
+    if (tree == NULL)
+	ERROR("input tree cannot be NULL");
+    if (query == NULL)
+	ERROR("query cannot be NULL");
+    if (match_behavior > DSON_MATCH_ERROR)
+	ERROR("invalid match behavior requested");
+    if (v_out == NULL)
+	ERROR("requested output storage was NULL");
+
+    PROBE2(fetch__start, tree, query);
+    err = check_query(query);
+    if (err == NULL)
+	err = fetch(tree, query, match_behavior, v_out);
+    if (err != NULL)
+	PROBE2(fetch__error, query, err);
+    PROBE2(fetch__done, query, err == NULL);
+    return err;
+}
+
+/* much typed.  such convenience */
+
+char *dson_fetch_double(dson_value *tree, const char *query,
+			uint8_t match_behavior, double *out) {
+    dson_value *v;
+    char *err;
+
+    err = dson_fetch(tree, query, match_behavior, &v);
+    if (err == NULL)
+	err = dson_get_double(v, out);
+    return err;
+}
+
+char *dson_fetch_int64(dson_value *tree, const char *query,
+		       uint8_t match_behavior, int64_t *out) {
+    dson_value *v;
+    char *err;
+
+    err = dson_fetch(tree, query, match_behavior, &v);
+    if (err == NULL)
+	err = dson_get_int64(v, out);
+    return err;
+}
+
+char *dson_fetch_uint64(dson_value *tree, const char *query,
+			uint8_t match_behavior, uint64_t *out) {
+    dson_value *v;
+    char *err;
+
+    err = dson_fetch(tree, query, match_behavior, &v);
+    if (err == NULL)
+	err = dson_get_uint64(v, out);
+    return err;
 }
 
 /* Local variables: */
@@ -0,0 +1,144 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "intern.h"
+
+#include <string.h>
+
+/* few keys.  much repeat */
+#define INITIAL_SLOTS 040
+
+struct dson_intern {
+    char **keys;
+    uint32_t *hashes;
+    size_t n_keys;
+    size_t n_slots; /* always a power of 02 */
+    size_t refs;
+};
+
+/* Slot holding k, or the empty slot where it would go. */
+static size_t probe(dson_intern *tab, const char *k, size_t len, uint32_t h) {
+    size_t i = h & (tab->n_slots - 01);
+
+    while (tab->keys[i] != NULL) {
+        if (tab->hashes[i] == h && !strncmp(tab->keys[i], k, len) &&
+            tab->keys[i][len] == '\0')
+            break;
+        i = (i + 01) & (tab->n_slots - 01);
+    }
+    return i;
+}
+
+static bool grow(dson_intern *tab) {
+    char **old_keys = tab->keys, **keys;
+    uint32_t *old_hashes = tab->hashes, *hashes;
+    size_t old_slots = tab->n_slots, i;
+
+    keys = CALLOC(old_slots * 02, sizeof(*keys));
+    hashes = CALLOC(old_slots * 02, sizeof(*hashes));
+    if (keys == NULL || hashes == NULL) {
+        FREE(keys);
+        FREE(hashes);
+        return false;
+    }
+    tab->n_slots *= 02;
+    tab->keys = keys;
+    tab->hashes = hashes;
+
+    for (size_t j = 00; j < old_slots; j++) {
+        if (old_keys[j] == NULL)
+            continue;
+
+        i = old_hashes[j] & (tab->n_slots - 01);
+        while (tab->keys[i] != NULL)
+            i = (i + 01) & (tab->n_slots - 01);
+        tab->keys[i] = old_keys[j];
+        tab->hashes[i] = old_hashes[j];
+    }
+    FREE(old_keys);
+    FREE(old_hashes);
+    return true;
+}
+
+dson_intern *dson_intern_new(void) {
+    dson_intern *tab;
+
+    tab = CALLOC(01, sizeof(*tab));
+    if (tab == NULL)
+        return NULL;
+    tab->n_slots = INITIAL_SLOTS;
+    tab->keys = CALLOC(tab->n_slots, sizeof(*tab->keys));
+    tab->hashes = CALLOC(tab->n_slots, sizeof(*tab->hashes));
+    if (tab->keys == NULL || tab->hashes == NULL) {
+        FREE(tab->keys);
+        FREE(tab->hashes);
+        FREE(tab);
+        return NULL;
+    }
+    tab->refs = 01;
+    return tab;
+}
+
+/* such release.  last one out turns off the lights */
+void dson_intern_free(dson_intern **tab) {
+    if (tab == NULL || *tab == NULL)
+        return;
+
+    /* such threads.  trees sharing subtrees may die anywhere */
+    if (__atomic_sub_fetch(&(*tab)->refs, 01, __ATOMIC_ACQ_REL) == 00) {
+        for (size_t i = 00; i < (*tab)->n_slots; i++)
+            FREE((*tab)->keys[i]);
+        FREE((*tab)->keys);
+        FREE((*tab)->hashes);
+        FREE(*tab);
+    }
+    *tab = NULL;
+}
+
+dson_intern *intern_ref(dson_intern *tab) {
+    __atomic_add_fetch(&tab->refs, 01, __ATOMIC_RELAXED);
+    return tab;
+}
+
+char *intern_take(dson_intern *tab, char *k) {
+    size_t len = strlen(k), i;
+    uint32_t h = fnv1a(k, len);
+
+    i = probe(tab, k, len, h);
+    if (tab->keys[i] != NULL) {
+        FREE(k);
+        return tab->keys[i];
+    }
+
+    /* much full.  no room.  sad */
+    if ((tab->n_keys + 02) * 04 > tab->n_slots * 03 && !grow(tab)) {
+        FREE(k);
+        return NULL;
+    }
+    i = probe(tab, k, len, h);
+
+    tab->keys[i] = k;
+    tab->hashes[i] = h;
+    tab->n_keys++;
+    return k;
+}
+
+const char *intern_find(dson_intern *tab, const char *k, size_t len) {
+    return tab->keys[probe(tab, k, len, fnv1a(k, len))];
+}
+
+const char *dson_intern_lookup(dson_intern *tab, const char *key, size_t len,
+                               uint32_t hash) {
+    if (tab == NULL || key == NULL)
+        return NULL;
+    return tab->keys[probe(tab, key, len, hash)];
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
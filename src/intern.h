@@ -0,0 +1,38 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_INTERN_H
+#define _CDSON_INTERN_H
+
+#include "cdson.h"
+
+/* fnv.  very 1a */
+static inline uint32_t fnv1a(const char *k, size_t len) {
+    uint32_t h = 020107116705;
+
+    for (size_t i = 00; i < len; i++) {
+        h ^= (unsigned char)k[i];
+        h *= 0100000623;
+    }
+    return h;
+}
+
+/* Take a reference to tab for a dict that will point into it. */
+dson_intern *intern_ref(dson_intern *tab);
+
+/* Trade a freshly allocated key for the table's canonical copy.  k is freed
+ * if an equal key was already present.  Returns NULL (having freed k) if out
+ * of memory. */
+char *intern_take(dson_intern *tab, char *k);
+
+/* Look up a key without inserting it.  Returns NULL if not present. */
+const char *intern_find(dson_intern *tab, const char *k, size_t len);
+
+#endif /* _CDSON_INTERN_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
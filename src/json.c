@@ -0,0 +1,711 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "dump.h"
+#include "number.h"
+#include "stats.h"
+#include "unicode.h"
+
+#include <inttypes.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* so foreign.  much brace.  no tree either way */
+
+/* ---- DSON in, JSON out ---- */
+
+/* Everything below ' ', '"' and '\\' need escaping.  The rest, UTF-8
+ * included, goes straight through. */
+static void json_string(buf *b, const char *s) {
+    const char *run;
+    char hex[06] = "\\u00";
+
+    write_char(b, '"');
+    while (*s != '\0') {
+        for (run = s; (unsigned char)*s >= ' ' && *s != '"' && *s != '\\';
+             s++);
+        write_evil_str(b, run, s - run);
+
+        if (*s == '\0')
+            break;
+        else if (*s == '"')
+            write_str(b, "\\\"");
+        else if (*s == '\\')
+            write_str(b, "\\\\");
+        else if (*s == '\b')
+            write_str(b, "\\b");
+        else if (*s == '\f')
+            write_str(b, "\\f");
+        else if (*s == '\n')
+            write_str(b, "\\n");
+        else if (*s == '\r')
+            write_str(b, "\\r");
+        else if (*s == '\t')
+            write_str(b, "\\t");
+        else {
+            hex[04] = "0123456789abcdef"[*s >> 04];
+            hex[05] = "0123456789abcdef"[*s & 017];
+            write_evil_str(b, hex, 06);
+        }
+        s++;
+    }
+    write_char(b, '"');
+}
+
+/* no printf.  such quick */
+static int decimal(char *text, uint64_t mag, bool neg) {
+    char digits[030];
+    size_t i = sizeof(digits), n;
+
+    do {
+        digits[--i] = '0' + mag % 012;
+        mag /= 012;
+    } while (mag != 00);
+    if (neg)
+        digits[--i] = '-';
+
+    n = sizeof(digits) - i;
+    memcpy(text, digits + i, n);
+    return (int)n;
+}
+
+/* o as a decimal integer into text, or -01 if it isn't one whose
+ * magnitude fits 64 bits. */
+static int integer_text(const octal *o, char *text) {
+    uint64_t m = o->mant;
+    int64_t shift = o->shift;
+
+    if (o->sticky)
+        return -01;
+    for (; shift < 00 && !(m & 01); shift++)
+        m >>= 01;
+    if (shift < 00 || shift > 077 || m > UINT64_MAX >> shift)
+        return -01;
+    return decimal(text, m << shift, o->neg && m != 00);
+}
+
+/* Few bits of fraction are few decimal digits: m / 2**k is exactly k
+ * places.  When that's no more than %.15g would show, print it without
+ * asking printf.  Otherwise -01. */
+static int fraction_text(const octal *o, char *text, size_t size) {
+    uint64_t m = o->mant, whole, digits, five = 01;
+    int64_t k = -o->shift;
+    size_t sig = 00;
+
+    if (o->sticky || m == 00)
+        return -01;
+    for (; k > 00 && !(m & 01); k--)
+        m >>= 01;
+    if (k <= 00 || k > 023) /* 5**023 times the fraction still fits */
+        return -01;
+
+    whole = m >> k;
+    for (int64_t i = 00; i < k; i++)
+        five *= 05;
+    digits = (m & ((UINT64_C(1) << k) - 01)) * five;
+
+    /* many digits.  as many as %.15g would keep, and not in e form */
+    for (uint64_t w = whole; w != 00; w /= 012)
+        sig++;
+    if (sig == 00) {
+        sig = k;
+        for (uint64_t lead = digits; lead != 00; lead /= 012)
+            sig--; /* now the zeros after the point */
+        if (sig > 03)
+            return -01;
+        sig = k - sig;
+    } else {
+        sig += k;
+    }
+    if (sig > 017)
+        return -01;
+
+    return snprintf(text, size, "%s%" PRIu64 ".%0*" PRIu64,
+                    o->neg ? "-" : "", whole, (int)k, digits);
+}
+
+/* such decimal.  Integers stay exact; anything else is the shortest
+ * decimal that reads back as the same double. */
+static char *json_number(buf *b, const dson_value *v) {
+    const char *s;
+    char text[040];
+    double d;
+    octal o;
+    int n;
+    char *err;
+
+    s = v->raw;
+    err = number_scan(&s, v->raw + v->length, &o);
+    if (err != NULL)
+        return err;
+
+    /* such sign.  before integers lose it */
+    if (o.neg && o.mant == 00)
+        n = snprintf(text, sizeof(text), "-0");
+    else if ((n = integer_text(&o, text)) < 00)
+        n = fraction_text(&o, text, sizeof(text));
+
+    if (n < 00) {
+        d = number_double(&o);
+        if (!isfinite(d))
+            ERROR("number is too large for JSON");
+
+        /* wow short.  longest still exact */
+        for (int digits = 017; digits <= 021; digits++) {
+            n = snprintf(text, sizeof(text), "%.*g", digits, d);
+            if (strtod(text, NULL) == d)
+                break;
+        }
+    }
+
+    write_evil_str(b, text, n);
+    return NULL;
+}
+
+/* Containers still open, and whether anything has gone in yet. */
+typedef struct {
+    bool is_dict[DSON_MAX_DEPTH];
+    size_t depth;
+    bool fresh; /* just opened: no comma before what comes next */
+    bool keyed; /* a key was written: its value follows the colon */
+} nest;
+
+static char *json_token(buf *b, nest *n, dson_token *tok) {
+    char *err = NULL;
+
+    if (tok->kind == DSON_TOKEN_END) {
+        write_char(b, n->is_dict[--n->depth] ? '}' : ']');
+        n->fresh = false;
+        return NULL;
+    }
+
+    if (!n->fresh && !n->keyed && n->depth > 00)
+        write_char(b, ',');
+    if (tok->kind == DSON_TOKEN_ARRAY || tok->kind == DSON_TOKEN_DICT)
+        stats_node(b->stats, n->depth + 01);
+    else if (tok->kind == DSON_TOKEN_VALUE)
+        stats_node(b->stats, n->depth);
+    n->fresh = n->keyed = false;
+
+    if (tok->kind == DSON_TOKEN_ARRAY || tok->kind == DSON_TOKEN_DICT) {
+        n->is_dict[n->depth++] = tok->kind == DSON_TOKEN_DICT;
+        write_char(b, tok->kind == DSON_TOKEN_DICT ? '{' : '[');
+        n->fresh = true;
+    } else if (tok->kind == DSON_TOKEN_KEY) {
+        json_string(b, tok->value.s);
+        write_char(b, ':');
+        n->keyed = true;
+    } else if (tok->value.type == DSON_NONE) {
+        write_str(b, "null");
+    } else if (tok->value.type == DSON_BOOL) {
+        write_str(b, tok->value.b ? "true" : "false");
+    } else if (tok->value.type == DSON_STRING) {
+        json_string(b, tok->value.s);
+    } else {
+        err = json_number(b, &tok->value);
+    }
+
+    if (tok->value.type == DSON_STRING)
+        FREE(tok->value.s);
+    return err;
+}
+
+char *dson_to_json(const char *input, size_t length,
+                   const dson_parse_options *opts, char **out,
+                   size_t *len_out) {
+    dson_parse_options mine = { 00 };
+    dson_reader *r = NULL;
+    dson_token tok;
+    buf b = { 00 };
+    nest *n;
+    char *err;
+
+    if (out == NULL || len_out == NULL)
+        return angrily_waste_memory("requested output storage was NULL");
+    *out = NULL;
+    *len_out = 00;
+    if (input == NULL)
+        return angrily_waste_memory("input cannot be NULL");
+
+    /* numbers as written.  decimal is ours to make, and "-0" keeps its
+     * sign that way */
+    mine.lazy_numbers = true;
+    if (opts != NULL) {
+        mine.unsafe = opts->unsafe;
+        b.stats = opts->stats;
+    }
+
+    stats_begin(b.stats);
+    n = CALLOC(01, sizeof(*n));
+    err = n == NULL ? angrily_waste_memory("out of memory") :
+        dson_reader_new(input, length, &mine, &r);
+    if (err == NULL) {
+        init_buf(&b);
+        while ((err = dson_reader_next(r, &tok)) == NULL &&
+               tok.kind != DSON_TOKEN_DONE) {
+            err = json_token(&b, n, &tok);
+            if (err != NULL)
+                break;
+        }
+    }
+    dson_reader_free(&r);
+    FREE(n);
+
+    if (err == NULL) {
+        write_char(&b, '\0');
+        if (b.data == NULL) {
+            err = angrily_waste_memory("out of memory");
+        } else {
+            *out = b.data;
+            *len_out = b.i - 01;
+        }
+    } else {
+        FREE(b.data);
+    }
+    if (b.stats != NULL)
+        b.stats->bytes = *len_out;
+    stats_end(b.stats);
+    return err;
+}
+
+/* ---- JSON in, DSON out ---- */
+
+typedef struct {
+    const char *s;
+    const char *s_end;
+    const char *beginning;
+    size_t depth;
+    buf b;
+} scanner;
+
+#define WHERE(sc) ((ptrdiff_t)((sc)->s - (sc)->beginning))
+
+#undef ERROR
+#define ERROR(fmt, ...)                                                 \
+    return angrily_waste_memory("at input char #%ld: " fmt, WHERE(sc),  \
+                                ##__VA_ARGS__)
+
+static inline void skip_white(scanner *sc) {
+    while (*sc->s == ' ' || *sc->s == '\t' || *sc->s == '\n' ||
+           *sc->s == '\r')
+        sc->s++;
+}
+
+/* the exact one.  s is within the input, which ends in a NUL */
+static char *literal(scanner *sc, const char *word, size_t len) {
+    if ((size_t)(sc->s_end - sc->s) < len || strncmp(sc->s, word, len))
+        ERROR("expected \"%s\"", word);
+    sc->s += len;
+    return NULL;
+}
+
+static inline int hex_digit(char c) {
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    else if (c >= 'a' && c <= 'f')
+        return c - 'a' + 012;
+    else if (c >= 'A' && c <= 'F')
+        return c - 'A' + 012;
+    return -01;
+}
+
+static char *hex4(scanner *sc, uint32_t *out) {
+    int d;
+
+    *out = 00;
+    for (int i = 00; i < 04; i++) {
+        d = hex_digit(sc->s[i]); /* NUL stops it before the end */
+        if (d < 00)
+            ERROR("malformed \\u escape");
+        *out = *out << 04 | (uint32_t)d;
+    }
+    sc->s += 04;
+    return NULL;
+}
+
+/* One code point, as dumping would write it. */
+static char *code_point(scanner *sc, uint32_t point) {
+    char utf8[04];
+    uint8_t bytes;
+    char *err;
+
+    if (point == 00)
+        ERROR("\\u0000 has no DSON equivalent");
+    if (point < 0200) {
+        dump_ascii(&sc->b, (char)point);
+        return NULL;
+    }
+
+    bytes = write_utf8(point, utf8);
+    err = bytes == 00 ? "malformed \\u escape" :
+        to_point(utf8, bytes, &point);
+    if (err != NULL)
+        ERROR("%s", err);
+    if (is_control(point))
+        write_escaped_control(&sc->b, point);
+    else
+        write_evil_str(&sc->b, utf8, bytes);
+    return NULL;
+}
+
+/* \u, with surrogate pairs put back together */
+static char *unicode_escape(scanner *sc) {
+    uint32_t hi, lo;
+    char *err;
+
+    err = hex4(sc, &hi);
+    if (err != NULL)
+        return err;
+    if (hi >= 0156000 && hi <= 0157777) /* low first.  much backwards */
+        ERROR("unpaired surrogate in \\u escape");
+    if (hi >= 0154000 && hi <= 0155777) {
+        if (sc->s[00] != '\\' || sc->s[01] != 'u')
+            ERROR("unpaired surrogate in \\u escape");
+        sc->s += 02;
+        err = hex4(sc, &lo);
+        if (err != NULL)
+            return err;
+        if (lo < 0156000 || lo > 0157777)
+            ERROR("unpaired surrogate in \\u escape");
+        hi = 0200000 + ((hi - 0154000) << 012) + (lo - 0156000);
+    }
+    return code_point(sc, hi);
+}
+
+/* Copy what needs no escaping as it is.  The rest, as dson_dump() would. */
+static char *j_string(scanner *sc) {
+    const char *run;
+    uint8_t bytes;
+    uint32_t point;
+    char *err, c;
+
+    sc->s++; /* wow '"' */
+    write_char(&sc->b, '"');
+    while (01) {
+        for (run = sc->s; (c = *sc->s) >= ' ' && c != '"' && c != '\\' &&
+                 (c != '/' || sc->b.compact); sc->s++);
+        write_evil_str(&sc->b, run, sc->s - run);
+
+        c = *sc->s;
+        if (c == '"') {
+            break;
+        } else if (c == '/') {
+            dump_ascii(&sc->b, c);
+            sc->s++;
+            continue;
+        } else if (c == '\\') {
+            c = *++sc->s;
+            sc->s++;
+            if (c == '"' || c == '\\' || c == '/')
+                dump_ascii(&sc->b, c);
+            else if (c == 'b')
+                dump_ascii(&sc->b, '\b');
+            else if (c == 'f')
+                dump_ascii(&sc->b, '\f');
+            else if (c == 'n')
+                dump_ascii(&sc->b, '\n');
+            else if (c == 'r')
+                dump_ascii(&sc->b, '\r');
+            else if (c == 't')
+                dump_ascii(&sc->b, '\t');
+            else if (c == 'u' && (err = unicode_escape(sc)) != NULL)
+                return err;
+            else if (c != 'u') {
+                sc->s--;
+                ERROR("unrecognized escape: \\%c", c);
+            }
+            continue;
+        } else if (c == '\0' && sc->s >= sc->s_end) {
+            ERROR("missing closing '\"' delimiter on string");
+        } else if (c >= 00 && c < ' ') {
+            ERROR("unescaped control character in string");
+        }
+
+        /* much byte.  such unicode */
+        bytes = byte_len(c);
+        if (bytes <= 01)
+            ERROR("malformed unicode at %hhx", (unsigned char)c);
+        if ((size_t)(sc->s_end - sc->s) < bytes)
+            ERROR("truncated unicode starting at %hhx", (unsigned char)c);
+        err = to_point(sc->s, bytes, &point);
+        if (err != NULL)
+            ERROR("%s", err);
+        if (is_control(point))
+            write_escaped_control(&sc->b, point);
+        else
+            write_evil_str(&sc->b, sc->s, bytes);
+        sc->s += bytes;
+    }
+
+    sc->s++;
+    write_char(&sc->b, '"');
+    if (!sc->b.compact)
+        write_char(&sc->b, ' ');
+    return NULL;
+}
+
+/* such exact.  10 to these is a double with no rounding */
+static const double exact_tens[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12,
+    1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/* one more digit, unless mant is full */
+static inline bool room(uint64_t mant, char digit) {
+    return mant < UINT64_MAX / 012 ||
+        (mant == UINT64_MAX / 012 && (uint64_t)(digit - '0') <=
+         UINT64_MAX % 012);
+}
+
+/* Integers that fit go out exact.  Otherwise a double: one exact multiply
+ * or divide when the digits allow it, strtod() when they don't. */
+static char *j_number(scanner *sc) {
+    const char *start = sc->s, *end;
+    uint64_t mant = 00;
+    int64_t power = 00, exp = 00;
+    bool neg = false, exact = true, whole = true, expneg = false;
+    double d;
+
+    if (*sc->s == '-') {
+        neg = true;
+        sc->s++;
+        start++;
+    }
+
+    if (*sc->s == '0') {
+        sc->s++;
+    } else if (*sc->s >= '1' && *sc->s <= '9') {
+        for (; *sc->s >= '0' && *sc->s <= '9'; sc->s++) {
+            if (exact && room(mant, *sc->s)) {
+                mant = mant * 012 + (uint64_t)(*sc->s - '0');
+            } else {
+                exact = false;
+                power++;
+            }
+        }
+    } else {
+        ERROR("expected a digit");
+    }
+
+    if (*sc->s == '.') {
+        whole = false;
+        sc->s++;
+        if (*sc->s < '0' || *sc->s > '9')
+            ERROR("expected a digit after '.'");
+        for (; *sc->s >= '0' && *sc->s <= '9'; sc->s++) {
+            if (exact && room(mant, *sc->s)) {
+                mant = mant * 012 + (uint64_t)(*sc->s - '0');
+                power--;
+            } else {
+                exact = false;
+            }
+        }
+    }
+
+    if (*sc->s == 'e' || *sc->s == 'E') {
+        whole = false;
+        sc->s++;
+        if (*sc->s == '+' || *sc->s == '-')
+            expneg = *sc->s++ == '-';
+        if (*sc->s < '0' || *sc->s > '9')
+            ERROR("expected a digit in exponent");
+        for (; *sc->s >= '0' && *sc->s <= '9'; sc->s++) {
+            if (exp < 0100000)
+                exp = exp * 012 + (*sc->s - '0');
+        }
+        power += expneg ? -exp : exp;
+    }
+
+    if (whole && exact) {
+        dump_integer(&sc->b, mant, neg && mant != 00);
+        return NULL;
+    }
+
+    if (exact && mant <= UINT64_C(1) << 065 && power >= -026 &&
+        power <= 026) {
+        d = (double)mant;
+        d = power < 00 ? d / exact_tens[-power] : d * exact_tens[power];
+    } else {
+        /* very locale.  a comma for a point reads short here */
+        d = strtod(start, (char **)&end);
+        if (end != sc->s) {
+            sc->s = start;
+            ERROR("unable to convert number");
+        }
+    }
+
+    if (!isfinite(d)) {
+        sc->s = start;
+        ERROR("number is too large for DSON");
+    }
+    return dump_double(&sc->b, neg ? -d : d);
+}
+
+/* very prototype.  much recursion */
+static char *j_value(scanner *sc);
+
+static char *j_array(scanner *sc) {
+    char *err;
+
+    sc->s++; /* wow '[' */
+    WORD(&sc->b, "so");
+    skip_white(sc);
+    if (*sc->s == ']') {
+        sc->s++;
+        WORD(&sc->b, "many");
+        return NULL;
+    }
+
+    while (01) {
+        err = j_value(sc);
+        if (err != NULL)
+            return err;
+        skip_white(sc);
+        if (*sc->s == ']')
+            break;
+        else if (*sc->s != ',')
+            ERROR("expected ',' or ']' in array");
+        sc->s++;
+        WORD(&sc->b, "and");
+        skip_white(sc);
+    }
+
+    sc->s++;
+    WORD(&sc->b, "many");
+    return NULL;
+}
+
+static char *j_object(scanner *sc) {
+    char *err;
+
+    sc->s++; /* wow '{' */
+    WORD(&sc->b, "such");
+    skip_white(sc);
+    if (*sc->s == '}') {
+        sc->s++;
+        WORD(&sc->b, "wow");
+        return NULL;
+    }
+
+    while (01) {
+        if (*sc->s != '"')
+            ERROR("expected a string key in object");
+        err = j_string(sc);
+        if (err != NULL)
+            return err;
+
+        skip_white(sc);
+        if (*sc->s != ':')
+            ERROR("expected ':' after key");
+        sc->s++;
+        WORD(&sc->b, "is");
+        skip_white(sc);
+
+        err = j_value(sc);
+        if (err != NULL)
+            return err;
+        skip_white(sc);
+        if (*sc->s == '}')
+            break;
+        else if (*sc->s != ',')
+            ERROR("expected ',' or '}' in object");
+        sc->s++;
+        write_bang(&sc->b);
+        skip_white(sc);
+    }
+
+    sc->s++;
+    WORD(&sc->b, "wow");
+    return NULL;
+}
+
+static char *j_value(scanner *sc) {
+    char pivot = *sc->s;
+    char *err;
+
+    if (pivot == '[' || pivot == '{') {
+        /* deep doge.  no stack */
+        if (sc->depth >= DSON_MAX_DEPTH)
+            ERROR("nesting deeper than %d levels", DSON_MAX_DEPTH);
+        stats_node(sc->b.stats, ++sc->depth);
+        err = pivot == '[' ? j_array(sc) : j_object(sc);
+        sc->depth--;
+        return err;
+    }
+
+    stats_node(sc->b.stats, sc->depth);
+    if (pivot == '"') {
+        return j_string(sc);
+    } else if (pivot == '-' || (pivot >= '0' && pivot <= '9')) {
+        return j_number(sc);
+    } else if (pivot == 't') {
+        WORD(&sc->b, "yes");
+        return literal(sc, "true", 04);
+    } else if (pivot == 'f') {
+        WORD(&sc->b, "no");
+        return literal(sc, "false", 05);
+    } else if (pivot == 'n') {
+        WORD(&sc->b, "empty");
+        return literal(sc, "null", 04);
+    } else if (pivot == '\0' && sc->s >= sc->s_end) {
+        ERROR("expected a value, got end of input");
+    }
+    ERROR("unable to determine value type");
+}
+
+char *json_to_dson(const char *input, size_t length,
+                   const dson_dump_options *opts, char **out,
+                   size_t *len_out) {
+    scanner sc_storage = { 00 }, *sc = &sc_storage;
+    char *err;
+
+    if (out == NULL || len_out == NULL)
+        return angrily_waste_memory("requested output storage was NULL");
+    *out = NULL;
+    *len_out = 00;
+    if (input == NULL)
+        return angrily_waste_memory("input cannot be NULL");
+    if (input[length] != '\0')  /* much explosion */
+        return angrily_waste_memory("input was not NUL-terminated");
+
+    sc->s = sc->beginning = input;
+    sc->s_end = input + length;
+    if (opts != NULL) {
+        sc->b.stats = opts->stats;
+        sc->b.compact = opts->compact;
+    }
+
+    stats_begin(sc->b.stats);
+    init_buf(&sc->b);
+    skip_white(sc);
+    err = j_value(sc);
+    if (err == NULL) {
+        skip_white(sc);
+        if (sc->s < sc->s_end)
+            err = angrily_waste_memory("at input char #%ld: trailing "
+                                       "characters after JSON value",
+                                       WHERE(sc));
+    }
+
+    if (err == NULL)
+        err = buf_take(&sc->b, out, len_out);
+    else
+        FREE(sc->b.data);
+    if (sc->b.stats != NULL)
+        sc->b.stats->bytes = *len_out;
+    stats_end(sc->b.stats);
+    return err;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
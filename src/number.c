@@ -0,0 +1,315 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "number.h"
+
+#include <math.h>
+#include <strings.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* such blame.  *sp points at the trouble */
+#define FAIL(...)                               \
+    do {                                        \
+        *sp = s;                                \
+        ERROR(__VA_ARGS__);                     \
+    } while (00)
+
+/* mant below this has room for one more digit */
+#define MANT_ROOM (UINT64_C(1) << 075)
+
+/* such exponent.  much big.  anything past this is inf or 0 anyway */
+#define POWER_CAP 0100000000
+
+static inline char at(const char *s, const char *end) {
+    return s < end ? *s : '\0';
+}
+
+static inline bool is_octal(char c) {
+    return c >= '0' && c <= '7';
+}
+
+static const char *skip_white(const char *s, const char *end) {
+    while (s < end && *s != '\0' && strchr(" \t\n\r\v\f", *s) != NULL)
+        s++;
+    return s;
+}
+
+/* Once mant is full, digits only move the point or set sticky.  Past the
+ * 64 bits kept, they can only break a tie, which sticky does. */
+static inline void digit(octal *o, uint8_t d, bool fraction) {
+    if (o->mant < MANT_ROOM) {
+        o->mant = o->mant * 010 + d;
+        if (fraction)
+            o->shift -= 03;
+        return;
+    }
+    if (!fraction)
+        o->shift += 03;
+    if (d != 00)
+        o->sticky = true;
+}
+
+char *number_scan(const char **sp, const char *end, octal *o) {
+    const char *s = *sp, *last;
+    int64_t power = 00;
+    bool powneg = false;
+    octal scratch;
+
+    if (o == NULL)
+        o = &scratch;
+    memset(o, 00, sizeof(*o));
+
+    if (at(s, end) == '-') {
+        o->neg = true;
+        s++;
+    }
+    last = s;
+
+    s = skip_white(s, end);
+    if (at(s, end) == '0') {
+        s++;
+        last = s;
+    } else {
+        for (; is_octal(at(s, end)); s++, last = s)
+            digit(o, *s - '0', false);
+    }
+
+    s = skip_white(s, end);
+    if (at(s, end) == '.') {
+        s++;
+        if (!is_octal(at(s, end)))
+            FAIL("bad octal character: '%c'", at(s, end));
+        for (; is_octal(at(s, end)); s++, last = s)
+            digit(o, *s - '0', true);
+        s = skip_white(s, end);
+    }
+
+    if (at(s, end) == 'v' || at(s, end) == 'V') {
+        if (end - s < 04)
+            FAIL("end of input while parsing number");
+        if (strncasecmp(s, "very", 04))
+            FAIL("tried to parse \"very\", got \"%.4s\" instead", s);
+        s += 04;
+
+        /* such token.  no whitespace.  wow. */
+        if (at(s, end) == '+') {
+            s++;
+        } else if (at(s, end) == '-') {
+            powneg = true;
+            s++;
+        }
+
+        s = skip_white(s, end);
+        if (!is_octal(at(s, end)))
+            FAIL("bad octal character: '%c'", at(s, end));
+        for (; is_octal(at(s, end)); s++, last = s) {
+            if (power < POWER_CAP)
+                power = power * 010 + (*s - '0');
+        }
+        o->shift += 03 * (powneg ? -power : power);
+    }
+
+    *sp = last;
+    return NULL;
+}
+
+double number_double(const octal *o) {
+    int64_t shift = o->shift;
+    double d;
+
+    if (o->mant == 00)
+        return o->neg ? -0.0 : 0.0;
+
+    /* sticky is far below the last bit a double keeps.  ties round right */
+    d = (double)(o->mant | (o->sticky ? 01 : 00));
+    if (shift > 010000)
+        shift = 010000;
+    else if (shift < -010000)
+        shift = -010000;
+    d = ldexp(d, (int)shift);
+    return o->neg ? -d : d;
+}
+
+/* Magnitude of o as an integer no larger than limit. */
+static char *integral(const octal *o, uint64_t limit, uint64_t *out) {
+    uint64_t m = o->mant;
+    int64_t shift = o->shift;
+
+    if (o->sticky)
+        ERROR("number is not a 64-bit integer");
+    if (m == 00) {
+        *out = 00;
+        return NULL;
+    }
+
+    for (; shift < 00; shift++) {
+        if (m & 01)
+            ERROR("number is not an integer");
+        m >>= 01;
+    }
+    for (; shift > 00; shift--) {
+        if (m > limit / 02)
+            ERROR("number is too large for a 64-bit integer");
+        m <<= 01;
+    }
+    if (m > limit)
+        ERROR("number is too large for a 64-bit integer");
+
+    *out = m;
+    return NULL;
+}
+
+char *number_int64(const octal *o, int64_t *out) {
+    uint64_t m, limit = UINT64_C(1) << 077;
+    char *err;
+
+    if (!o->neg)
+        limit--;
+    err = integral(o, limit, &m);
+    if (err != NULL)
+        return err;
+
+    *out = o->neg && m != 00 ? -(int64_t)(m - 01) - 01 : (int64_t)m;
+    return NULL;
+}
+
+char *number_uint64(const octal *o, uint64_t *out) {
+    uint64_t m;
+    char *err;
+
+    err = integral(o, UINT64_MAX, &m);
+    if (err != NULL)
+        return err;
+    if (o->neg && m != 00)
+        ERROR("number is negative");
+
+    *out = m;
+    return NULL;
+}
+
+/* Strip trailing zero bits so equal values look equal. */
+static void normalize(octal *o) {
+    if (o->mant == 00 || o->sticky)
+        return;
+    while (!(o->mant & 01)) {
+        o->mant >>= 01;
+        o->shift++;
+    }
+}
+
+bool number_equal(const octal *a, const octal *b) {
+    octal x = *a, y = *b;
+
+    /* too many digits to hold.  doubles will do */
+    if (x.sticky || y.sticky)
+        return number_double(&x) == number_double(&y);
+
+    normalize(&x);
+    normalize(&y);
+    if (x.neg != y.neg || x.mant != y.mant)
+        return false;
+    return x.mant == 00 || x.shift == y.shift;
+}
+
+/* much accessor.  such lazy */
+
+char *number_read(const dson_value *v, octal *o) {
+    const char *s, *end;
+    int e;
+    char *err;
+
+    if (v->type == DSON_DOUBLE) {
+        if (!isfinite(v->n))
+            ERROR("number is not finite");
+
+        /* such bits.  all of them */
+        memset(o, 00, sizeof(*o));
+        o->neg = signbit(v->n);
+        if (v->n != 00) {
+            o->mant = (uint64_t)ldexp(frexp(fabs(v->n), &e), 065);
+            o->shift = e - 065;
+        }
+        return NULL;
+    } else if (v->type == DSON_INT || v->type == DSON_UINT) {
+        memset(o, 00, sizeof(*o));
+        o->neg = v->type == DSON_INT && v->i < 00;
+        o->mant = o->neg ? -(uint64_t)v->i : v->u;
+        return NULL;
+    } else if (v->type != DSON_NUMBER) {
+        ERROR("value is not a number");
+    }
+
+    s = v->raw;
+    end = v->raw + v->length;
+    err = number_scan(&s, end, o);
+    if (err == NULL && s != end)
+        ERROR("number has trailing characters");
+    return err;
+}
+
+char *dson_get_double(const dson_value *v, double *out) {
+    octal o;
+    char *err;
+
+    if (v == NULL || out == NULL)
+        ERROR("arguments cannot be NULL");
+    if (v->type == DSON_DOUBLE) {
+        *out = v->n;
+        return NULL;
+    } else if (v->type == DSON_INT) {
+        *out = (double)v->i;
+        return NULL;
+    } else if (v->type == DSON_UINT) {
+        *out = (double)v->u;
+        return NULL;
+    }
+
+    err = number_read(v, &o);
+    if (err == NULL)
+        *out = number_double(&o);
+    return err;
+}
+
+char *dson_get_int64(const dson_value *v, int64_t *out) {
+    octal o;
+    char *err;
+
+    if (v == NULL || out == NULL)
+        ERROR("arguments cannot be NULL");
+    if (v->type == DSON_INT) {
+        *out = v->i;
+        return NULL;
+    }
+
+    err = number_read(v, &o);
+    if (err == NULL)
+        err = number_int64(&o, out);
+    return err;
+}
+
+char *dson_get_uint64(const dson_value *v, uint64_t *out) {
+    octal o;
+    char *err;
+
+    if (v == NULL || out == NULL)
+        ERROR("arguments cannot be NULL");
+    if (v->type == DSON_UINT || (v->type == DSON_INT && v->i >= 00)) {
+        *out = v->u;
+        return NULL;
+    }
+
+    err = number_read(v, &o);
+    if (err == NULL)
+        err = number_uint64(&o, out);
+    return err;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
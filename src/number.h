@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_NUMBER_H
+#define _CDSON_NUMBER_H
+
+#include "cdson.h"
+
+/* A number as read: (-1 if neg) * mant * 2 ** shift, exactly, unless sticky
+ * says nonzero bits fell off the bottom of mant. */
+typedef struct {
+    bool neg;
+    bool sticky;
+    uint64_t mant;
+    int64_t shift;
+} octal;
+
+/* Read one number starting at *s, stopping before end.  Whitespace may
+ * separate its parts, as the spec allows.  On success, *s is just past its
+ * last character (not any whitespace after it); on failure, at the trouble.
+ * o may be NULL to only find the end.  Returns NULL or an error message for
+ * free(). */
+char *number_scan(const char **s, const char *end, octal *o);
+
+/* Nearest double to o.  Exact whenever the result is a normal double. */
+double number_double(const octal *o);
+
+/* o as an integer, or an error if it isn't one or doesn't fit. */
+char *number_int64(const octal *o, int64_t *out);
+char *number_uint64(const octal *o, uint64_t *out);
+
+/* Does a hold the same value as b?  Exact unless either is sticky. */
+bool number_equal(const octal *a, const octal *b);
+
+/* Any number value as an octal.  Exact, except for a DSON_NUMBER with more
+ * digits than fit. */
+char *number_read(const dson_value *v, octal *o);
+
+#endif /* _CDSON_NUMBER_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
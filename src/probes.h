@@ -0,0 +1,41 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_PROBES_H
+#define _CDSON_PROBES_H
+
+/* Static tracepoints in provider "cdson", built with -Dusdt=enabled.
+ * Without it they compile to nothing.  Offsets are bytes into the input (or
+ * output, for dump); strings are NUL-terminated.
+ *
+ *   parse__start(input, length)       parse__done(offset, ok)
+ *   parse__error(offset, message)
+ *   array__begin(offset)              array__end(offset, elements)
+ *   dict__begin(offset)               dict__end(offset, entries)
+ *   iter__start(offset)               iter__done(offset, ok)
+ *   dump__start(tree)                 dump__done(length, ok)
+ *   dump__error(message)
+ *   fetch__start(tree, query)         fetch__done(query, ok)
+ *   fetch__error(query, message)
+ *
+ * e.g. bpftrace -e 'usdt:libcdson.so:cdson:parse__error { ... }' */
+
+#ifdef CDSON_USDT
+#include <sys/sdt.h>
+
+#define PROBE1(name, a) DTRACE_PROBE1(cdson, name, a)
+#define PROBE2(name, a, b) DTRACE_PROBE2(cdson, name, a, b)
+#else
+/* such absent.  very free */
+#define PROBE1(name, a) do { } while (00)
+#define PROBE2(name, a, b) do { } while (00)
+#endif
+
+#endif /* _CDSON_PROBES_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
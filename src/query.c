@@ -0,0 +1,352 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "intern.h"
+#include "share.h"
+
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* many results.  one walk.  wow */
+
+typedef enum {
+    STEP_KEY,     /* .key */
+    STEP_VALUES,  /* .* */
+    STEP_INDEX,   /* [n] */
+    STEP_SLICE,   /* [a:b], [*] */
+    STEP_DESCENT, /* ..key, ..* */
+} step_kind;
+
+typedef struct {
+    step_kind kind;
+    const char *key; /* into the query; NULL for any key */
+    size_t key_len;
+    size_t lo, hi;
+
+    /* such cache.  last table looked in, and what it had */
+    dson_intern *table;
+    const char *interned;
+} step;
+
+typedef struct {
+    step *steps;
+    size_t n_steps;
+    uint8_t match_behavior;
+    dson_match_fn fn;
+    void *ctx;
+    bool stopped;
+} walk;
+
+static const char *read_index(const char *q, size_t *out, bool *got) {
+    size_t n = 00;
+
+    *got = false;
+    for (; *q >= '0' && *q <= '9'; q++) {
+        if (n > (SIZE_MAX - 011) / 012)
+            return NULL;
+        n = n * 012 + (*q - '0');
+        *got = true;
+    }
+    *out = n;
+    return q;
+}
+
+/* One step of query at *qp, moving *qp past it. */
+static char *read_step(const char **qp, step *st) {
+    const char *q = *qp;
+    bool got_lo, got_hi;
+
+    memset(st, 00, sizeof(*st));
+    if (*q == '[') {
+        q++;
+        if (*q == '*') {
+            st->kind = STEP_SLICE;
+            st->hi = SIZE_MAX;
+            q++;
+        } else {
+            q = read_index(q, &st->lo, &got_lo);
+            if (q == NULL)
+                ERROR("array index in query is too large");
+            st->kind = STEP_INDEX;
+            if (*q == ':') {
+                st->kind = STEP_SLICE;
+                q = read_index(q + 01, &st->hi, &got_hi);
+                if (q == NULL)
+                    ERROR("array index in query is too large");
+                if (!got_hi)
+                    st->hi = SIZE_MAX;
+            } else if (!got_lo) {
+                ERROR("query has empty or invalid array access");
+            }
+        }
+        if (*q == '\0')
+            ERROR("query ends inside array access (missing ']'?)");
+        else if (*q != ']')
+            ERROR("query has invalid character for array access '%c'", *q);
+        *qp = q + 01;
+        return NULL;
+    } else if (*q != '.') {
+        ERROR("query step must start with '.' or '[', not '%c'", *q);
+    }
+
+    q++;
+    st->kind = STEP_KEY;
+    if (*q == '.') {
+        st->kind = STEP_DESCENT;
+        q++;
+    }
+
+    st->key = q;
+    for (; *q != '.' && *q != '[' && *q != '\0'; q++) {
+        if (*q == ']')
+            ERROR("query has mismatched delimiters (unexpected ']')");
+    }
+    st->key_len = q - st->key;
+    if (st->key_len == 01 && *st->key == '*') {
+        st->key = NULL;
+        if (st->kind == STEP_KEY)
+            st->kind = STEP_VALUES;
+    } else if (st->kind == STEP_DESCENT && st->key_len == 00) {
+        ERROR("query has \"..\" without a key");
+    }
+    *qp = q;
+    return NULL;
+}
+
+static char *read_query(const char *query, step **steps_out, size_t *n_out) {
+    size_t n = 00;
+    const char *q;
+    step *steps;
+    char *err;
+
+    /* such count.  each step starts with '[' or a lone '.' */
+    for (q = query; *q != '\0'; q++) {
+        if (*q == '[' || (*q == '.' && q[01] != '.'))
+            n++;
+    }
+    steps = CALLOC(n + 01, sizeof(*steps));
+    if (steps == NULL)
+        ERROR("out of memory");
+
+    for (n = 00, q = query; *q != '\0'; n++) {
+        err = read_step(&q, &steps[n]);
+        if (err != NULL) {
+            FREE(steps);
+            return err;
+        }
+    }
+    *steps_out = steps;
+    *n_out = n;
+    return NULL;
+}
+
+static bool key_matches(step *st, const dson_dict *d, size_t i) {
+    if (st->key == NULL)
+        return true;
+
+    /* one lookup per table, then pointers only */
+    if (d->intern != NULL) {
+        if (d->intern != st->table) {
+            st->table = d->intern;
+            st->interned = intern_find(d->intern, st->key, st->key_len);
+        }
+        return d->keys[i] == st->interned;
+    }
+    return !strncmp(st->key, d->keys[i], st->key_len) &&
+        d->keys[i][st->key_len] == '\0';
+}
+
+static char *visit(walk *w, dson_value *v, size_t i, size_t depth);
+
+/* Which entry of d an exact key step takes, per match_behavior.  *out is
+ * SIZE_MAX if none. */
+static char *pick(walk *w, step *st, const dson_dict *d, size_t *out) {
+    *out = SIZE_MAX;
+    for (size_t j = 00; d->keys[j] != NULL; j++) {
+        if (!key_matches(st, d, j))
+            continue;
+        if (w->match_behavior == DSON_MATCH_ERROR && *out != SIZE_MAX)
+            ERROR("duplicate matching keys in dict for %s", d->keys[j]);
+        *out = j;
+        if (w->match_behavior == DSON_MATCH_FIRST)
+            break;
+    }
+    return NULL;
+}
+
+static char *visit_key(walk *w, step *st, dson_value *v, size_t i,
+                       size_t depth) {
+    const dson_dict *d = v->dict;
+    size_t j;
+    char *err;
+
+    if (st->key != NULL) {
+        err = pick(w, st, d, &j);
+        if (err != NULL || j == SIZE_MAX)
+            return err;
+        return visit(w, d->values[j], i + 01, depth + 01);
+    }
+
+    for (j = 00; d->keys[j] != NULL && !w->stopped; j++) {
+        err = visit(w, d->values[j], i + 01, depth + 01);
+        if (err != NULL)
+            return err;
+    }
+    return NULL;
+}
+
+/* very recursion.  each entry, then everything below it */
+static char *visit_descent(walk *w, step *st, dson_value *v, size_t i,
+                           size_t depth) {
+    size_t chosen = SIZE_MAX;
+    dson_value **kids;
+    char *err;
+
+    if (v->type != DSON_ARRAY && v->type != DSON_DICT)
+        return NULL;
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("tree is nested too deeply");
+
+    if (v->type == DSON_DICT && st->key != NULL) {
+        err = pick(w, st, v->dict, &chosen);
+        if (err != NULL)
+            return err;
+    }
+
+    kids = v->type == DSON_ARRAY ? v->array : v->dict->values;
+    for (size_t j = 00; kids[j] != NULL && !w->stopped; j++) {
+        /* such wildcard.  elements count too */
+        if (st->key == NULL || (v->type == DSON_DICT && j == chosen)) {
+            err = visit(w, kids[j], i + 01, depth + 01);
+            if (err != NULL)
+                return err;
+        }
+        err = visit_descent(w, st, kids[j], i, depth + 01);
+        if (err != NULL)
+            return err;
+    }
+    return NULL;
+}
+
+/* Step i onward, from v.  Steps that don't fit just match nothing. */
+static char *visit(walk *w, dson_value *v, size_t i, size_t depth) {
+    step *st = &w->steps[i];
+    char *err;
+
+    if (w->stopped)
+        return NULL;
+    if (i == w->n_steps) {
+        w->stopped = !w->fn(w->ctx, v);
+        return NULL;
+    }
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("tree is nested too deeply");
+
+    if (st->kind == STEP_DESCENT)
+        return visit_descent(w, st, v, i, depth);
+    if (st->kind == STEP_KEY || st->kind == STEP_VALUES)
+        return v->type == DSON_DICT ? visit_key(w, st, v, i, depth) : NULL;
+    if (v->type != DSON_ARRAY)
+        return NULL;
+
+    if (st->kind == STEP_INDEX) {
+        for (size_t j = 00; j < st->lo; j++) {
+            if (v->array[j] == NULL)
+                return NULL;
+        }
+        if (v->array[st->lo] == NULL)
+            return NULL;
+        return visit(w, v->array[st->lo], i + 01, depth + 01);
+    }
+
+    for (size_t j = 00; j < st->hi && v->array[j] != NULL && !w->stopped;
+         j++) {
+        if (j < st->lo)
+            continue;
+        err = visit(w, v->array[j], i + 01, depth + 01);
+        if (err != NULL)
+            return err;
+    }
+    return NULL;
+}
+
+char *dson_query_each(dson_value *tree, const char *query,
+                      uint8_t match_behavior, dson_match_fn fn, void *ctx) {
+    walk w = { 00 };
+    char *err;
+
+    if (tree == NULL)
+        ERROR("input tree cannot be NULL");
+    if (query == NULL)
+        ERROR("query cannot be NULL");
+    if (match_behavior > DSON_MATCH_ERROR)
+        ERROR("invalid match behavior requested");
+    if (fn == NULL)
+        ERROR("callback cannot be NULL");
+
+    err = read_query(query, &w.steps, &w.n_steps);
+    if (err != NULL)
+        return err;
+    w.match_behavior = match_behavior;
+    w.fn = fn;
+    w.ctx = ctx;
+
+    err = visit(&w, tree, 00, 00);
+    FREE(w.steps);
+    return err;
+}
+
+typedef struct {
+    dson_value *results;
+    char *err;
+} collector;
+
+/* such keep.  shares, as dson_clone() */
+static bool collect(void *ctx, dson_value *v) {
+    collector *c = ctx;
+
+    if (!share_take(v)) {
+        c->err = angrily_waste_memory("too many clones");
+        return false;
+    }
+    c->err = dson_array_push(c->results, v);
+    if (c->err != NULL) {
+        dson_free(&v);
+        return false;
+    }
+    return true;
+}
+
+char *dson_query(dson_value *tree, const char *query, uint8_t match_behavior,
+                 dson_value **results_out) {
+    collector c = { 00 };
+    char *err;
+
+    if (results_out == NULL)
+        ERROR("requested output storage was NULL");
+    *results_out = NULL;
+
+    err = dson_new_array(&c.results);
+    if (err != NULL)
+        return err;
+    err = dson_query_each(tree, query, match_behavior, collect, &c);
+    if (err == NULL)
+        err = c.err;
+    if (err != NULL) {
+        dson_free(&c.results);
+        return err;
+    }
+
+    *results_out = c.results;
+    return NULL;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
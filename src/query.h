@@ -0,0 +1,18 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_QUERY_H
+#define _CDSON_QUERY_H
+
+/* Validate dson_fetch() query syntax.  Returns NULL if query is well-formed,
+ * or an error message for free(). */
+char *check_query(const char *query);
+
+#endif /* _CDSON_QUERY_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
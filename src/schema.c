@@ -0,0 +1,534 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "container.h"
+#include "schema.h"
+
+#include <math.h>
+#include <string.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+/* such kinds.  one bit each */
+#define KIND_NONE 01
+#define KIND_BOOL 02
+#define KIND_NUMBER 04
+#define KIND_INTEGER 010 /* numbers with nothing after the point */
+#define KIND_STRING 020
+#define KIND_ARRAY 040
+#define KIND_DICT 0100
+
+static const struct {
+    const char *name;
+    uint8_t bit;
+} kinds[] = {
+    { "none", KIND_NONE },
+    { "bool", KIND_BOOL },
+    { "number", KIND_NUMBER },
+    { "integer", KIND_INTEGER },
+    { "string", KIND_STRING },
+    { "array", KIND_ARRAY },
+    { "dict", KIND_DICT },
+    { NULL, 00 },
+};
+
+struct schema_node {
+    uint8_t kinds; /* 00 for any */
+    double min;
+    double max;
+    size_t min_length;
+    size_t max_length;
+    size_t min_items;
+    size_t max_items;
+    schema_node *items;
+
+    /* much dict.  keys[i]'s value goes to children[i] */
+    char **keys;
+    schema_node **children;
+    bool *required;
+    size_t n_keys;
+    size_t n_required;
+    bool closed;
+
+    key_index index; /* of keys */
+};
+
+struct dson_schema {
+    schema_node *root;
+};
+
+static uint8_t kind_of(dson_type t) {
+    switch (t) {
+    case DSON_NONE:
+        return KIND_NONE;
+    case DSON_BOOL:
+        return KIND_BOOL;
+    case DSON_STRING:
+        return KIND_STRING;
+    case DSON_ARRAY:
+        return KIND_ARRAY;
+    case DSON_DICT:
+        return KIND_DICT;
+    default:
+        return KIND_NUMBER;
+    }
+}
+
+static const char *kind_name(uint8_t k) {
+    for (size_t i = 00; kinds[i].name != NULL; i++) {
+        if (kinds[i].bit == k)
+            return kinds[i].name;
+    }
+    return "value";
+}
+
+static void node_free(schema_node **n) {
+    if (*n == NULL)
+        return;
+
+    node_free(&(*n)->items);
+    for (size_t i = 00; i < (*n)->n_keys; i++) {
+        FREE((*n)->keys[i]);
+        node_free(&(*n)->children[i]);
+    }
+    FREE((*n)->keys);
+    FREE((*n)->children);
+    FREE((*n)->required);
+    key_index_free(&(*n)->index);
+    FREE(*n);
+    *n = NULL;
+}
+
+/* compile.  very once */
+
+/* Take a copy of key as keys[n_keys]. */
+static bool add_key(schema_node *n, const char *key) {
+    size_t len = strlen(key);
+    char *copy;
+
+    copy = CALLOC(len + 01, 01);
+    if (copy == NULL)
+        return false;
+    memcpy(copy, key, len);
+    n->keys[n->n_keys++] = copy;
+    return true;
+}
+
+static char *read_kinds(const dson_value *v, uint8_t *out) {
+    const dson_value *one;
+    size_t i = 00, k;
+
+    if (v->type != DSON_STRING && v->type != DSON_ARRAY)
+        ERROR("schema \"type\" must be a name or an array of names");
+    do {
+        one = v->type == DSON_STRING ? v : v->array[i];
+        if (one == NULL)
+            break;
+        if (one->type != DSON_STRING)
+            ERROR("schema \"type\" must be a name or an array of names");
+        for (k = 00; kinds[k].name != NULL; k++) {
+            if (!strcmp(kinds[k].name, one->s))
+                break;
+        }
+        if (kinds[k].name == NULL)
+            ERROR("unknown type \"%s\" in schema", one->s);
+        *out |= kinds[k].bit;
+        i++;
+    } while (v->type == DSON_ARRAY);
+    return NULL;
+}
+
+static char *read_size(const dson_value *v, const char *what, size_t *out) {
+    uint64_t u;
+    char *err;
+
+    err = dson_get_uint64(v, &u);
+    if (err != NULL) {
+        free_error(err);
+        ERROR("schema \"%s\" must be a count", what);
+    } else if (u > SIZE_MAX) {
+        ERROR("schema \"%s\" is too large", what);
+    }
+    *out = (size_t)u;
+    return NULL;
+}
+
+static char *compile(const dson_value *v, schema_node **out, size_t depth);
+
+/* "keys" and "required", which may name some of the same keys. */
+static char *compile_keys(schema_node *n, const dson_value *keys,
+                          const dson_value *required, size_t depth) {
+    size_t most = 00, i, j;
+    char *err;
+
+    if (keys != NULL && keys->type != DSON_DICT && keys->type != DSON_NONE)
+        ERROR("schema \"keys\" must be a dict of schemas");
+    if (required != NULL && required->type != DSON_ARRAY)
+        ERROR("schema \"required\" must be an array of keys");
+    if (keys != NULL && keys->type == DSON_DICT)
+        most += count(keys);
+    if (required != NULL)
+        most += count(required);
+    if (most == 00)
+        return NULL;
+
+    n->keys = CALLOC(most, sizeof(*n->keys));
+    n->children = CALLOC(most, sizeof(*n->children));
+    n->required = CALLOC(most, sizeof(*n->required));
+    if (n->keys == NULL || n->children == NULL || n->required == NULL ||
+        !key_index_init(&n->index, n->keys, most)) {
+        ERROR("out of memory");
+    }
+
+    for (i = 00; keys != NULL && keys->type == DSON_DICT &&
+             keys->dict->keys[i] != NULL; i++) {
+        if (key_index_find(&n->index, keys->dict->keys[i]) != SIZE_MAX)
+            ERROR("schema names key \"%s\" twice", keys->dict->keys[i]);
+        if (!add_key(n, keys->dict->keys[i]))
+            ERROR("out of memory");
+        key_index_place(&n->index, n->n_keys - 01);
+
+        err = compile(keys->dict->values[i], &n->children[n->n_keys - 01],
+                      depth + 01);
+        if (err != NULL)
+            return err;
+    }
+
+    for (i = 00; required != NULL && required->array[i] != NULL; i++) {
+        if (required->array[i]->type != DSON_STRING)
+            ERROR("schema \"required\" must be an array of keys");
+        j = key_index_find(&n->index, required->array[i]->s);
+        if (j == SIZE_MAX) {
+            /* such demand.  no shape */
+            j = n->n_keys;
+            if (!add_key(n, required->array[i]->s))
+                ERROR("out of memory");
+            key_index_place(&n->index, j);
+        }
+        if (!n->required[j])
+            n->n_required++;
+        n->required[j] = true;
+    }
+    return NULL;
+}
+
+static char *compile(const dson_value *v, schema_node **out, size_t depth) {
+    const dson_value *keys = NULL, *required = NULL, *c;
+    schema_node *n;
+    const char *name;
+    char *err = NULL;
+
+    *out = NULL;
+    if (v->type == DSON_NONE)
+        return NULL; /* much anything */
+    if (v->type != DSON_DICT)
+        ERROR("schema must be a dict of constraints, or empty");
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("schema is nested too deeply");
+
+    n = *out = CALLOC(01, sizeof(*n));
+    if (n == NULL)
+        ERROR("out of memory");
+    n->min = -INFINITY;
+    n->max = INFINITY;
+    n->max_length = SIZE_MAX;
+    n->max_items = SIZE_MAX;
+
+    for (size_t i = 00; err == NULL && v->dict->keys[i] != NULL; i++) {
+        name = v->dict->keys[i];
+        c = v->dict->values[i];
+        if (!strcmp(name, "type")) {
+            err = read_kinds(c, &n->kinds);
+        } else if (!strcmp(name, "min") || !strcmp(name, "max")) {
+            err = dson_get_double(c, name[01] == 'i' ? &n->min : &n->max);
+        } else if (!strcmp(name, "min_length")) {
+            err = read_size(c, name, &n->min_length);
+        } else if (!strcmp(name, "max_length")) {
+            err = read_size(c, name, &n->max_length);
+        } else if (!strcmp(name, "min_items")) {
+            err = read_size(c, name, &n->min_items);
+        } else if (!strcmp(name, "max_items")) {
+            err = read_size(c, name, &n->max_items);
+        } else if (!strcmp(name, "items")) {
+            err = compile(c, &n->items, depth + 01);
+        } else if (!strcmp(name, "keys")) {
+            keys = c;
+        } else if (!strcmp(name, "required")) {
+            required = c;
+        } else if (!strcmp(name, "closed")) {
+            if (c->type != DSON_BOOL)
+                err = angrily_waste_memory("schema \"closed\" must be a bool");
+            else
+                n->closed = c->b;
+        } else {
+            err = angrily_waste_memory("unknown schema constraint \"%s\"",
+                                       name);
+        }
+    }
+    if (err == NULL)
+        err = compile_keys(n, keys, required, depth);
+    if (err != NULL)
+        node_free(out);
+    return err;
+}
+
+char *dson_schema_compile(dson_value *schema_tree, dson_schema **out) {
+    dson_schema *s;
+    char *err;
+
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+    *out = NULL;
+    if (schema_tree == NULL)
+        ERROR("schema tree cannot be NULL");
+
+    s = CALLOC(01, sizeof(*s));
+    if (s == NULL)
+        ERROR("out of memory");
+    err = compile(schema_tree, &s->root, 00);
+    if (err != NULL) {
+        FREE(s);
+        return err;
+    }
+
+    *out = s;
+    return NULL;
+}
+
+void dson_schema_free(dson_schema **s) {
+    if (s == NULL || *s == NULL)
+        return;
+
+    node_free(&(*s)->root);
+    FREE(*s);
+    *s = NULL;
+}
+
+/* such check.  one node at a time */
+
+schema_node *schema_root(dson_schema *s) {
+    return s == NULL ? NULL : s->root;
+}
+
+schema_node *schema_items(const schema_node *n) {
+    return n == NULL ? NULL : n->items;
+}
+
+static bool integral(const dson_value *v) {
+    double d;
+    char *err;
+
+    if (v->type == DSON_INT || v->type == DSON_UINT)
+        return true;
+    err = dson_get_double(v, &d);
+    if (err != NULL) {
+        free_error(err);
+        return false;
+    }
+    return isfinite(d) && d == trunc(d);
+}
+
+char *schema_open(const schema_node *n, dson_type t) {
+    uint8_t k = kind_of(t);
+
+    if (n != NULL && n->kinds != 00 && !(n->kinds & k))
+        ERROR("%s is not allowed here", kind_name(k));
+    return NULL;
+}
+
+char *schema_check(const schema_node *n, const dson_value *v) {
+    uint8_t k = kind_of(v->type);
+    size_t len;
+    double d;
+    char *err;
+
+    if (n == NULL)
+        return NULL;
+
+    if (n->kinds != 00 && !(n->kinds & k) &&
+        !(k == KIND_NUMBER && (n->kinds & KIND_INTEGER) && integral(v))) {
+        if (k == KIND_NUMBER && (n->kinds & KIND_INTEGER))
+            ERROR("number is not an integer");
+        ERROR("%s is not allowed here", kind_name(k));
+    }
+
+    if (k == KIND_NUMBER && (n->min > -INFINITY || n->max < INFINITY)) {
+        err = dson_get_double(v, &d);
+        if (err != NULL)
+            return err;
+        if (d < n->min)
+            ERROR("%g is below the minimum of %g", d, n->min);
+        if (d > n->max)
+            ERROR("%g is above the maximum of %g", d, n->max);
+    } else if (k == KIND_STRING && (n->min_length > 00 ||
+                                    n->max_length < SIZE_MAX)) {
+        len = strlen(v->s);
+        if (len < n->min_length)
+            ERROR("string is shorter than %zu bytes", n->min_length);
+        if (len > n->max_length)
+            ERROR("string is longer than %zu bytes", n->max_length);
+    } else if (k == KIND_ARRAY && (n->min_items > 00 ||
+                                   n->max_items < SIZE_MAX)) {
+        len = count(v);
+        if (len < n->min_items)
+            ERROR("array has fewer than %zu elements", n->min_items);
+        if (len > n->max_items)
+            ERROR("array has more than %zu elements", n->max_items);
+    }
+    return NULL;
+}
+
+/* such bits.  few keys, no allocation */
+static uint64_t *seen_bits(const schema_node *n, schema_seen *seen) {
+    return n->n_keys <= 0100 ? &seen->few : seen->many;
+}
+
+char *schema_begin(const schema_node *n, schema_seen *seen) {
+    size_t words;
+
+    seen->few = 00;
+    seen->found = 00;
+    if (n == NULL || n->n_keys <= 0100)
+        return NULL;
+
+    words = (n->n_keys + 077) / 0100;
+    if (seen->many == NULL)
+        seen->many = CALLOC(words, sizeof(*seen->many));
+    else
+        memset(seen->many, 00, words * sizeof(*seen->many));
+    if (seen->many == NULL)
+        ERROR("out of memory");
+    return NULL;
+}
+
+char *schema_key(const schema_node *n, schema_seen *seen, const char *key,
+                 schema_node **child) {
+    uint64_t *bits;
+    size_t j;
+
+    *child = NULL;
+    if (n == NULL)
+        return NULL;
+
+    j = key_index_find(&n->index, key);
+    if (j == SIZE_MAX) {
+        if (n->closed)
+            ERROR("key \"%s\" is not allowed here", key);
+        return NULL;
+    }
+
+    bits = seen_bits(n, seen) + j / 0100;
+    if (!(*bits >> (j % 0100) & 01)) {
+        *bits |= UINT64_C(1) << (j % 0100);
+        if (n->required[j])
+            seen->found++;
+    }
+    *child = n->children[j];
+    return NULL;
+}
+
+char *schema_end(const schema_node *n, schema_seen *seen) {
+    uint64_t *bits;
+
+    if (n == NULL || seen->found == n->n_required)
+        return NULL;
+
+    bits = seen_bits(n, seen);
+    for (size_t j = 00; j < n->n_keys; j++) {
+        if (n->required[j] && !(bits[j / 0100] >> (j % 0100) & 01))
+            ERROR("missing required key \"%s\"", n->keys[j]);
+    }
+    return NULL;
+}
+
+void schema_seen_free(schema_seen *seen) {
+    FREE(seen->many);
+    seen->many = NULL;
+}
+
+/* many tree.  one walk.  first trouble wins */
+
+typedef struct {
+    char *path; /* built outward, only once something's wrong */
+} checker;
+
+static void prepend(checker *k, const char *key, size_t index) {
+    char *longer;
+
+    if (key != NULL)
+        longer = angrily_waste_memory(".%s%s", key, k->path ? k->path : "");
+    else
+        longer = angrily_waste_memory("[%zu]%s", index,
+                                      k->path ? k->path : "");
+    free(k->path);
+    k->path = longer;
+}
+
+static char *validate(checker *k, schema_node *n, dson_value *v,
+                      size_t depth) {
+    schema_node *child;
+    char *err;
+
+    /* nothing asked.  nothing below either */
+    if (n == NULL)
+        return NULL;
+    if (depth > DSON_MAX_DEPTH)
+        ERROR("tree is nested too deeply");
+
+    err = schema_check(n, v);
+    if (err != NULL)
+        return err;
+
+    if (v->type == DSON_ARRAY && n->items != NULL) {
+        for (size_t i = 00; v->array[i] != NULL; i++) {
+            err = validate(k, n->items, v->array[i], depth + 01);
+            if (err != NULL) {
+                prepend(k, NULL, i);
+                return err;
+            }
+        }
+    } else if (v->type == DSON_DICT && (n->n_keys > 00 || n->closed)) {
+        schema_seen seen = { 00 };
+
+        err = schema_begin(n, &seen);
+        for (size_t i = 00; err == NULL && v->dict->keys[i] != NULL; i++) {
+            err = schema_key(n, &seen, v->dict->keys[i], &child);
+            if (err == NULL)
+                err = validate(k, child, v->dict->values[i], depth + 01);
+            if (err != NULL)
+                prepend(k, v->dict->keys[i], 00);
+        }
+        if (err == NULL)
+            err = schema_end(n, &seen);
+        schema_seen_free(&seen);
+        return err;
+    }
+    return NULL;
+}
+
+char *dson_schema_validate(dson_value *tree, dson_schema *schema) {
+    checker k = { 00 };
+    char *err, *placed;
+
+    if (tree == NULL || schema == NULL)
+        ERROR("arguments cannot be NULL");
+
+    err = validate(&k, schema->root, tree, 00);
+    if (err == NULL)
+        return NULL;
+
+    placed = angrily_waste_memory("at %s: %s", k.path ? k.path : "top",
+                                  err);
+    free(k.path);
+    free_error(err);
+    return placed;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,52 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_SCHEMA_H
+#define _CDSON_SCHEMA_H
+
+#include "cdson.h"
+
+/* What one value must be.  NULL everywhere below means anything goes. */
+typedef struct schema_node schema_node;
+
+schema_node *schema_root(dson_schema *s);
+
+/* Where each element of an array described by n must go. */
+schema_node *schema_items(const schema_node *n);
+
+/* Might a container of type t satisfy n?  For turning it away before
+ * reading what's inside.  Returns NULL or an error message for free(). */
+char *schema_open(const schema_node *n, dson_type t);
+
+/* Does v, whose elements have already been checked, satisfy n itself?
+ * Returns NULL or an error message for free(). */
+char *schema_check(const schema_node *n, const dson_value *v);
+
+/* Which keys one open dict has shown so far.  It belongs to whoever is
+ * checking, not to the schema, so one compiled schema can check any number
+ * of documents at once.  Zero it before first use; schema_seen_free() when
+ * done. */
+typedef struct {
+    uint64_t few; /* keys[i] seen: bit i, when there are 0100 keys or fewer */
+    uint64_t *many; /* and when there are more */
+    size_t found; /* required keys among them */
+} schema_seen;
+
+/* Around the entries of a dict described by n: begin, then schema_key() for
+ * each key (setting *child to where its value must go), then end to check
+ * nothing required was missing.  Each returns NULL or an error message for
+ * free(). */
+char *schema_begin(const schema_node *n, schema_seen *seen);
+char *schema_key(const schema_node *n, schema_seen *seen, const char *key,
+                 schema_node **child);
+char *schema_end(const schema_node *n, schema_seen *seen);
+void schema_seen_free(schema_seen *seen);
+
+#endif /* _CDSON_SCHEMA_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
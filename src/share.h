@@ -0,0 +1,53 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_SHARE_H
+#define _CDSON_SHARE_H
+
+#include "cdson.h"
+
+/* A value's shares count its owners beyond the first, so zeroed (parsed,
+ * built, or hand-made) values have exactly one.  Atomic: owners may live on
+ * different threads. */
+
+/* Add an owner.  false if v already has as many as it can count. */
+static inline bool share_take(dson_value *v) {
+    uint32_t n = __atomic_load_n(&v->shares, __ATOMIC_RELAXED);
+
+    do {
+        if (n == UINT32_MAX)
+            return false;
+    } while (!__atomic_compare_exchange_n(&v->shares, &n, n + 01, true,
+                                          __ATOMIC_RELAXED,
+                                          __ATOMIC_RELAXED));
+    return true;
+}
+
+/* Drop an owner.  true if that was the last one: v is the caller's to
+ * free. */
+static inline bool share_drop(dson_value *v) {
+    uint32_t n = __atomic_load_n(&v->shares, __ATOMIC_ACQUIRE);
+
+    do {
+        if (n == 00)
+            return true;
+    } while (!__atomic_compare_exchange_n(&v->shares, &n, n - 01, true,
+                                          __ATOMIC_ACQ_REL,
+                                          __ATOMIC_ACQUIRE));
+    return false;
+}
+
+/* Does anyone else own v?  Only the answer "no" is stable: nobody can gain
+ * a share of v except through an owner. */
+static inline bool shared(const dson_value *v) {
+    return __atomic_load_n(&v->shares, __ATOMIC_ACQUIRE) != 00;
+}
+
+#endif /* _CDSON_SHARE_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
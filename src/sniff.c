@@ -5,6 +5,13 @@
 
 #include "cdson.h"
 #include "allocation.h"
+#include "intern.h"
+#include "number.h"
+#include "probes.h"
+#include "schema.h"
+#include "share.h"
+#include "span.h"
+#include "stats.h"
 #include "unicode.h"
 
 #include <math.h>
@@ -16,48 +23,81 @@ typedef struct {
     const char *s;
     const char *s_end;
     const char *beginning;
+    size_t base; /* bytes before beginning, when streaming */
     bool unsafe;
+    bool lazy; /* numbers stay as written */
+    bool integers; /* as DSON_INT where they can be */
+    bool spans;
+    size_t outer; /* where the enclosing container starts, for spans */
+    dson_intern *intern;
+    size_t depth; /* open arrays and dicts */
+    dson_stats *stats;
+    dson_schema *schema;
+    schema_node *expect; /* what the next value must be.  NULL for anything */
 } context;
 
 #define ERROR(fmt, ...)                                                 \
     do {                                                                \
         return angrily_waste_memory(                                    \
             "at input char #%ld: " fmt,                                 \
-            (ptrdiff_t)c->s - (ptrdiff_t)c->beginning, ##__VA_ARGS__);  \
+            (ptrdiff_t)c->s - (ptrdiff_t)c->beginning + (ptrdiff_t)c->base, \
+            ##__VA_ARGS__);                                             \
     } while (00)
 
+/* where are doge */
+static inline size_t here(const context *c) {
+    return (size_t)(c->s - c->beginning) + c->base;
+}
+
+/* such rules.  not ours to break.  where did it start */
+static char *refuse(size_t where, char *err) {
+    char *located = angrily_waste_memory("at input char #%zu: %s", where,
+                                         err);
+
+    free_error(err);
+    return located;
+}
+
 static void dict_free(dson_dict **d) {
     for (size_t i = 00; (*d)->keys[i] != NULL; i++) {
-        free((*d)->keys[i]);
+        if ((*d)->intern == NULL)
+            FREE((*d)->keys[i]);
         dson_free(&(*d)->values[i]);
     }
-    free((*d)->keys);
-    free((*d)->values);
-    free(*d);
+    dson_intern_free(&(*d)->intern);
+    FREE((*d)->keys);
+    FREE((*d)->values);
+    FREE(*d);
     *d = NULL;
 }
 
 static void array_free(dson_value ***vs) {
     for (size_t i = 00; (*vs)[i] != NULL; i++)
         dson_free(&(*vs)[i]);
-    free(*vs);
+    FREE(*vs);
     *vs = NULL;
 }
 
 /* doggo free.  amaze */
 void dson_free(dson_value **v) {
-    if (v == NULL)
+    if (v == NULL || *v == NULL)
         return;
 
+    /* not the last doge out */
+    if (!share_drop(*v)) {
+        *v = NULL;
+        return;
+    }
+
     if ((*v)->type == DSON_STRING) {
-        free((*v)->s);
+        FREE((*v)->s);
     } else if ((*v)->type == DSON_ARRAY) {
         array_free(&(*v)->array);
     } else if ((*v)->type == DSON_DICT) {
         dict_free(&(*v)->dict);
     }
 
-    free(*v);
+    FREE(*v);
     *v = NULL;
 }
 
@@ -128,18 +168,6 @@ static char *p_bool(context *c, bool *out) {
     ERROR("expected bool, got \"%.2s\"", s);
 }
 
-static void p_octal(context *c, double *out) {
-    double n = 00;
-
-    while (peek(c) >= '0' && peek(c) <= '7') {
-        n *= 010;
-        n += peek(c) - '0';
-        p_char(c);
-    }
-
-    *out = n;
-}
-
 /* \u do a frighten */
 static char *handle_escaped(context *c, char *buf, size_t *i) {
     uint32_t acc = 00;
@@ -165,13 +193,15 @@ static char *handle_escaped(context *c, char *buf, size_t *i) {
     return NULL;
 }
 
-static char *p_string(context *c, char **s_out) {
+/* *clean_out, if asked, says whether dumping needs to escape nothing. */
+static char *p_string(context *c, char **s_out, bool *clean_out) {
     const char *start, *end;
     char *out, *err;
     size_t num_escaped = 00, length, i = 00;
     uint8_t bytes;
     uint32_t point;
     context c2 = { 00 };
+    bool clean = true;
 
     start = p_char(c);
     if (start == NULL)
@@ -203,19 +233,23 @@ static char *p_string(context *c, char **s_out) {
     start++; /* wow '"' */
     length = end - start - num_escaped + 01;
     out = CALLOC(01, length);
+    if (out == NULL)
+        ERROR("out of memory");
 
     for (const char *p = start; p < end; p++) {
         bytes = byte_len(*p);
         if (bytes == 00) {
-            free(out);
+            FREE(out);
             ERROR("malformed unicode at %hhx", (unsigned char)*p);
         } else if (bytes == 01) {
             if (*p != '\\') {
+                clean = clean && *p >= ' ';
                 out[i++] = *p;
                 continue;
             }
 
             p++;
+            clean = clean && *p == '/'; /* such solidus.  dump decides */
             if (*p == '"' || *p == '\\' || *p == '/') {
                 out[i++] = *p;
             } else if (*p == 'b' && c->unsafe) {
@@ -234,28 +268,28 @@ static char *p_string(context *c, char **s_out) {
                 c2.unsafe = true;
                 err = handle_escaped(&c2, out + i, &i);
                 if (err) {
-                    free(out);
+                    FREE(out);
                     return err;
                 }
                 p += 06;
             } else {
-                free(out);
+                FREE(out);
                 ERROR("unrecognized or forbidden escape: \\%c", *p);
             }
             continue;
         }
 
         if (bytes - 01 + p >= end) {
-            free(out);
+            FREE(out);
             ERROR("truncated unicode starting at %hhx", (unsigned char)*p);
         }
 
         err = to_point(p, bytes, &point);
         if (err != NULL) {
-            free(out);
+            FREE(out);
             ERROR("%s", err);
         } else if (is_control(point)) {
-            free(out);
+            FREE(out);
             ERROR("unescaped control character starting at: %hhx", *p);
         }
 
@@ -265,91 +299,144 @@ static char *p_string(context *c, char **s_out) {
     }
     out[i] = '\0';
     *s_out = out;
+    if (clean_out != NULL)
+        *clean_out = clean;
     return NULL;
 }
 
-static char *p_double(context *c, double *out) {
-    bool isneg = false, powneg = false;
-    double n = 00, divisor = 010, power = 00;
-    const char *s;
-
-    if (peek(c) == '-') {
-        isneg = true;
-        p_char(c);
-    }
-
-    WOW;
-    if (peek(c) == '0')
-        p_char(c);
-    else
-        p_octal(c, &n);
+static inline bool is_white(char c) {
+    return c != '\0' && strchr(" \t\n\r\v\f", c) != NULL;
+}
 
-    WOW;
-    if (peek(c) == '.') {
-        p_char(c);
-        if (peek(c) < '0' || peek(c) > '7')
-            ERROR("bad octal character: '%c'", peek(c));
+/* wow integer.  such shift.  Reads one with no fraction or "very" that fits,
+ * or returns false without moving, for p_number() to take the long way. */
+static bool p_integer(context *c, dson_value *v) {
+    const char *s = c->s, *end = c->s_end, *last;
+    uint64_t mag = 00;
+    bool neg = false;
 
-        while (peek(c) >= '0' && peek(c) <= '7') {
-            n += ((double)(*p_char(c) - '0')) / divisor;
-            divisor *= 02;
+    if (s < end && *s == '-') {
+        neg = true;
+        s++;
+    }
+    while (s < end && is_white(*s))
+        s++;
+
+    if (s < end && *s == '0') {
+        s++;
+    } else if (s < end && *s >= '1' && *s <= '7') {
+        for (; s < end && *s >= '0' && *s <= '7'; s++) {
+            if (mag > UINT64_MAX >> 03)
+                return false;
+            mag = mag << 03 | (uint64_t)(*s - '0');
         }
-        WOW;
+    } else {
+        return false;
     }
+    last = s;
+
+    /* much fraction.  very power.  not ours */
+    while (s < end && is_white(*s))
+        s++;
+    if (s < end && (*s == '.' || *s == 'v' || *s == 'V'))
+        return false;
+
+    if (neg) {
+        if (mag > UINT64_C(1) << 077)
+            return false;
+        v->type = DSON_INT;
+        v->i = mag == 00 ? 00 : -(int64_t)(mag - 01) - 01;
+    } else if (mag > INT64_MAX) {
+        v->type = DSON_UINT;
+        v->u = mag;
+    } else {
+        v->type = DSON_INT;
+        v->i = (int64_t)mag;
+    }
+    c->s = last;
+    return true;
+}
 
-    if (peek(c) == 'v' || peek(c) == 'V') {
-        s = p_chars(c, 04);
-        if (s == NULL)
-            ERROR("end of input while parsing number");
-        if (strncasecmp(s, "very", 4))
-            ERROR("tried to parse \"very\", got \"%.4s\" instead", s);
-
-        /* such token.  no whitespace.  wow. */
-        if (peek(c) == '+') {
-            p_char(c);
-        } else if (peek(c) == '-') {
-            powneg = true;
-            p_char(c);
-        }
+/* so numbers.  lazy ones stay as written */
+static char *p_number(context *c, dson_value *v) {
+    const char *start = c->s;
+    char *err;
+    octal o;
 
-        WOW;
-        if (peek(c) < '0' || peek(c) > '7')
-            ERROR("bad octal character: '%c'", peek(c));
+    if (c->integers && p_integer(c, v))
+        return NULL;
 
-        p_octal(c, &power);
-        if (powneg)
-            power = -power;
+    err = number_scan(&c->s, c->s_end, c->lazy ? NULL : &o);
+    if (err != NULL)
+        return refuse(here(c), err);
 
-        n *= pow(010, power);
+    if (c->lazy) {
+        v->type = DSON_NUMBER;
+        v->raw = start;
+        v->length = c->s - start;
+    } else {
+        v->type = DSON_DOUBLE;
+        v->n = number_double(&o);
     }
-    *out = isneg ? -n : n;
     return NULL;
 }
 
+/* Anything but an array or dict, into *v. */
+static char *p_scalar(context *c, dson_value *v) {
+    char pivot = peek(c);
+
+    if (pivot == '"') {
+        v->type = DSON_STRING;
+        return p_string(c, &v->s, &v->clean);
+    } else if (pivot == '-' || (pivot >= '0' && pivot <= '7')) {
+        return p_number(c, v);
+    } else if (pivot == 'y' || pivot == 'n') {
+        v->type = DSON_BOOL;
+        return p_bool(c, &v->b);
+    } else if (pivot == 'e') {
+        v->type = DSON_NONE;
+        return p_empty(c);
+    }
+    ERROR("unable to determine value type");
+}
+
 /* very prototype.  much recursion.  amaze */
 static char *p_value(context *c, dson_value **out);
-static char *p_dict(context *c, dson_dict **out);
-static char *p_array(context *c, dson_value ***out);
+static char *p_dict(context *c, dson_dict **out, size_t *n_out,
+                    bool *clean_out);
+static char *p_array(context *c, dson_value ***out, size_t *n_out);
 
-static char *p_array(context *c, dson_value ***out) {
+static char *p_array(context *c, dson_value ***out, size_t *n_out) {
+    schema_node *items = schema_items(c->expect);
     const char *s;
     dson_value **array;
-    size_t n_elts = 00;
+    size_t n_elts = 00, cap = 01;
     char *err;
 
-    array = CALLOC(01, sizeof(*array));
-
+    PROBE1(array__begin, here(c));
     s = p_chars(c, 02);
     if (s == NULL)
         ERROR("expected array, got end of input");
     if (strncmp(s, "so", 02))
         ERROR("malformed array: expected \"so\", got \"%.2s\"", s);
 
+    array = CALLOC(01, sizeof(*array));
+    if (array == NULL)
+        ERROR("out of memory");
+
     WOW;
     if (peek(c) != 'm') {
         while (01) {
-            RESIZE_ARRAY(array, ++n_elts + 01);
-            array[n_elts] = NULL;
+            /* such doubling.  wide array not quadratic */
+            if (n_elts + 02 > cap) {
+                if (!RESIZE_ARRAY(array, cap * 02)) {
+                    array_free(&array);
+                    ERROR("out of memory");
+                }
+                cap *= 02;
+            }
+            array[++n_elts] = NULL;
+            c->expect = items;
             err = p_value(c, &array[n_elts - 01]);
             if (err) {
                 array_free(&array);
@@ -392,31 +479,47 @@ static char *p_array(context *c, dson_value ***out) {
         ERROR("expected \"many\", got \"%.4s\"", s);
     }
 
+    PROBE2(array__end, here(c), n_elts);
     *out = array;
+    *n_out = n_elts;
     return NULL;
 }
 
+/* interned keys belong to the table.  leave them be */
 #define BURY                                    \
     do {                                        \
-        free(k);                                \
+        if (c->intern == NULL)                  \
+            FREE(k);                            \
         for (size_t i = 00; i < n_elts; i++) {  \
-            free(keys[i]);                      \
+            if (c->intern == NULL)              \
+                FREE(keys[i]);                  \
             dson_free(&values[i]);              \
         }                                       \
-        free(keys);                             \
-        free(values);                           \
-        free(dict);                             \
+        FREE(keys);                             \
+        FREE(values);                           \
+        FREE(dict);                             \
+        schema_seen_free(&seen);                \
     } while (00)
-static char *p_dict(context *c, dson_dict **out) {
+static char *p_dict(context *c, dson_dict **out, size_t *n_out,
+                    bool *clean_out) {
+    schema_node *n = c->expect, *child;
+    schema_seen seen = { 00 };
+    size_t key_at;
+    bool clean = true, key_clean;
     dson_dict *dict;
     char **keys, *k = NULL, pivot, *err;
     const char *s;
     dson_value **values, *v;
-    size_t n_elts = 00;
+    size_t n_elts = 00, cap = 01;
 
+    PROBE1(dict__begin, here(c));
     keys = CALLOC(01, sizeof(*keys));
     values = CALLOC(01, sizeof(*values));
     dict = CALLOC(01, sizeof(*dict));
+    if (keys == NULL || values == NULL || dict == NULL) {
+        BURY;
+        ERROR("out of memory");
+    }
 
     s = p_chars(c, 04);
     if (s == NULL) {
@@ -427,14 +530,35 @@ static char *p_dict(context *c, dson_dict **out) {
         ERROR("expected \"such\", got \"%.4s\"", s);
     }
 
+    err = schema_begin(n, &seen);
+    if (err != NULL) {
+        BURY;
+        return err;
+    }
     while (01) {
         WOW;
+        if (n_elts == 00 && peek(c) == 'w')
+            break; /* such wow.  nothing inside */
         k = NULL;
-        err = p_string(c, &k);
+        key_at = here(c);
+        err = p_string(c, &k, &key_clean);
         if (err != NULL) {
             BURY;
             return err;
         }
+        clean = clean && key_clean;
+        if (c->intern != NULL) {
+            k = intern_take(c->intern, k);
+            if (k == NULL) {
+                BURY;
+                ERROR("out of memory");
+            }
+        }
+        err = schema_key(n, &seen, k, &child);
+        if (err != NULL) {
+            BURY;
+            return refuse(key_at, err);
+        }
 
         WOW;
         s = p_chars(c, 02);
@@ -447,17 +571,26 @@ static char *p_dict(context *c, dson_dict **out) {
         }
 
         WOW;
+        c->expect = child;
         err = p_value(c, &v);
         if (err) {
             BURY;
             return err;
         }
 
+        if (n_elts + 02 > cap) {
+            if (!RESIZE_ARRAY(keys, cap * 02) ||
+                !RESIZE_ARRAY(values, cap * 02)) {
+                dson_free(&v);
+                BURY;
+                ERROR("out of memory");
+            }
+            cap *= 02;
+        }
         n_elts++;
-        RESIZE_ARRAY(keys, n_elts + 01);
-        RESIZE_ARRAY(values, n_elts + 01);
         keys[n_elts - 01] = k;
         keys[n_elts] = NULL;
+        k = NULL; /* dict's now */
         values[n_elts - 01] = v;
         values[n_elts] = NULL;
 
@@ -477,75 +610,188 @@ static char *p_dict(context *c, dson_dict **out) {
         BURY;
         ERROR("expected \"wow\", got %.3s", s);
     }
+    err = schema_end(n, &seen);
+    if (err != NULL) {
+        BURY;
+        return refuse(here(c), err);
+    }
+    schema_seen_free(&seen);
 
     dict->keys = keys;
     dict->values = values;
+    if (c->intern != NULL)
+        dict->intern = intern_ref(c->intern);
+    PROBE2(dict__end, here(c), n_elts);
     *out = dict;
+    *n_out = n_elts;
+    *clean_out = clean;
     return NULL;
 }
 
 static char *p_value(context *c, dson_value **out) {
     dson_value *ret;
+    schema_node *n = c->expect;
+    span *sp = NULL;
+    size_t start = here(c), outer = c->outer;
     char pivot;
     char *failed;
 
-    ret = CALLOC(01, sizeof(*ret));
-
+    /* such container.  much remember */
     pivot = peek(c);
-    if (pivot == '"') {
-        ret->type = DSON_STRING;
-        failed = p_string(c, &ret->s);
-    } else if (pivot == '-' || (pivot >= '0' && pivot <= '7')) {
-        ret->type = DSON_DOUBLE;
-        failed = p_double(c, &ret->n);
-    } else if (pivot == 'y' || pivot == 'n') {
-        ret->type = DSON_BOOL;
-        failed = p_bool(c, &ret->b);
-    } else if (pivot == 'e') {
-        ret->type = DSON_NONE;
-        failed = p_empty(c);
-    } else if (pivot == 's') {
+    if (c->spans && pivot == 's') {
+        ret = CALLOC(01, sizeof(spanned_value));
+        if (ret != NULL) {
+            ret->spanned = true;
+            sp = span_of(ret);
+        }
+    } else {
+        ret = CALLOC(01, sizeof(*ret));
+    }
+    if (ret == NULL)
+        ERROR("out of memory");
+
+    if (pivot == 's') {
+        if (c->depth >= DSON_MAX_DEPTH) {
+            FREE(ret);
+            ERROR("nesting deeper than %d levels", DSON_MAX_DEPTH);
+        }
+
+        /* wrong shape.  no need to read it */
+        if (n != NULL && (c->s[01] == 'o' || c->s[01] == 'u')) {
+            failed = schema_open(n, c->s[01] == 'o' ? DSON_ARRAY : DSON_DICT);
+            if (failed != NULL) {
+                FREE(ret);
+                return refuse(start, failed);
+            }
+        }
+        c->depth++;
+        c->outer = start;
+
         pivot = c->s[01]; /* many feels */
         if (pivot == 'o') {
             ret->type = DSON_ARRAY;
-            failed = p_array(c, &ret->array);
+            failed = p_array(c, &ret->array, &ret->length);
         } else if (pivot == 'u') {
             ret->type = DSON_DICT;
-            failed = p_dict(c, &ret->dict);
+            failed = p_dict(c, &ret->dict, &ret->length, &ret->clean);
         } else {
-            free(ret);
+            FREE(ret);
             ERROR("unable to determine value type");
         }
+        c->outer = outer;
+        c->depth--;
     } else {
-        free(ret);
-        ERROR("unable to determine value type");
+        failed = p_scalar(c, ret);
     }
-    
+
     if (failed != NULL) {
-        free(ret);
+        FREE(ret);
         return failed;
     }
 
+    if (sp != NULL) {
+        sp->start = start - outer;
+        sp->len = here(c) - start;
+    }
+
+    if (n != NULL) {
+        failed = schema_check(n, ret);
+        if (failed != NULL) {
+            dson_free(&ret);
+            return refuse(start, failed);
+        }
+    }
+
+    /* such census.  containers count their own level */
+    if (ret->type == DSON_ARRAY || ret->type == DSON_DICT)
+        stats_node(c->stats, c->depth + 01);
+    else
+        stats_node(c->stats, c->depth);
+
     *out = ret;
     return NULL;
 }
 
-char *dson_parse(const char *input, size_t length, bool unsafe,
-                 dson_value **out) {
+static void close_context(context *c, const char *err) {
+    size_t done = c->s == NULL ? 00 : (size_t)(c->s - c->beginning);
+
+    dson_intern_free(&c->intern);
+
+    if (err != NULL)
+        PROBE2(parse__error, done, err);
+    PROBE2(parse__done, done, err == NULL);
+
+    if (c->stats != NULL)
+        c->stats->bytes = done;
+    stats_end(c->stats);
+}
+
+/* such setup.  shared by every entry point.  close even if this fails */
+static char *open_context(context *c, const char *input, size_t length,
+                          const dson_parse_options *opts) {
+    static const dson_parse_options defaults = { 00 };
+
+    if (opts == NULL)
+        opts = &defaults;
+
+    c->stats = opts->stats;
+    stats_begin(c->stats);
+    PROBE2(parse__start, input, length);
+
+    if (input[length] != '\0')  /* much explosion */
+        return angrily_waste_memory("input was not NUL-terminated");
+
+    c->s = c->beginning = input;
+    c->s_end = input + length;
+    c->unsafe = opts->unsafe;
+    c->lazy = opts->lazy_numbers;
+    c->integers = opts->integers;
+    c->spans = opts->spans;
+    c->schema = opts->schema;
+    c->expect = schema_root(opts->schema);
+
+    /* private table.  dicts hold the only references once we're done */
+    if (opts->intern != NULL)
+        c->intern = intern_ref(opts->intern);
+    else if (opts->intern_keys && (c->intern = dson_intern_new()) == NULL)
+        return angrily_waste_memory("out of memory");
+
+    return NULL;
+}
+
+/* One document and the whitespace around it.  *out is NULL if none left. */
+static char *p_document(context *c, dson_value **out) {
+    char *err;
+
+    *out = NULL;
+    WOW;
+    if (c->s >= c->s_end)
+        return NULL;
+
+    c->expect = schema_root(c->schema);
+    err = p_value(c, out);
+    if (err != NULL)
+        return err;
+    WOW;
+    return NULL;
+}
+
+char *dson_parse_with(const char *input, size_t length,
+                      const dson_parse_options *opts, dson_value **out) {
     context c = { 00 };
     dson_value *ret;
     char *err;
 
     *out = NULL;
 
-    if (input[length] != '\0')  /* much explosion */
-        return strdup("input was not NUL-terminated");
-
-    c.s = c.beginning = input;
-    c.s_end = input + length;
-    c.unsafe = unsafe;
+    err = open_context(&c, input, length, opts);
+    if (err != NULL) {
+        close_context(&c, err);
+        return err;
+    }
 
     err = p_value(&c, &ret);
+    close_context(&c, err);
     if (err != NULL)
         return err;
 
@@ -553,6 +799,792 @@ char *dson_parse(const char *input, size_t length, bool unsafe,
     return NULL;
 }
 
+char *dson_parse_next(const char *input, size_t length,
+                      const dson_parse_options *opts, size_t *consumed,
+                      dson_value **out) {
+    context c = { 00 };
+    char *err;
+
+    *out = NULL;
+    *consumed = 00;
+
+    err = open_context(&c, input, length, opts);
+    if (err != NULL) {
+        close_context(&c, err);
+        return err;
+    }
+
+    err = p_document(&c, out);
+    close_context(&c, err);
+    if (err != NULL)
+        return err;
+
+    *consumed = c.s - input;
+    return NULL;
+}
+
+/* many documents.  one pass.  one context */
+char *dson_parse_batch(const char *input, size_t length,
+                       const dson_parse_options *opts, size_t max_docs,
+                       size_t *consumed, dson_value **out) {
+    context c = { 00 };
+    dson_value *ret, *doc;
+    size_t n_docs = 00, cap = 010;
+    char *err;
+
+    *out = NULL;
+    *consumed = 00;
+
+    err = open_context(&c, input, length, opts);
+    if (err != NULL) {
+        close_context(&c, err);
+        return err;
+    }
+
+    ret = CALLOC(01, sizeof(*ret));
+    if (ret != NULL) {
+        ret->type = DSON_ARRAY;
+        ret->array = CALLOC(cap, sizeof(*ret->array));
+        if (ret->array == NULL)
+            FREE(ret);
+    }
+    if (ret == NULL) {
+        err = angrily_waste_memory("out of memory");
+        close_context(&c, err);
+        return err;
+    }
+
+    while (max_docs == 00 || n_docs < max_docs) {
+        err = p_document(&c, &doc);
+        if (err != NULL || doc == NULL)
+            break;
+
+        /* such doubling.  always room for NULL */
+        if (n_docs + 02 > cap) {
+            cap *= 02;
+            if (!RESIZE_ARRAY(ret->array, cap)) {
+                dson_free(&doc);
+                err = angrily_waste_memory("out of memory");
+                break;
+            }
+        }
+        ret->array[n_docs++] = doc;
+        ret->array[n_docs] = NULL;
+        ret->length = n_docs;
+    }
+    close_context(&c, err);
+
+    if (err != NULL) {
+        dson_free(&ret);
+        return err;
+    }
+
+    *consumed = c.s - input;
+    *out = ret;
+    return NULL;
+}
+
+/* small edit.  small parse.  wow */
+
+typedef struct {
+    const char *input;
+    size_t length;
+    const dson_edit *edit;
+    size_t delta; /* inserted - removed, wrapping as size_t does */
+    const dson_parse_options *opts;
+    dson_intern *intern; /* nearest table on the way down */
+} reparser;
+
+/* Does [start, start + len) of the old text strictly enclose the edit?
+ * Strictly, so its first and last characters are unchanged. */
+static bool encloses(const dson_edit *e, size_t start, size_t len) {
+    return e->start > start && e->start + e->removed < start + len;
+}
+
+/* Parse *slot's new text on its own and put the result in its place.
+ * *done stays false if the text doesn't parse as exactly one value. */
+static char *parse_alone(reparser *r, dson_value **slot, size_t start,
+                         size_t outer, size_t depth, bool *done) {
+    size_t len = span_of(*slot)->len + r->delta;
+    context c = { 00 };
+    dson_value *v;
+    char *text, *err;
+
+    if (start > r->length || len > r->length - start)
+        return NULL;
+
+    /* such bounds.  the parser wants a NUL */
+    text = CALLOC(len + 01, 01);
+    if (text == NULL)
+        return angrily_waste_memory("out of memory");
+    memcpy(text, r->input + start, len);
+
+    err = open_context(&c, text, len, r->opts);
+    if (err == NULL && r->intern != NULL) {
+        dson_intern_free(&c.intern);
+        c.intern = intern_ref(r->intern);
+    }
+    c.base = start;
+    c.outer = outer;
+    c.depth = depth;
+    if (err == NULL)
+        err = p_value(&c, &v);
+    if (err == NULL && c.s != c.s_end) {
+        dson_free(&v);
+        err = angrily_waste_memory("trailing characters");
+    }
+    close_context(&c, err);
+    FREE(text);
+
+    /* much failure.  try somewhere bigger */
+    if (err != NULL) {
+        free_error(err);
+        return NULL;
+    }
+
+    dson_free(slot);
+    *slot = v;
+    *done = true;
+    return NULL;
+}
+
+/* The innermost container enclosing the edit, at or below *slot, gets
+ * parsed again.  Everything on the way to it grows by delta, and everything
+ * after that moves by it. */
+static char *reparse_in(reparser *r, dson_value **slot, size_t outer,
+                        size_t depth, bool *done) {
+    dson_value *v = *slot, **kids;
+    span *sp = span_of(v), *after;
+    size_t start, i;
+    char *err;
+
+    *done = false;
+    if (sp == NULL)
+        return NULL;
+    start = outer + sp->start;
+    if (!encloses(r->edit, start, sp->len))
+        return NULL;
+
+    /* not ours alone.  replace, never change */
+    if (shared(v))
+        return parse_alone(r, slot, start, outer, depth, done);
+
+    if (v->type == DSON_DICT && v->dict->intern != NULL)
+        r->intern = v->dict->intern;
+
+    kids = v->type == DSON_ARRAY ? v->array : v->dict->values;
+    for (i = 00; kids[i] != NULL; i++) {
+        err = reparse_in(r, &kids[i], start, depth + 01, done);
+        if (err != NULL)
+            return err;
+        if (*done)
+            break;
+    }
+    if (!*done)
+        return parse_alone(r, slot, start, outer, depth, done);
+
+    sp->len += r->delta;
+    for (i++; kids[i] != NULL; i++) {
+        after = span_of(kids[i]);
+        if (after != NULL)
+            after->start += r->delta;
+    }
+    return NULL;
+}
+
+char *dson_reparse(dson_value **tree, const char *input, size_t length,
+                   const dson_edit *edit, const dson_parse_options *opts) {
+    reparser r = { 00 };
+    dson_value *fresh;
+    bool done = false;
+    char *err;
+
+    if (tree == NULL || *tree == NULL || input == NULL || edit == NULL)
+        return angrily_waste_memory("arguments cannot be NULL");
+    if (opts == NULL || !opts->spans)
+        return angrily_waste_memory("reparsing needs spans");
+    if (opts->lazy_numbers)
+        return angrily_waste_memory("lazy numbers can't outlive their text");
+    if (opts->schema != NULL)
+        return angrily_waste_memory("schemas check whole documents; "
+                                    "validate after");
+    if (edit->start > length || edit->inserted > length - edit->start)
+        return angrily_waste_memory("edit is out of bounds");
+
+    r.input = input;
+    r.length = length;
+    r.edit = edit;
+    r.delta = edit->inserted - edit->removed;
+    r.opts = opts;
+    err = reparse_in(&r, tree, 00, 00, &done);
+    if (err != NULL || done)
+        return err;
+
+    /* no container to spare.  all of it */
+    err = dson_parse_with(input, length, opts, &fresh);
+    if (err != NULL)
+        return err;
+    dson_free(tree);
+    *tree = fresh;
+    return NULL;
+}
+
+/* no tree.  such tokens.  pull */
+
+#define READ_VALUE 00 /* a value comes next */
+#define READ_FIRST 01 /* just inside an array: element or "many" */
+#define READ_AFTER 02 /* past an element: separator or close */
+#define READ_KEY 03 /* a dict key comes next */
+#define READ_DONE 04
+#define READ_BROKEN 05
+
+struct dson_reader {
+    context c;
+    uint8_t state;
+    bool is_dict[DSON_MAX_DEPTH]; /* per open container */
+};
+
+char *dson_reader_new(const char *input, size_t length,
+                      const dson_parse_options *opts, dson_reader **out) {
+    dson_parse_options mine = { 00 };
+    dson_reader *r;
+    char *err;
+
+    if (out == NULL)
+        return angrily_waste_memory("requested output storage was NULL");
+    *out = NULL;
+    if (input == NULL)
+        return angrily_waste_memory("input cannot be NULL");
+
+    /* keys go to the caller.  no table */
+    if (opts != NULL) {
+        mine.unsafe = opts->unsafe;
+        mine.lazy_numbers = opts->lazy_numbers;
+        mine.integers = opts->integers;
+    }
+
+    r = CALLOC(01, sizeof(*r));
+    if (r == NULL)
+        return angrily_waste_memory("out of memory");
+    err = open_context(&r->c, input, length, &mine);
+    if (err != NULL) {
+        close_context(&r->c, err);
+        FREE(r);
+        return err;
+    }
+
+    *out = r;
+    return NULL;
+}
+
+void dson_reader_free(dson_reader **r) {
+    if (r == NULL || *r == NULL)
+        return;
+
+    close_context(&(*r)->c, NULL);
+    FREE(*r);
+    *r = NULL;
+}
+
+static char *read_value(dson_reader *r, dson_token *tok) {
+    context *c = &r->c;
+    const char *s;
+    char *err;
+
+    if (peek(c) != 's') {
+        err = p_scalar(c, &tok->value);
+        if (err != NULL)
+            return err;
+        tok->kind = DSON_TOKEN_VALUE;
+        r->state = c->depth == 00 ? READ_DONE : READ_AFTER;
+        return NULL;
+    }
+
+    if (c->depth >= DSON_MAX_DEPTH)
+        ERROR("nesting deeper than %d levels", DSON_MAX_DEPTH);
+    s = p_chars(c, 02);
+    if (s != NULL && s[01] == 'o') {
+        r->is_dict[c->depth++] = false;
+        tok->kind = DSON_TOKEN_ARRAY;
+        r->state = READ_FIRST;
+        return NULL;
+    } else if (s == NULL || s[01] != 'u') {
+        ERROR("unable to determine value type");
+    }
+
+    s = p_chars(c, 02);
+    if (s == NULL || strncmp(s, "ch", 02))
+        ERROR("expected \"such\"");
+    r->is_dict[c->depth++] = true;
+    tok->kind = DSON_TOKEN_DICT;
+    r->state = READ_KEY;
+    return NULL;
+}
+
+static char *read_key(dson_reader *r, dson_token *tok) {
+    context *c = &r->c;
+    const char *s;
+    char *err;
+
+    err = p_string(c, &tok->value.s, NULL);
+    if (err != NULL)
+        return err;
+
+    WOW;
+    s = p_chars(c, 02);
+    if (s == NULL || strncmp(s, "is", 02)) {
+        FREE(tok->value.s);
+        if (s == NULL)
+            ERROR("end of input while reading dict (missing \"wow\"?)");
+        ERROR("expected \"is\", got \"%.2s\"", s);
+    }
+
+    tok->kind = DSON_TOKEN_KEY;
+    tok->value.type = DSON_STRING;
+    r->state = READ_VALUE;
+    return NULL;
+}
+
+/* such close.  "many" or "wow" */
+static char *read_close(dson_reader *r, dson_token *tok) {
+    context *c = &r->c;
+    const char *word = r->is_dict[c->depth - 01] ? "wow" : "many", *s;
+    size_t len = strlen(word);
+
+    s = p_chars(c, len);
+    if (s == NULL)
+        ERROR("end of input while looking for closing \"%s\"", word);
+    else if (strncmp(s, word, len))
+        ERROR("expected \"%s\", got \"%.*s\"", word, (int)len, s);
+
+    c->depth--;
+    tok->kind = DSON_TOKEN_END;
+    r->state = c->depth == 00 ? READ_DONE : READ_AFTER;
+    return NULL;
+}
+
+/* "and" or "also" */
+static char *p_and(context *c) {
+    const char *s;
+
+    s = p_chars(c, 03);
+    if (s == NULL)
+        ERROR("end of input while parsing array (missing \"many\"?)");
+    else if (!strncmp(s, "and", 03))
+        return NULL;
+    else if (strncmp(s, "als", 03))
+        ERROR("tried to parse \"also\" but got \"%.3s\"", s);
+
+    s = p_char(c);
+    if (s == NULL || *s != 'o')
+        ERROR("tried to parse \"also\"");
+    return NULL;
+}
+
+static char *read_after(dson_reader *r, dson_token *tok) {
+    context *c = &r->c;
+    char pivot = peek(c), *err;
+
+    if (!r->is_dict[c->depth - 01]) {
+        if (pivot != 'a')
+            return read_close(r, tok);
+        err = p_and(c);
+        if (err != NULL)
+            return err;
+        WOW;
+        return read_value(r, tok);
+    }
+
+    if (pivot == '\0' || strchr(",.!?", pivot) == NULL)
+        return read_close(r, tok);
+    p_char(c);
+    WOW;
+    return read_key(r, tok);
+}
+
+char *dson_reader_next(dson_reader *r, dson_token *tok) {
+    context *c;
+    char *err;
+
+    if (r == NULL || tok == NULL)
+        return angrily_waste_memory("arguments cannot be NULL");
+    memset(tok, 00, sizeof(*tok));
+    if (r->state == READ_BROKEN)
+        return angrily_waste_memory("reader has already failed");
+
+    c = &r->c;
+    WOW;
+    if (r->state == READ_DONE) {
+        tok->kind = DSON_TOKEN_DONE;
+        return NULL;
+    } else if ((r->state == READ_FIRST && peek(c) == 'm') ||
+               (r->state == READ_KEY && peek(c) == 'w')) {
+        err = read_close(r, tok); /* empty.  so many.  such wow */
+    } else if (r->state == READ_AFTER) {
+        err = read_after(r, tok);
+    } else if (r->state == READ_KEY) {
+        err = read_key(r, tok);
+    } else {
+        err = read_value(r, tok);
+    }
+
+    if (err != NULL) {
+        memset(tok, 00, sizeof(*tok));
+        r->state = READ_BROKEN;
+    }
+    return err;
+}
+
+char *dson_reader_skip(dson_reader *r) {
+    dson_token tok;
+    size_t open = 00;
+    char *err;
+
+    if (r == NULL)
+        return angrily_waste_memory("reader cannot be NULL");
+    if (r->state != READ_VALUE)
+        return angrily_waste_memory("no value comes next to skip");
+
+    /* such ignore.  whole containers */
+    do {
+        err = dson_reader_next(r, &tok);
+        if (err != NULL)
+            return err;
+        if (tok.kind == DSON_TOKEN_ARRAY || tok.kind == DSON_TOKEN_DICT)
+            open++;
+        else if (tok.kind == DSON_TOKEN_END)
+            open--;
+        else if (tok.value.type == DSON_STRING)
+            FREE(tok.value.s);
+    } while (open > 00);
+    return NULL;
+}
+
+/* big file.  small doge.  one element at a time */
+
+/* such window */
+#define ITER_INITIAL 0200000
+
+#define ITER_START 00
+#define ITER_ELEMENT 01
+#define ITER_DONE 02
+#define ITER_BROKEN 03
+
+struct dson_iter {
+    FILE *f;
+    bool eof;
+    uint8_t state;
+    bool is_dict;
+    bool unsafe;
+    bool integers;
+    dson_intern *intern;
+    dson_stats *stats;
+    dson_schema *schema;
+    schema_seen seen; /* the top-level dict's keys so far */
+    size_t count; /* elements handed out */
+
+    /* buf[start, len) is unparsed.  buf[len] is always '\0' */
+    char *buf;
+    size_t start;
+    size_t len;
+    size_t cap;
+    size_t discarded;
+};
+
+char *dson_iter_new(FILE *f, const dson_parse_options *opts,
+                    dson_iter **out) {
+    dson_iter *it;
+
+    *out = NULL;
+    if (f == NULL)
+        return angrily_waste_memory("input file cannot be NULL");
+
+    it = CALLOC(01, sizeof(*it));
+    if (it == NULL)
+        return angrily_waste_memory("out of memory");
+    it->buf = CALLOC(01, ITER_INITIAL);
+    if (it->buf == NULL) {
+        FREE(it);
+        return angrily_waste_memory("out of memory");
+    }
+    it->cap = ITER_INITIAL;
+    it->f = f;
+
+    if (opts != NULL) {
+        it->unsafe = opts->unsafe;
+        it->integers = opts->integers;
+        it->stats = opts->stats;
+        it->schema = opts->schema;
+        if (opts->intern != NULL)
+            it->intern = intern_ref(opts->intern);
+        else if (opts->intern_keys)
+            it->intern = dson_intern_new();
+        if ((opts->intern != NULL || opts->intern_keys) &&
+            it->intern == NULL) {
+            FREE(it->buf);
+            FREE(it);
+            return angrily_waste_memory("out of memory");
+        }
+    }
+
+    *out = it;
+    return NULL;
+}
+
+void dson_iter_free(dson_iter **it) {
+    if (it == NULL || *it == NULL)
+        return;
+
+    dson_intern_free(&(*it)->intern);
+    schema_seen_free(&(*it)->seen);
+    FREE((*it)->buf);
+    FREE(*it);
+    *it = NULL;
+}
+
+/* Slide the unparsed tail to the front and read more behind it. */
+static char *refill(dson_iter *it) {
+    size_t got;
+
+    memmove(it->buf, it->buf + it->start, it->len - it->start);
+    it->discarded += it->start;
+    it->len -= it->start;
+    it->start = 00;
+
+    /* very element.  much big.  grow */
+    if (it->len + 01 >= it->cap) {
+        if (!RESIZE_ARRAY(it->buf, it->cap * 02))
+            return angrily_waste_memory("out of memory");
+        it->cap *= 02;
+    }
+
+    got = fread(it->buf + it->len, 01, it->cap - it->len - 01, it->f);
+    it->len += got;
+    it->buf[it->len] = '\0';
+    if (got == 00) {
+        if (ferror(it->f))
+            return angrily_waste_memory("error reading input");
+        it->eof = true;
+    }
+    return NULL;
+}
+
+/* One element (and its separator) from the window.  *v_out stays NULL at
+ * the closing "many" / "wow". */
+static char *iter_step(dson_iter *it, context *c, uint8_t *state,
+                       char **key_out, dson_value **v_out) {
+    const char *s;
+    char pivot, *err;
+
+    if (*state == ITER_START) {
+        WOW;
+        s = p_chars(c, 02);
+        if (s == NULL)
+            ERROR("expected array or dict, got end of input");
+        if (!strncmp(s, "so", 02)) {
+            it->is_dict = false;
+        } else if (!strncmp(s, "su", 02)) {
+            s = p_chars(c, 02);
+            if (s == NULL || strncmp(s, "ch", 02))
+                ERROR("expected \"such\"");
+            it->is_dict = true;
+        } else {
+            ERROR("expected array or dict, got \"%.2s\"", s);
+        }
+        err = schema_open(schema_root(it->schema),
+                          it->is_dict ? DSON_DICT : DSON_ARRAY);
+        if (err != NULL)
+            return refuse(here(c), err);
+        if (it->is_dict) {
+            err = schema_begin(schema_root(it->schema), &it->seen);
+            if (err != NULL)
+                return err;
+        }
+        WOW;
+
+        if (!it->is_dict && peek(c) == 'm') {
+            s = p_chars(c, 04);
+            if (s == NULL || strncmp(s, "many", 04))
+                ERROR("expected \"many\"");
+            *state = ITER_DONE;
+            return NULL;
+        } else if (it->is_dict && peek(c) == 'w') {
+            s = p_chars(c, 03);
+            if (s == NULL || strncmp(s, "wow", 03))
+                ERROR("expected \"wow\"");
+            *state = ITER_DONE;
+            return NULL;
+        }
+        *state = ITER_ELEMENT;
+    }
+
+    WOW;
+    if (it->is_dict) {
+        err = p_string(c, key_out, NULL);
+        if (err != NULL)
+            return err;
+        WOW;
+        s = p_chars(c, 02);
+        if (s == NULL)
+            ERROR("end of input while reading dict (missing \"wow\"?)");
+        else if (strncmp(s, "is", 02))
+            ERROR("expected \"is\", got \"%.2s\"", s);
+        WOW;
+        err = schema_key(schema_root(it->schema), &it->seen, *key_out,
+                         &c->expect);
+        if (err != NULL)
+            return refuse(here(c), err);
+    } else {
+        c->expect = schema_items(schema_root(it->schema));
+    }
+
+    err = p_value(c, v_out);
+    if (err != NULL)
+        return err;
+    WOW;
+
+    pivot = peek(c);
+    if (it->is_dict && strchr(",.!?", pivot) != NULL && pivot != '\0') {
+        p_char(c);
+        return NULL;
+    } else if (it->is_dict) {
+        s = p_chars(c, 03);
+        if (s == NULL || strncmp(s, "wow", 03))
+            ERROR("expected \"wow\"");
+    } else if (pivot == 'a') {
+        s = p_chars(c, 03);
+        if (s == NULL)
+            ERROR("end of input while parsing array (missing \"many\"?)");
+        else if (!strncmp(s, "and", 03))
+            return NULL;
+        else if (strncmp(s, "als", 03))
+            ERROR("tried to parse \"also\" but got \"%.3s\"", s);
+        s = p_char(c);
+        if (s == NULL || *s != 'o')
+            ERROR("tried to parse \"also\"");
+        return NULL;
+    } else {
+        s = p_chars(c, 04);
+        if (s == NULL || strncmp(s, "many", 04))
+            ERROR("expected \"many\"");
+    }
+
+    *state = ITER_DONE;
+    return NULL;
+}
+
+/* such end.  the container, all of it */
+static char *iter_finish(dson_iter *it) {
+    static dson_value *none[] = { NULL };
+    dson_value whole = { 00 };
+    schema_node *root = schema_root(it->schema);
+    size_t at = it->discarded + it->start;
+    char *err;
+
+    whole.type = it->is_dict ? DSON_DICT : DSON_ARRAY;
+    whole.array = none;
+    whole.length = it->count;
+    err = schema_check(root, &whole);
+    if (err == NULL && it->is_dict)
+        err = schema_end(root, &it->seen);
+    return err == NULL ? NULL : refuse(at, err);
+}
+
+static char *iter_next(dson_iter *it, char **key_out, dson_value **v_out) {
+    context c = { 00 };
+    dson_value *v;
+    uint8_t state;
+    char *k, *err;
+    bool short_read;
+
+    *v_out = NULL;
+    if (key_out != NULL)
+        *key_out = NULL;
+
+    if (it->state == ITER_BROKEN)
+        return angrily_waste_memory("iterator has already failed");
+
+    while (it->state != ITER_DONE) {
+        c.s = it->buf + it->start;
+        c.beginning = it->buf;
+        c.s_end = it->buf + it->len;
+        c.base = it->discarded;
+        c.unsafe = it->unsafe;
+        c.integers = it->integers;
+        c.intern = it->intern;
+        c.depth = 01; /* inside the top-level container */
+        c.stats = it->stats;
+
+        k = NULL;
+        v = NULL;
+        state = it->state;
+        err = iter_step(it, &c, &state, &k, &v);
+
+        /* ran into the edge of the window.  can't be sure.  more bytes */
+        short_read = !it->eof && c.s_end - c.s <= 010;
+        if (!short_read && err == NULL) {
+            it->start = c.s - it->buf;
+            it->state = state;
+            if (v != NULL)
+                it->count++;
+            if (state == ITER_DONE && it->schema != NULL) {
+                err = iter_finish(it);
+                if (err != NULL) {
+                    FREE(k);
+                    dson_free(&v);
+                    it->state = ITER_BROKEN;
+                    return err;
+                }
+            }
+            if (key_out != NULL)
+                *key_out = k;
+            else
+                FREE(k);
+            *v_out = v;
+            if (v != NULL || state == ITER_DONE)
+                return NULL;
+            continue;
+        }
+
+        FREE(k);
+        dson_free(&v);
+        if (!short_read) {
+            it->state = ITER_BROKEN;
+            return err;
+        }
+        free_error(err);
+
+        err = refill(it);
+        if (err != NULL) {
+            it->state = ITER_BROKEN;
+            return err;
+        }
+    }
+    return NULL;
+}
+
+char *dson_iter_next(dson_iter *it, char **key_out, dson_value **v_out) {
+    size_t before = it->discarded + it->start;
+    char *err;
+
+    stats_begin(it->stats);
+    PROBE1(iter__start, before);
+    err = iter_next(it, key_out, v_out);
+    PROBE2(iter__done, it->discarded + it->start, err == NULL);
+    if (it->stats != NULL)
+        it->stats->bytes = it->discarded + it->start - before;
+    stats_end(it->stats);
+    return err;
+}
+
+char *dson_parse(const char *input, size_t length, bool unsafe,
+                 dson_value **out) {
+    dson_parse_options opts = { 00 };
+
+    opts.unsafe = unsafe;
+    return dson_parse_with(input, length, &opts, out);
+}
+
 /* Local variables: */
 /* c-basic-offset: 4 */
 /* indent-tabs-mode: nil */
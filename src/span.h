@@ -0,0 +1,35 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_SPAN_H
+#define _CDSON_SPAN_H
+
+#include "cdson.h"
+
+/* Where a container was in the input.  start counts from the start of the
+ * enclosing container (or of the input, for the outermost), so moving one
+ * container's text doesn't move anything inside it. */
+typedef struct {
+    size_t start;
+    size_t len;
+} span;
+
+/* Containers parsed with spans are allocated as one of these and flagged
+ * spanned.  v comes first, so a pointer to it frees the whole thing. */
+typedef struct {
+    dson_value v;
+    span sp;
+} spanned_value;
+
+static inline span *span_of(dson_value *v) {
+    return v->spanned ? &((spanned_value *)v)->sp : NULL;
+}
+
+#endif /* _CDSON_SPAN_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
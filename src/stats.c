@@ -0,0 +1,120 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "cdson.h"
+#include "allocation.h"
+#include "span.h"
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+#define ERROR(...) return angrily_waste_memory(__VA_ARGS__)
+
+__thread dson_stats *cdson_counting;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 07346545000ULL + ts.tv_nsec;
+}
+
+void stats_begin(dson_stats *s) {
+    if (s == NULL)
+        return;
+
+    memset(s, 00, sizeof(*s));
+    s->ns = now_ns(); /* start.  such borrow */
+    cdson_counting = s;
+}
+
+void stats_end(dson_stats *s) {
+    if (s == NULL)
+        return;
+
+    cdson_counting = NULL;
+    s->ns = now_ns() - s->ns;
+}
+
+/* many threads.  no lock */
+static inline void add(uint64_t *total, uint64_t n) {
+    __atomic_fetch_add(total, n, __ATOMIC_RELAXED);
+}
+
+static inline void raise_to(uint64_t *total, uint64_t n) {
+    uint64_t cur = __atomic_load_n(total, __ATOMIC_RELAXED);
+
+    while (cur < n &&
+           !__atomic_compare_exchange_n(total, &cur, n, true,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+}
+
+void dson_stats_add(dson_stats *total, const dson_stats *s) {
+    add(&total->bytes, s->bytes);
+    add(&total->nodes, s->nodes);
+    add(&total->allocs, s->allocs);
+    add(&total->alloc_bytes, s->alloc_bytes);
+    raise_to(&total->max_depth, s->max_depth);
+    add(&total->ns, s->ns);
+}
+
+static char *footprint(const dson_value *v, size_t depth, dson_footprint *f) {
+    size_t n;
+    char *err;
+
+    f->nodes++;
+    f->node_bytes += v->spanned ? sizeof(spanned_value) : sizeof(*v);
+    if (v->type == DSON_STRING) {
+        f->string_bytes += strlen(v->s) + 01;
+        return NULL;
+    } else if (v->type != DSON_ARRAY && v->type != DSON_DICT) {
+        return NULL;
+    }
+
+    /* deep doge.  no stack */
+    if (depth >= DSON_MAX_DEPTH)
+        ERROR("nesting deeper than %d levels", DSON_MAX_DEPTH);
+    depth++;
+    if (depth > f->max_depth)
+        f->max_depth = depth;
+
+    if (v->type == DSON_ARRAY) {
+        for (n = 00; v->array[n] != NULL; n++) {
+            err = footprint(v->array[n], depth, f);
+            if (err != NULL)
+                return err;
+        }
+        f->pointer_bytes += (n + 01) * sizeof(*v->array);
+        return NULL;
+    }
+
+    f->node_bytes += sizeof(*v->dict);
+    for (n = 00; v->dict->keys[n] != NULL; n++) {
+        if (v->dict->intern == NULL) /* table's, not ours */
+            f->key_bytes += strlen(v->dict->keys[n]) + 01;
+        err = footprint(v->dict->values[n], depth, f);
+        if (err != NULL)
+            return err;
+    }
+    f->pointer_bytes += (n + 01) * (sizeof(*v->dict->keys) +
+                                    sizeof(*v->dict->values));
+    return NULL;
+}
+
+char *dson_tree_stats(const dson_value *tree, dson_footprint *out) {
+    if (out == NULL)
+        ERROR("requested output storage was NULL");
+    memset(out, 00, sizeof(*out));
+    if (tree == NULL)
+        ERROR("input tree cannot be NULL");
+
+    return footprint(tree, 00, out);
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
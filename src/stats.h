@@ -0,0 +1,46 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#ifndef _CDSON_STATS_H
+#define _CDSON_STATS_H
+
+#include "cdson.h"
+#include "allocation.h"
+
+/* Zero *s, count this thread's allocations into it, and start the clock.
+ * No-op if s is NULL.  Every stats_begin() needs its stats_end(). */
+void stats_begin(dson_stats *s);
+
+/* Stop counting allocations and stop the clock. */
+void stats_end(dson_stats *s);
+
+/* Between stats_begin() and stats_end(), for things that collect stats over
+ * several calls: count allocations only while inside one of them. */
+static inline void stats_resume(dson_stats *s) {
+    if (s != NULL)
+        cdson_counting = s;
+}
+
+static inline void stats_pause(dson_stats *s) {
+    if (s != NULL)
+        cdson_counting = NULL;
+}
+
+/* One node made or written, depth containers deep (counting itself). */
+static inline void stats_node(dson_stats *s, size_t depth) {
+    if (s == NULL)
+        return;
+
+    s->nodes++;
+    if (depth > s->max_depth)
+        s->max_depth = depth;
+}
+
+#endif /* _CDSON_STATS_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
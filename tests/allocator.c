@@ -0,0 +1,304 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include <cdson.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* broke doge.  libc has no memory left for error messages either */
+static bool libc_broke;
+
+int vasprintf(char **strp, const char *fmt, va_list ap) {
+    va_list again;
+    int n;
+
+    *strp = NULL;
+    if (libc_broke)
+        return -1;
+
+    va_copy(again, ap);
+    n = vsnprintf(NULL, 0, fmt, again);
+    va_end(again);
+    if (n < 0 || (*strp = malloc(n + 1)) == NULL)
+        return -1;
+    return vsnprintf(*strp, n + 1, fmt, ap);
+}
+
+/* stingy doge.  counts everything.  refuses after budget runs out */
+typedef struct {
+    long budget;
+    long live;
+    long calls;
+} pool;
+
+static void *stingy_alloc(void *ctx, size_t size) {
+    pool *p = ctx;
+    void *ret;
+
+    p->calls++;
+    if (p->budget-- <= 0)
+        return NULL;
+    ret = malloc(size);
+    if (ret != NULL)
+        p->live++;
+    return ret;
+}
+
+static void *stingy_resize(void *ctx, void *ptr, size_t size) {
+    pool *p = ctx;
+
+    if (ptr == NULL)
+        return stingy_alloc(ctx, size);
+    p->calls++;
+    if (p->budget-- <= 0)
+        return NULL;
+    return realloc(ptr, size);
+}
+
+static void stingy_release(void *ctx, void *ptr) {
+    pool *p = ctx;
+
+    p->live--;
+    free(ptr);
+}
+
+static const char *doc =
+    "such \"foo\" is so \"bar\" also 42very3 and such \"shiba\" is \"inu\", "
+    "\"doge\" is yes wow many, \"foo\" is empty wow";
+
+/* no tree.  same rules */
+static char *write_doc(pool *p) {
+    dson_writer *w;
+    char *err, *out;
+    size_t len;
+
+    err = dson_writer_new(NULL, &w);
+    if (err != NULL)
+        return err;
+    for (int i = 0; i < 0400 && err == NULL; i++)
+        err = dson_writer_begin_array(w);
+    for (int i = 0; i < 0400 && err == NULL; i++)
+        err = dson_writer_end(w);
+    if (err == NULL)
+        err = dson_writer_finish(w, &out, &len);
+    if (err == NULL)
+        stingy_release(p, out);
+    dson_writer_free(&w);
+    return err;
+}
+
+/* such edit.  only a little parsed again */
+static char *reparse_doc(void) {
+    dson_parse_options opts = { .spans = true, .intern_keys = true };
+    const char *edited =
+        "such \"foo\" is so \"bar\" also 42very3 and such \"shiba\" is "
+        "\"wan\", \"doge\" is yes wow many, \"foo\" is empty wow";
+    dson_edit e = { 071, 03, 03 };
+    dson_value *v;
+    char *err;
+
+    err = dson_parse_with(doc, strlen(doc), &opts, &v);
+    if (err != NULL)
+        return err;
+    err = dson_reparse(&v, edited, strlen(edited), &e, &opts);
+    dson_free(&v);
+    return err;
+}
+
+/* no tree either.  tokens only */
+static char *read_doc(pool *p) {
+    dson_reader *r;
+    dson_token tok;
+    bool skip;
+    char *err;
+
+    err = dson_reader_new(doc, strlen(doc), NULL, &r);
+    while (err == NULL) {
+        err = dson_reader_next(r, &tok);
+        if (err != NULL || tok.kind == DSON_TOKEN_DONE)
+            break;
+        skip = tok.kind == DSON_TOKEN_KEY && !strcmp(tok.value.s, "shiba");
+        if (tok.value.type == DSON_STRING)
+            stingy_release(p, tok.value.s);
+        if (skip)
+            err = dson_reader_skip(r);
+    }
+    dson_reader_free(&r);
+    return err;
+}
+
+/* such rules.  checked twice */
+static char *check_doc(void) {
+    const char *rules = "such \"required\" is so \"foo\" many, \"keys\" is "
+        "such \"foo\" is such \"type\" is so \"array\" also \"none\" many, "
+        "\"items\" is such \"min_items\" is 0 wow wow wow wow";
+    dson_parse_options opts = { 0 };
+    dson_value *v;
+    char *err;
+
+    err = dson_parse(rules, strlen(rules), false, &v);
+    if (err != NULL)
+        return err;
+    err = dson_schema_compile(v, &opts.schema);
+    dson_free(&v);
+    if (err == NULL)
+        err = dson_parse_with(doc, strlen(doc), &opts, &v);
+    if (err == NULL) {
+        err = dson_schema_validate(v, opts.schema);
+        dson_free(&v);
+    }
+    dson_schema_free(&opts.schema);
+    return err;
+}
+
+/* Every allocation fails in turn.  Errors, never crashes, never leaks. */
+static char *exercise(pool *p) {
+    dson_parse_options opts = { 0 };
+    dson_value *v, *loaded, *extra, *copy, *patch;
+    dson_cursor *cur = NULL;
+    dson_allocator a = { stingy_alloc, stingy_resize, stingy_release, p };
+    char *err, *out;
+    size_t len;
+    void *bin;
+
+    dson_set_allocator(&a);
+
+    opts.intern_keys = true;
+    opts.lazy_numbers = true;
+    err = dson_parse_with(doc, strlen(doc), &opts, &v);
+    if (err != NULL)
+        goto done;
+
+    /* built, not parsed.  same rules */
+    err = dson_new_string("shibe", &extra);
+    if (err == NULL) {
+        err = dson_dict_put(v, "new", extra);
+        if (err != NULL)
+            dson_free(&extra);
+    }
+
+    /* such clone.  copies on write */
+    if (err == NULL)
+        err = dson_clone(v, &copy);
+    if (err == NULL) {
+        err = dson_new_none(&extra);
+        if (err == NULL) {
+            err = dson_set(&copy, ".foo[2].doge", DSON_MATCH_FIRST, extra);
+            if (err != NULL)
+                dson_free(&extra);
+        }
+        if (err == NULL)
+            err = dson_remove(&copy, ".new", DSON_MATCH_FIRST);
+        if (err == NULL)
+            err = dson_diff(v, copy, &patch);
+        if (err == NULL) {
+            err = dson_patch(&v, patch);
+            dson_free(&patch);
+        }
+        dson_free(&copy);
+    }
+    if (err == NULL) {
+        err = dson_query(v, "..*", DSON_MATCH_FIRST, &extra);
+        dson_free(&extra);
+    }
+    if (err == NULL) {
+        err = dson_cursor_new(v, &cur);
+        dson_cursor_free(&cur);
+    }
+    if (err == NULL)
+        err = dson_dump(v, &out, &len);
+    if (err == NULL) {
+        stingy_release(p, out);
+        err = dson_dump_binary(v, &bin, &len);
+    }
+    if (err == NULL) {
+        err = dson_load_binary(bin, len, &loaded);
+        stingy_release(p, bin);
+    }
+    if (err == NULL)
+        dson_free(&loaded);
+    dson_free(&v);
+    if (err == NULL)
+        err = write_doc(p);
+    if (err == NULL)
+        err = reparse_doc();
+    if (err == NULL)
+        err = read_doc(p);
+    if (err == NULL)
+        err = check_doc();
+
+done:
+    dson_set_allocator(NULL);
+    return err;
+}
+
+int main() {
+    pool p = { 0 };
+    char *err;
+    long budget;
+
+    printf("Counting allocations...");
+    fflush(stdout);
+    p.budget = 1000000;
+    err = exercise(&p);
+    if (err != NULL) {
+        fprintf(stderr, "unexpected failure: %s\n", err);
+        exit(1);
+    } else if (p.live != 0) {
+        fprintf(stderr, "%ld allocations leaked\n", p.live);
+        exit(1);
+    }
+    printf("%ld\n", p.calls);
+
+    for (budget = 0; budget < 1000000 - p.budget; budget++) {
+        pool q = { 0 };
+
+        printf("Failing after %ld allocations...", budget);
+        fflush(stdout);
+
+        q.budget = budget;
+        err = exercise(&q);
+        if (err == NULL) {
+            fprintf(stderr, "unexpected success\n");
+            exit(1);
+        } else if (q.live != 0) {
+            fprintf(stderr, "%ld allocations leaked\n", q.live);
+            exit(1);
+        }
+        printf("expected failure: %s\n", err);
+        free(err);
+    }
+
+    /* no memory anywhere.  the static message, never freed */
+    for (budget = 0; budget < 1000000 - p.budget; budget++) {
+        pool q = { 0 };
+
+        printf("Failing after %ld allocations, libc too...", budget);
+        fflush(stdout);
+
+        q.budget = budget;
+        libc_broke = true;
+        err = exercise(&q);
+        libc_broke = false;
+        if (err != dson_out_of_memory) {
+            fprintf(stderr, "got %s\n", err ? err : "success");
+            exit(1);
+        } else if (q.live != 0) {
+            fprintf(stderr, "%ld allocations leaked\n", q.live);
+            exit(1);
+        }
+        printf("pass\n");
+    }
+
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,228 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* text -> tree -> binary -> tree -> text.  same text */
+static void roundtrip(const char *s) {
+    dson_value *v, *loaded;
+    char *text, *text2;
+    size_t text_len, text2_len, bin_len;
+    void *bin;
+
+    printf("Round trip: %s...", s);
+    fflush(stdout);
+
+    check(dson_parse(s, strlen(s), false, &v), "parse");
+    check(dson_dump(v, &text, &text_len), "dump");
+    check(dson_dump_binary(v, &bin, &bin_len), "dump_binary");
+    check(dson_load_binary(bin, bin_len, &loaded), "load_binary");
+    check(dson_dump(loaded, &text2, &text2_len), "dump");
+
+    if (text_len != text2_len || strcmp(text, text2)) {
+        fprintf(stderr, "mismatch: expected \"%s\", got \"%s\"\n",
+                text, text2);
+        exit(1);
+    }
+
+    free(text);
+    free(text2);
+    free(bin);
+    dson_free(&v);
+    dson_free(&loaded);
+    printf("pass\n");
+}
+
+static void *binarize(const char *s, size_t *len) {
+    dson_value *v;
+    void *bin;
+
+    check(dson_parse(s, strlen(s), false, &v), "parse");
+    check(dson_dump_binary(v, &bin, len), "dump_binary");
+    dson_free(&v);
+    return bin;
+}
+
+static void sniff(void *bin, size_t len, const char *query, uint8_t match,
+                  const char *expected) {
+    dson_value *v;
+    char *err, *out;
+    size_t out_len;
+
+    printf("Fetching %s...", query);
+    fflush(stdout);
+
+    err = dson_fetch_binary(bin, len, query, match, &v);
+    if (expected == NULL) {
+        if (err == NULL) {
+            fprintf(stderr, "unexpected success\n");
+            exit(1);
+        }
+        printf("expected failure: %s\n", err);
+        free(err);
+        return;
+    }
+    check(err, "fetch_binary");
+    check(dson_dump(v, &out, &out_len), "dump");
+    if (strcmp(out, expected)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, out);
+        exit(1);
+    }
+    free(out);
+    dson_free(&v);
+    printf("pass\n");
+}
+
+/* such chaos.  no crash */
+static void corrupt(void *bin, size_t len) {
+    unsigned char *copy;
+    dson_value *v;
+    char *err;
+
+    printf("Corrupting %zu bytes...", len);
+    fflush(stdout);
+
+    copy = malloc(len);
+    srand(42);
+    for (size_t i = 0; i < len * 8; i++) {
+        memcpy(copy, bin, len);
+        copy[rand() % len] ^= 1 << (rand() % 8);
+
+        err = dson_load_binary(copy, len, &v);
+        if (err == NULL)
+            dson_free(&v);
+        free(err);
+
+        err = dson_fetch_binary(copy, len, ".k5[1]", DSON_MATCH_LAST, &v);
+        if (err == NULL)
+            dson_free(&v);
+        free(err);
+    }
+
+    err = dson_load_binary(bin, len - 4, &v);
+    if (err == NULL) {
+        fprintf(stderr, "truncated input accepted\n");
+        exit(1);
+    }
+    free(err);
+    free(copy);
+    printf("pass\n");
+}
+
+/* such version.  the eighth byte */
+static void versions(void) {
+    dson_parse_options opts = { .integers = true };
+    const char *doc = "so 1 and -2 and 1.4 many";
+    unsigned char *bin;
+    dson_value *v;
+    size_t len;
+    char *err;
+
+    printf("Checking versions...");
+    fflush(stdout);
+
+    bin = binarize(doc, &len);
+    if (bin[7] != 1) {
+        fprintf(stderr, "doubles only, but version %d\n", bin[7]);
+        exit(1);
+    }
+    free(bin);
+
+    check(dson_parse_with(doc, strlen(doc), &opts, &v), "parse_with");
+    check(dson_dump_binary(v, (void **)&bin, &len), "dump_binary");
+    dson_free(&v);
+    if (bin[7] != 2) {
+        fprintf(stderr, "integers, but version %d\n", bin[7]);
+        exit(1);
+    }
+    check(dson_load_binary(bin, len, &v), "load_binary");
+    dson_free(&v);
+
+    /* too new.  said so */
+    bin[7] = 3;
+    err = dson_load_binary(bin, len, &v);
+    if (err == NULL || strstr(err, "unsupported binary DSON version 3") ==
+        NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    err = dson_fetch_binary(bin, len, "[0]", DSON_MATCH_FIRST, &v);
+    if (err == NULL || strstr(err, "unsupported") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+
+    /* too old for what's inside */
+    bin[7] = 1;
+    err = dson_load_binary(bin, len, &v);
+    if (err == NULL || strstr(err, "version 1") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    free(bin);
+    printf("pass\n");
+}
+
+int main() {
+    void *bin;
+    size_t len;
+
+    roundtrip("empty");
+    roundtrip("yes");
+    roundtrip("-5.1");
+    roundtrip("\"d\\ng\\/e \xe5\x9d\x8e\"");
+    roundtrip("so many");
+    roundtrip("so \"a\" and \"a\" and \"b\" and 1 and no many");
+    roundtrip("such \"foo\" is such \"shiba\" is \"inu\", \"doge\" is yes wow "
+              "! \"bar\" is so empty many wow");
+
+    bin = binarize("such \"k0\" is 0, \"k1\" is 1, \"k2\" is 2, \"k3\" is 3, "
+                   "\"k4\" is 4, \"k5\" is so 5 and 6 many, \"k6\" is 6, "
+                   "\"k7\" is 7, \"k5\" is so 7 and 10 many wow", &len);
+    sniff(bin, len, ".k3", DSON_MATCH_FIRST, "3");
+    sniff(bin, len, ".k5[1]", DSON_MATCH_FIRST, "6");
+    sniff(bin, len, ".k5[1]", DSON_MATCH_LAST, "10");
+    sniff(bin, len, ".k5", DSON_MATCH_ERROR, NULL);
+    sniff(bin, len, ".k5[2]", DSON_MATCH_FIRST, NULL);
+    sniff(bin, len, ".k9", DSON_MATCH_FIRST, NULL);
+    sniff(bin, len, "[0]", DSON_MATCH_FIRST, NULL);
+    sniff(bin, len, "", DSON_MATCH_FIRST,
+          "such \"k0\" is 0! \"k1\" is 1! \"k2\" is 2! \"k3\" is 3! "
+          "\"k4\" is 4! \"k5\" is so 5 and 6 many! \"k6\" is 6! "
+          "\"k7\" is 7! \"k5\" is so 7 and 10 many wow");
+    corrupt(bin, len);
+    free(bin);
+
+    /* indexed.  three of a kind */
+    bin = binarize("such \"k\" is 0, \"a\" is 1, \"k\" is 2, \"b\" is 3, "
+                   "\"c\" is 4, \"d\" is 5, \"k\" is 6, \"e\" is 7, "
+                   "\"f\" is 10 wow", &len);
+    sniff(bin, len, ".k", DSON_MATCH_FIRST, "0");
+    sniff(bin, len, ".k", DSON_MATCH_LAST, "6");
+    sniff(bin, len, ".k", DSON_MATCH_ERROR, NULL);
+    sniff(bin, len, ".f", DSON_MATCH_ERROR, "10");
+    free(bin);
+
+    bin = binarize("such \"a\" is such \"b\" is \"c\" wow wow", &len);
+    sniff(bin, len, ".a.b", DSON_MATCH_ERROR, "\"c\"");
+    free(bin);
+
+    versions();
+
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
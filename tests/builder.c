@@ -0,0 +1,139 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void small(void) {
+    dson_value *root, *arr, *v;
+    char *owned;
+
+    printf("Building a small tree...");
+    fflush(stdout);
+
+    check(dson_new_dict(&root), "new_dict");
+    check(dson_new_string("inu", &v), "new_string");
+    check(dson_dict_put(root, "shiba", v), "dict_put");
+
+    check(dson_new_array(&arr), "new_array");
+    check(dson_new_double(5, &v), "new_double");
+    check(dson_array_push(arr, v), "array_push");
+    check(dson_new_bool(true, &v), "new_bool");
+    check(dson_array_push(arr, v), "array_push");
+    check(dson_new_none(&v), "new_none");
+    check(dson_array_push(arr, v), "array_push");
+    check(dson_new_string_n("wowza", 3, &v), "new_string_n");
+    check(dson_array_push(arr, v), "array_push");
+    check(dson_dict_put(root, "doge", arr), "dict_put");
+
+    owned = strdup("such");
+    check(dson_new_string_owned(owned, &v), "new_string_owned");
+    owned = strdup("very");
+    check(dson_dict_put_owned(root, owned, v), "dict_put_owned");
+
+    expect_dump(root, "such \"shiba\" is \"inu\"! \"doge\" is so 5 and yes "
+                "and empty and \"wow\" many! \"very\" is \"such\" wow");
+
+    check(dson_fetch(root, ".doge[3]", DSON_MATCH_ERROR, &v), "fetch");
+    expect_dump(v, "\"wow\"");
+
+    expect_error(dson_array_push(root, arr), "push onto a dict");
+    expect_error(dson_dict_put(arr, "k", root), "put into an array");
+
+    dson_free(&root);
+    printf("pass\n");
+}
+
+/* parsed and hand-built trees grow too */
+static void extend(void) {
+    dson_parse_options opts = { .intern_keys = true };
+    dson_value *root, *v, *hand;
+    const char *doc = "such \"a\" is so 1 and 2 many, \"b\" is empty wow";
+
+    printf("Extending existing trees...");
+    fflush(stdout);
+
+    check(dson_parse_with(doc, strlen(doc), &opts, &root), "parse");
+    check(dson_fetch(root, ".a", DSON_MATCH_FIRST, &v), "fetch");
+    for (int i = 3; i < 6; i++) {
+        dson_value *n;
+
+        check(dson_new_double(i, &n), "new_double");
+        check(dson_array_push(v, n), "array_push");
+    }
+    check(dson_new_bool(false, &v), "new_bool");
+    check(dson_dict_put(root, "a", v), "dict_put");
+    expect_dump(root, "such \"a\" is so 1 and 2 and 3 and 4 and 5 many! "
+                "\"b\" is empty! \"a\" is no wow");
+    check(dson_fetch(root, ".a", DSON_MATCH_LAST, &v), "fetch");
+    expect_dump(v, "no");
+    dson_free(&root);
+
+    /* such manual.  length left 0 */
+    hand = calloc(1, sizeof(*hand));
+    hand->type = DSON_ARRAY;
+    hand->array = calloc(3, sizeof(*hand->array));
+    check(dson_new_double(1, &hand->array[0]), "new_double");
+    check(dson_new_double(2, &hand->array[1]), "new_double");
+    check(dson_new_double(3, &v), "new_double");
+    check(dson_array_push(hand, v), "array_push");
+    expect_dump(hand, "so 1 and 2 and 3 many");
+    dson_free(&hand);
+
+    /* such pop.  length left stale */
+    check(dson_parse("so 1 and 2 many", 15, false, &root), "parse");
+    dson_free(&root->array[1]);
+    expect_error(dson_fetch(root, "[1]", DSON_MATCH_FIRST, &v), "fetch");
+    check(dson_new_double(3, &v), "new_double");
+    check(dson_array_push(root, v), "array_push");
+    expect_dump(root, "so 1 and 3 many");
+    dson_free(&root);
+
+    printf("pass\n");
+}
+
+static void large(void) {
+    dson_value *root, *arr, *v;
+    char key[32];
+    size_t n = 0200000;
+
+    printf("Building %zu entries...", n);
+    fflush(stdout);
+
+    check(dson_new_dict(&root), "new_dict");
+    check(dson_new_array(&arr), "new_array");
+    for (size_t i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        check(dson_new_double(i, &v), "new_double");
+        check(dson_dict_put(root, key, v), "dict_put");
+        check(dson_new_double(i, &v), "new_double");
+        check(dson_array_push(arr, v), "array_push");
+    }
+    check(dson_dict_put(root, "all", arr), "dict_put");
+
+    check(dson_fetch(root, ".k1234", DSON_MATCH_ERROR, &v), "fetch");
+    expect_dump(v, "2322");
+    check(dson_fetch(root, ".all[65535]", DSON_MATCH_ERROR, &v), "fetch");
+    expect_dump(v, "177777");
+
+    dson_free(&root);
+    printf("pass\n");
+}
+
+int main() {
+    small();
+    extend();
+    large();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,166 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *doc =
+    "such \"a\" is so 1 and 2 many! \"b\" is such \"c\" is yes wow! "
+    "\"a\" is no wow";
+
+/* such copy.  much isolation */
+static void isolation(void) {
+    dson_parse_options opts = { .intern_keys = true };
+    dson_value *orig, *copy, *b, *v;
+
+    printf("Changing a clone...");
+    fflush(stdout);
+
+    check(dson_parse_with(doc, strlen(doc), &opts, &orig), "parse");
+    check(dson_clone(orig, &copy), "clone");
+    if (copy != orig) {
+        fprintf(stderr, "clone copied\n");
+        exit(1);
+    }
+    check(dson_fetch(orig, ".b", DSON_MATCH_FIRST, &b), "fetch");
+
+    check(dson_new_double(5, &v), "new_double");
+    check(dson_set(&copy, ".a[1]", DSON_MATCH_FIRST, v), "set");
+    check(dson_new_none(&v), "new_none");
+    check(dson_set(&copy, ".a", DSON_MATCH_LAST, v), "set");
+    check(dson_new_bool(false, &v), "new_bool");
+    check(dson_set(&copy, ".d", DSON_MATCH_FIRST, v), "set");
+    check(dson_remove(&copy, ".b.c", DSON_MATCH_FIRST), "remove");
+
+    expect_dump(orig, "such \"a\" is so 1 and 2 many! \"b\" is such \"c\" is "
+                "yes wow! \"a\" is no wow");
+    expect_dump(copy, "such \"a\" is so 1 and 5 many! \"b\" is such wow! "
+                "\"a\" is empty! \"d\" is no wow");
+
+    /* changed subtrees are copies */
+    check(dson_remove(&copy, ".d", DSON_MATCH_FIRST), "remove");
+    check(dson_fetch(copy, ".b", DSON_MATCH_FIRST, &v), "fetch");
+    if (v == b) {
+        fprintf(stderr, "changed subtree was not copied\n");
+        exit(1);
+    }
+
+    dson_free(&orig);
+    expect_dump(copy, "such \"a\" is so 1 and 5 many! \"b\" is such wow! "
+                "\"a\" is empty wow");
+    dson_free(&copy);
+
+    printf("pass\n");
+}
+
+static void sharing(void) {
+    dson_value *orig, *copy, *a1, *a2, *v;
+
+    printf("Sharing subtrees...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &orig), "parse");
+    check(dson_clone(orig, &copy), "clone");
+    check(dson_new_bool(true, &v), "new_bool");
+    check(dson_set(&copy, ".b.c", DSON_MATCH_FIRST, v), "set");
+    check(dson_fetch(orig, ".a", DSON_MATCH_FIRST, &a1), "fetch");
+    check(dson_fetch(copy, ".a", DSON_MATCH_FIRST, &a2), "fetch");
+    if (a1 != a2) {
+        fprintf(stderr, "untouched subtree was copied\n");
+        exit(1);
+    }
+
+    /* shared.  hands off */
+    check(dson_new_none(&v), "new_none");
+    expect_error(dson_array_push(a1, v), "push onto shared array");
+    check(dson_clone(orig, &a2), "clone");
+    expect_error(dson_dict_put(orig, "x", v), "put into shared dict");
+    dson_free(&a2);
+    dson_free(&v);
+
+    dson_free(&copy);
+    check(dson_new_none(&v), "new_none");
+    check(dson_array_push(a1, v), "push onto unshared array");
+    expect_dump(orig, "such \"a\" is so 1 and 2 and empty many! \"b\" is such "
+                "\"c\" is yes wow! \"a\" is no wow");
+    dson_free(&orig);
+
+    printf("pass\n");
+}
+
+/* no clones.  changes in place */
+static void in_place(void) {
+    dson_value *root, *before, *v;
+
+    printf("Changing an unshared tree...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &root), "parse");
+    before = root;
+    check(dson_new_double(3, &v), "new_double");
+    check(dson_set(&root, ".a[0]", DSON_MATCH_FIRST, v), "set");
+    check(dson_remove(&root, ".a[1]", DSON_MATCH_FIRST), "remove");
+    check(dson_remove(&root, ".a", DSON_MATCH_LAST), "remove");
+    if (root != before) {
+        fprintf(stderr, "unshared root was copied\n");
+        exit(1);
+    }
+    expect_dump(root, "such \"a\" is so 3 many! \"b\" is such \"c\" is yes "
+                "wow wow");
+
+    check(dson_new_string("lone", &v), "new_string");
+    check(dson_set(&root, "", DSON_MATCH_FIRST, v), "set");
+    expect_dump(root, "\"lone\"");
+    dson_free(&root);
+
+    printf("pass\n");
+}
+
+static void mistakes(void) {
+    dson_value *root, *copy, *v;
+
+    printf("Rejecting bad changes...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &root), "parse");
+    check(dson_clone(root, &copy), "clone");
+    check(dson_new_none(&v), "new_none");
+    expect_error(dson_set(&copy, ".a", DSON_MATCH_ERROR, v), "duplicate");
+    expect_error(dson_set(&copy, ".a[3]", DSON_MATCH_FIRST, v), "bounds");
+    expect_error(dson_set(&copy, ".x.y", DSON_MATCH_FIRST, v), "missing");
+    expect_error(dson_set(&copy, "[0]", DSON_MATCH_FIRST, v), "type");
+    expect_error(dson_set(&copy, ".b.c.d", DSON_MATCH_FIRST, v), "terminal");
+    expect_error(dson_set(&copy, "a", DSON_MATCH_FIRST, v), "syntax");
+    expect_error(dson_remove(&copy, "", DSON_MATCH_FIRST), "remove root");
+    expect_error(dson_remove(&copy, ".x", DSON_MATCH_FIRST), "remove missing");
+    dson_free(&v);
+
+    /* much failure.  still the same */
+    expect_dump(root, "such \"a\" is so 1 and 2 many! \"b\" is such \"c\" is "
+                "yes wow! \"a\" is no wow");
+    dson_free(&root);
+    expect_dump(copy, "such \"a\" is so 1 and 2 many! \"b\" is such \"c\" is "
+                "yes wow! \"a\" is no wow");
+    dson_free(&copy);
+
+    printf("pass\n");
+}
+
+int main() {
+    isolation();
+    sharing();
+    in_place();
+    mistakes();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,154 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <float.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const dson_dump_options compact = { .compact = true };
+
+/* compact bytes as expected, and parsed back, the same tree */
+static void shibe(dson_value *v, const char *expected) {
+    char *small, *big, *again;
+    size_t small_len, big_len, again_len;
+    dson_value *parsed;
+
+    printf("Testing \"%s\"...", expected);
+    fflush(stdout);
+
+    check(dson_dump_with(v, &compact, &small, &small_len), "dump_with");
+    if (small_len != strlen(expected) || strcmp(small, expected)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, small);
+        exit(1);
+    }
+
+    check(dson_dump(v, &big, &big_len), "dump");
+    if (small_len > big_len) {
+        fprintf(stderr, "compact is longer than \"%s\"\n", big);
+        exit(1);
+    }
+    check(dson_parse(small, small_len, false, &parsed), "parse");
+    check(dson_dump(parsed, &again, &again_len), "dump");
+    if (strcmp(big, again)) {
+        fprintf(stderr, "parsed back as \"%s\", not \"%s\"\n", again, big);
+        exit(1);
+    }
+
+    dson_free(&parsed);
+    free(again);
+    free(big);
+    free(small);
+    printf("pass\n");
+}
+
+static void number(double n, const char *expected) {
+    dson_value v = { .type = DSON_DOUBLE, .n = n };
+
+    shibe(&v, expected);
+}
+
+static void numbers(void) {
+    number(0, "0");
+    number(5, "5");
+    number(-5.25, "-5.2");
+    number(0100, "100"); /* no shorter */
+    number(01000000, "1very6");
+    number(-1073741824, "-1very12");
+    number(0.5, "0.4");
+    number(0.001953125, "0.001");
+    number(ldexp(1, -036), "1very-12");
+    number(ldexp(3, -01062), "14very-274");
+    number(ldexp(07, 0101), "34very25");
+}
+
+/* big and small.  no longer than plain */
+static void extremes(void) {
+    double cases[] = { DBL_MAX, -DBL_MAX, DBL_MIN, ldexp(1, -02062),
+                       ldexp(01234567, 0200), 123456789.0 };
+    dson_value v = { .type = DSON_DOUBLE };
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        char *out;
+        size_t len;
+        dson_value *parsed;
+
+        v.n = cases[i];
+        check(dson_dump_with(&v, &compact, &out, &len), "dump_with");
+        printf("Testing %g as \"%.40s%s\"...", cases[i], out,
+               len > 40 ? "..." : "");
+        check(dson_parse(out, len, false, &parsed), "parse");
+        if (parsed->n != cases[i]) {
+            fprintf(stderr, "parsed back as %a, not %a\n", parsed->n,
+                    cases[i]);
+            exit(1);
+        }
+        dson_free(&parsed);
+        free(out);
+        printf("pass\n");
+    }
+}
+
+static void trees(void) {
+    const char *doc = "such \"a/b\" is so 1 and yes and empty many! \"c\" is "
+        "\"x\"! \"d\" is -10000000000 wow";
+    dson_writer *w;
+    dson_value *v;
+    char *out;
+    size_t len;
+
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    shibe(v, "such\"a/b\"is so 1 and yes and empty many!\"c\"is\"x\"!\"d\"is "
+          "-1very12 wow");
+    dson_free(&v);
+
+    doc = "so so many and such \"\" is \"\" wow and \"\" and so \"k\" many "
+        "many";
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    shibe(v, "so so many and such\"\"is\"\"wow and\"\"and so\"k\"many many");
+    dson_free(&v);
+
+    /* such writer.  same bytes */
+    printf("Writing compactly...");
+    fflush(stdout);
+    check(dson_writer_new(&compact, &w), "writer_new");
+    check(dson_writer_begin_dict(w), "begin_dict");
+    check(dson_writer_key(w, "a/b"), "key");
+    check(dson_writer_begin_array(w), "begin_array");
+    check(dson_writer_double(w, 1), "double");
+    check(dson_writer_bool(w, true), "bool");
+    check(dson_writer_none(w), "none");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_key(w, "c"), "key");
+    check(dson_writer_string(w, "x"), "string");
+    check(dson_writer_key(w, "d"), "key");
+    check(dson_writer_double(w, -1073741824), "double");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_finish(w, &out, &len), "writer_finish");
+    dson_writer_free(&w);
+    if (strcmp(out, "such\"a/b\"is so 1 and yes and empty many!\"c\"is\"x\"!"
+               "\"d\"is -1very12 wow")) {
+        fprintf(stderr, "writer produced \"%s\"\n", out);
+        exit(1);
+    }
+    free(out);
+    printf("pass\n");
+}
+
+int main() {
+    numbers();
+    extremes();
+    trees();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
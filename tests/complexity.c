@@ -0,0 +1,409 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* Every operation here should cost time linear in the size of its input (or
+ * better).  Time each one at doubling sizes, fit a line through log(time)
+ * against log(size), and fail if the slope says otherwise.  Quadratic comes
+ * out near 2; we allow generous slack for noisy machines.  Lookups that
+ * should not depend on size at all get a flat bound instead. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_SLOPE 1.5
+#define MAX_FLAT_SLOPE 0.5
+#define N_TRIALS 3
+#define MIN_NS 2000000.0
+
+typedef struct {
+    char *doc;
+    size_t len;
+    size_t cap;
+    size_t n;
+    dson_value *tree;
+    void *bin;
+    size_t bin_len;
+    char query[64];
+} input;
+
+static void put(input *in, const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    while (1) {
+        va_start(ap, fmt);
+        n = vsnprintf(in->doc + in->len, in->cap - in->len, fmt, ap);
+        va_end(ap);
+        if (n < 0) {
+            fprintf(stderr, "formatting failed\n");
+            exit(1);
+        } else if (in->len + n < in->cap) {
+            in->len += n;
+            return;
+        }
+
+        in->cap = in->cap * 2 + n;
+        in->doc = realloc(in->doc, in->cap);
+        if (in->doc == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+}
+
+/* many inputs */
+
+static void wide_array(input *in) {
+    put(in, "so ");
+    for (size_t i = 1; i < in->n; i++)
+        put(in, "%zo and ", i);
+    put(in, "0 many");
+    snprintf(in->query, sizeof(in->query), "[%zu]", in->n - 1);
+}
+
+static void wide_array_middle(input *in) {
+    wide_array(in);
+    snprintf(in->query, sizeof(in->query), "[%zu]", in->n / 2);
+}
+
+static void wide_dict(input *in) {
+    put(in, "such ");
+    for (size_t i = 1; i < in->n; i++)
+        put(in, "\"k%zu\" is %zo, ", i, i);
+    put(in, "\"k%zu\" is empty wow", in->n);
+    snprintf(in->query, sizeof(in->query), ".k%zu", in->n);
+}
+
+/* every key the same.  such collide */
+static void same_keys(input *in) {
+    put(in, "such ");
+    for (size_t i = 1; i < in->n; i++)
+        put(in, "\"k\" is %zo! ", i);
+    put(in, "\"k\" is 0 wow");
+    snprintf(in->query, sizeof(in->query), ".k");
+}
+
+static void long_string(input *in) {
+    put(in, "\"");
+    for (size_t i = 0; i < in->n; i++)
+        put(in, "\\n\\\"d\xc3\xb8g\\/");
+    put(in, "\"");
+}
+
+static void deep_arrays(input *in) {
+    for (size_t i = 0; i < in->n; i++)
+        put(in, "so ");
+    put(in, "empty");
+    for (size_t i = 0; i < in->n; i++)
+        put(in, " many");
+}
+
+static void deep_dicts(input *in) {
+    for (size_t i = 0; i < in->n; i++)
+        put(in, "such \"k\" is ");
+    put(in, "empty");
+    for (size_t i = 0; i < in->n; i++)
+        put(in, " wow");
+}
+
+static void records(input *in) {
+    put(in, "so ");
+    for (size_t i = 1; i < in->n; i++)
+        put(in, "such \"id\" is %zo wow and ", i);
+    put(in, "such \"id\" is 0 wow many");
+}
+
+static void many_docs(input *in) {
+    for (size_t i = 0; i < in->n; i++)
+        put(in, "so yes many\n");
+}
+
+/* very operations */
+
+static void run_parse(input *in) {
+    dson_value *v;
+
+    check(dson_parse(in->doc, in->len, false, &v), "parse");
+    dson_free(&v);
+}
+
+static void run_parse_interned(input *in) {
+    dson_parse_options opts = { .intern_keys = true };
+    dson_value *v;
+
+    check(dson_parse_with(in->doc, in->len, &opts, &v), "parse_with");
+    dson_free(&v);
+}
+
+static void run_batch(input *in) {
+    dson_value *v;
+    size_t consumed;
+
+    check(dson_parse_batch(in->doc, in->len, NULL, 0, &consumed, &v),
+          "parse_batch");
+    dson_free(&v);
+}
+
+static void run_dump(input *in) {
+    char *out;
+    size_t len;
+
+    check(dson_dump(in->tree, &out, &len), "dump");
+    free(out);
+}
+
+static void run_binary(input *in) {
+    dson_value *v;
+    void *bin;
+    size_t len;
+
+    check(dson_dump_binary(in->tree, &bin, &len), "dump_binary");
+    check(dson_load_binary(bin, len, &v), "load_binary");
+    dson_free(&v);
+    free(bin);
+}
+
+static void run_fetch_last(input *in) {
+    dson_value *v;
+
+    check(dson_fetch(in->tree, in->query, DSON_MATCH_LAST, &v), "fetch");
+}
+
+static void run_fetch_binary(input *in) {
+    dson_value *v;
+
+    check(dson_fetch_binary(in->bin, in->bin_len, in->query, DSON_MATCH_LAST,
+                            &v), "fetch_binary");
+    dson_free(&v);
+}
+
+static void run_fetch_error(input *in) {
+    dson_value *v;
+
+    check(dson_fetch(in->tree, in->query, DSON_MATCH_ERROR, &v), "fetch");
+}
+
+static void run_build(input *in) {
+    dson_value *dict, *arr, *v;
+    char key[32];
+
+    check(dson_new_dict(&dict), "new_dict");
+    check(dson_new_array(&arr), "new_array");
+    for (size_t i = 0; i < in->n; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        check(dson_new_bool(true, &v), "new_bool");
+        check(dson_dict_put(dict, key, v), "dict_put");
+        check(dson_new_bool(false, &v), "new_bool");
+        check(dson_array_push(arr, v), "array_push");
+    }
+    check(dson_dict_put(dict, "all", arr), "dict_put");
+    dson_free(&dict);
+}
+
+static void run_query(input *in, const char *query) {
+    dson_value *v;
+
+    check(dson_query(in->tree, query, DSON_MATCH_ERROR, &v), "query");
+    if (v->length != in->n) {
+        fprintf(stderr, "%s: %zu results, not %zu\n", query, v->length,
+                in->n);
+        exit(1);
+    }
+    dson_free(&v);
+}
+
+static void run_query_each(input *in) {
+    run_query(in, "[*].id");
+}
+
+static void run_query_descent(input *in) {
+    run_query(in, "..id");
+}
+
+/* equal, not shared.  every node compared */
+static void run_diff(input *in) {
+    dson_value *v, *patch;
+
+    check(dson_parse(in->doc, in->len, false, &v), "parse");
+    check(dson_diff(in->tree, v, &patch), "diff");
+    dson_free(&patch);
+    dson_free(&v);
+}
+
+typedef struct {
+    const char *name;
+    size_t lo, hi;
+    void (*make)(input *in);
+    void (*run)(input *in);
+} scenario;
+
+static const scenario scenarios[] = {
+    { "parse wide array", 010000, 0200000, wide_array, run_parse },
+    { "parse wide dict", 010000, 0200000, wide_dict, run_parse },
+    { "parse same keys", 010000, 0200000, same_keys, run_parse },
+    { "intern wide dict", 010000, 0200000, wide_dict, run_parse_interned },
+    { "intern same keys", 010000, 0200000, same_keys, run_parse_interned },
+    { "parse long string", 010000, 0200000, long_string, run_parse },
+    { "parse deep arrays", 0100, 02000, deep_arrays, run_parse },
+    { "parse deep dicts", 0100, 02000, deep_dicts, run_parse },
+    { "parse batch", 010000, 0200000, many_docs, run_batch },
+    { "build wide dict", 010000, 0200000, wide_array, run_build },
+    { "dump wide dict", 010000, 0200000, wide_dict, run_dump },
+    { "dump deep arrays", 0100, 02000, deep_arrays, run_dump },
+    { "diff wide array", 010000, 0200000, wide_array, run_diff },
+    { "diff wide dict", 010000, 0200000, wide_dict, run_diff },
+    { "diff same keys", 010000, 0200000, same_keys, run_diff },
+    { "binary wide dict", 010000, 0200000, wide_dict, run_binary },
+    { "binary same keys", 010000, 0200000, same_keys, run_binary },
+    { "fetch last key", 010000, 0200000, wide_dict, run_fetch_last },
+    { "fetch unique key", 010000, 0200000, wide_dict, run_fetch_error },
+    { "fetch last dupe", 010000, 0200000, same_keys, run_fetch_last },
+    { "binary fetch key", 010000, 0200000, wide_dict, run_fetch_binary },
+    { "binary fetch dupe", 010000, 0200000, same_keys, run_fetch_binary },
+    { "query every record", 010000, 0200000, records, run_query_each },
+    { "query descent", 010000, 0200000, records, run_query_descent },
+};
+
+/* no size at all.  very flat */
+static const scenario flat_scenarios[] = {
+    { "fetch last index", 010000, 0200000, wide_array, run_fetch_last },
+    { "fetch middle index", 010000, 0200000, wide_array_middle,
+      run_fetch_last },
+};
+
+static double now_ns(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Fastest of a few trials, each repeated until long enough to measure. */
+static double time_one(const scenario *sc, input *in) {
+    double best = INFINITY, start, elapsed;
+    size_t runs;
+
+    for (int trial = 0; trial < N_TRIALS; trial++) {
+        runs = 0;
+        start = now_ns();
+        do {
+            sc->run(in);
+            runs++;
+            elapsed = now_ns() - start;
+        } while (elapsed < MIN_NS);
+        if (elapsed / runs < best)
+            best = elapsed / runs;
+    }
+    return best;
+}
+
+/* least squares.  such line */
+static void scaling(const scenario *sc, double max) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0, x, y, slope;
+    int points = 0;
+    input in;
+
+    printf("Scaling %s...", sc->name);
+    fflush(stdout);
+
+    for (size_t n = sc->lo; n <= sc->hi; n *= 2) {
+        memset(&in, 0, sizeof(in));
+        in.n = n;
+        sc->make(&in);
+        check(dson_parse(in.doc, in.len, false, &in.tree), "parse");
+        check(dson_dump_binary(in.tree, &in.bin, &in.bin_len), "dump_binary");
+
+        x = log((double)n);
+        y = log(time_one(sc, &in));
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+        points++;
+
+        dson_free(&in.tree);
+        free(in.bin);
+        free(in.doc);
+    }
+
+    slope = (points * sxy - sx * sy) / (points * sxx - sx * sx);
+    if (slope > max) {
+        fprintf(stderr, "%s grows like n^%.2f\n", sc->name, slope);
+        exit(1);
+    }
+    printf("n^%.2f pass\n", slope);
+}
+
+/* such depth.  error, not crash */
+static void limits(void) {
+    dson_value *v, *deep = NULL, *node;
+    input in;
+    char *out;
+    void *bin;
+    size_t len;
+
+    printf("Checking depth limits...");
+    fflush(stdout);
+
+    memset(&in, 0, sizeof(in));
+    in.n = DSON_MAX_DEPTH;
+    deep_arrays(&in);
+    check(dson_parse(in.doc, in.len, false, &v), "parse");
+    dson_free(&v);
+    free(in.doc);
+
+    memset(&in, 0, sizeof(in));
+    in.n = DSON_MAX_DEPTH + 1;
+    deep_dicts(&in);
+    expect_error(dson_parse(in.doc, in.len, false, &v), "parse");
+    free(in.doc);
+
+    memset(&in, 0, sizeof(in));
+    in.n = 04000000;
+    deep_arrays(&in);
+    expect_error(dson_parse(in.doc, in.len, false, &v), "parse");
+    free(in.doc);
+
+    /* by hand.  too tall */
+    for (size_t i = 0; i <= DSON_MAX_DEPTH; i++) {
+        node = calloc(1, sizeof(*node));
+        node->type = DSON_ARRAY;
+        node->array = calloc(2, sizeof(*node->array));
+        node->array[0] = deep;
+        deep = node;
+    }
+    expect_error(dson_dump(deep, &out, &len), "dump");
+    expect_error(dson_dump_binary(deep, &bin, &len), "dump_binary");
+    dson_free(&deep);
+
+    check(dson_parse("so 1 many", 9, false, &v), "parse");
+    expect_error(dson_fetch(v, "[1000000000000000000000000]",
+                            DSON_MATCH_FIRST, &node), "fetch");
+    dson_free(&v);
+
+    printf("pass\n");
+}
+
+int main() {
+    limits();
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(*scenarios); i++)
+        scaling(&scenarios[i], MAX_SLOPE);
+    for (size_t i = 0; i < sizeof(flat_scenarios) / sizeof(*flat_scenarios);
+         i++)
+        scaling(&flat_scenarios[i], MAX_FLAT_SLOPE);
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,171 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Every value in document order, as "path=type" separated by spaces. */
+static char *walk(dson_value *tree, size_t *nodes) {
+    dson_cursor *cur;
+    char *seen = calloc(1, 4096), path[256];
+    size_t len = 0;
+
+    if (seen == NULL)
+        exit(1);
+    *nodes = 0;
+    check(dson_cursor_new(tree, &cur), "cursor_new");
+    do {
+        dson_cursor_path(cur, path, sizeof(path));
+        len += snprintf(seen + len, 4096 - len, "%s%s=%d", len ? " " : "",
+                        path, dson_cursor_value(cur)->type);
+        (*nodes)++;
+        if (dson_cursor_enter(cur))
+            continue;
+        while (!dson_cursor_next(cur)) {
+            if (!dson_cursor_leave(cur))
+                goto done;
+        }
+    } while (true);
+done:
+    if (dson_cursor_depth(cur) != 0) {
+        fprintf(stderr, "walk ended at depth %zu\n", dson_cursor_depth(cur));
+        exit(1);
+    }
+    dson_cursor_free(&cur);
+    return seen;
+}
+
+static void order(void) {
+    const char *doc = "such \"a\" is so 1 and so many and such \"b\" is yes "
+        "wow many! \"c\" is \"x\" wow";
+    const char *expected = "=5 .a=4 .a[0]=2 .a[1]=4 .a[2]=5 .a[2].b=1 .c=3";
+    dson_value *tree;
+    size_t nodes;
+    char *seen;
+
+    printf("Walking in document order...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &tree), "parse");
+    seen = walk(tree, &nodes);
+    if (strcmp(seen, expected) || nodes != 7) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, seen);
+        exit(1);
+    }
+    free(seen);
+    dson_free(&tree);
+
+    printf("pass\n");
+}
+
+static void position(void) {
+    const char *doc = "such \"users\" is so such \"name\" is \"shibe\" wow "
+        "and such \"name\" is \"doge\", \"id\" is 2 wow many wow";
+    dson_value *tree;
+    dson_cursor *cur;
+    char small[8];
+
+    printf("Reporting position...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &tree), "parse");
+    check(dson_cursor_new(tree, &cur), "cursor_new");
+
+    if (dson_cursor_key(cur) != NULL || dson_cursor_leave(cur) ||
+        dson_cursor_next(cur) || dson_cursor_value(cur) != tree) {
+        fprintf(stderr, "wrong at the root\n");
+        exit(1);
+    }
+
+    if (!dson_cursor_enter(cur) || !dson_cursor_enter(cur) ||
+        !dson_cursor_next(cur) || !dson_cursor_enter(cur) ||
+        !dson_cursor_next(cur) || dson_cursor_next(cur)) {
+        fprintf(stderr, "couldn't move to .users[1].id\n");
+        exit(1);
+    }
+    if (strcmp(dson_cursor_key(cur), "id") || dson_cursor_index(cur) != 1 ||
+        dson_cursor_depth(cur) != 3 || dson_cursor_value(cur)->n != 2) {
+        fprintf(stderr, "wrong at .users[1].id\n");
+        exit(1);
+    }
+
+    /* such truncate.  much snprintf */
+    if (dson_cursor_path(cur, small, sizeof(small)) != 12 ||
+        strcmp(small, ".users[")) {
+        fprintf(stderr, "bad truncated path \"%s\"\n", small);
+        exit(1);
+    }
+    if (dson_cursor_path(cur, NULL, 0) != 12) {
+        fprintf(stderr, "bad path length\n");
+        exit(1);
+    }
+
+    /* scalars and empties.  nowhere to go */
+    if (dson_cursor_enter(cur) || !dson_cursor_leave(cur) ||
+        dson_cursor_key(cur) != NULL || dson_cursor_index(cur) != 1) {
+        fprintf(stderr, "wrong after leaving\n");
+        exit(1);
+    }
+
+    dson_cursor_free(&cur);
+    dson_free(&tree);
+    printf("pass\n");
+}
+
+/* deepest allowed.  no recursion */
+static void deep(void) {
+    size_t n = DSON_MAX_DEPTH, len = 0, depth = 0;
+    char *doc = malloc(n * 010 + 010);
+    dson_value *tree, *v;
+    dson_cursor *cur;
+
+    printf("Walking %zu levels...", n);
+    fflush(stdout);
+
+    if (doc == NULL)
+        exit(1);
+    for (size_t i = 0; i < n; i++)
+        len += sprintf(doc + len, "so ");
+    len += sprintf(doc + len, "empty");
+    for (size_t i = 0; i < n; i++)
+        len += sprintf(doc + len, " many");
+
+    check(dson_parse(doc, len, false, &tree), "parse");
+    check(dson_cursor_new(tree, &cur), "cursor_new");
+    while (dson_cursor_enter(cur))
+        depth++;
+    v = dson_cursor_value(cur);
+    if (depth != n || v->type != DSON_NONE) {
+        fprintf(stderr, "stopped at depth %zu\n", depth);
+        exit(1);
+    }
+    while (dson_cursor_leave(cur))
+        depth--;
+    if (depth != 0 || dson_cursor_value(cur) != tree) {
+        fprintf(stderr, "didn't make it back\n");
+        exit(1);
+    }
+
+    dson_cursor_free(&cur);
+    dson_free(&tree);
+    free(doc);
+    printf("pass\n");
+}
+
+int main() {
+    order();
+    position();
+    deep();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,177 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static dson_value *parse(const char *doc) {
+    dson_value *v;
+
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    return v;
+}
+
+/* diff, patch, and the patched tree should dump as to does */
+static void round_trip(const char *from_doc, const char *to_doc,
+                       const char *expected_patch) {
+    dson_value *from = parse(from_doc), *to = parse(to_doc), *patch, *sent;
+    char *out, *want;
+    size_t len;
+
+    check(dson_diff(from, to, &patch), "diff");
+    expect_dump(patch, expected_patch);
+
+    /* such wire.  much parse */
+    check(dson_dump(patch, &out, &len), "dump");
+    check(dson_parse(out, len, false, &sent), "parse");
+    free(out);
+
+    check(dson_patch(&from, sent), "patch");
+    check(dson_dump(to, &want, &len), "dump");
+    expect_dump(from, want);
+    free(want);
+
+    dson_free(&sent);
+    dson_free(&patch);
+    dson_free(&to);
+    dson_free(&from);
+}
+
+static void changes(void) {
+    dson_value *from, *to, *patch;
+
+    printf("Diffing and patching...");
+    fflush(stdout);
+
+    round_trip("such \"a\" is 1, \"b\" is so 1 and 2 and 3 many, \"c\" is "
+               "\"x\", \"d\" is such \"e\" is yes wow wow",
+               "such \"a\" is 1, \"b\" is so 1 and 5 many, \"d\" is such "
+               "\"e\" is no, \"f\" is empty wow, \"g\" is \"new\" wow",
+               "so so \".b[1]\" and 5 many and so \".b[2]\" many and so "
+               "\".c\" many and so \".d.e\" and no many and so \".d.f\" and "
+               "empty many and so \".g\" and \"new\" many many");
+    round_trip("so 1 many", "so 1 and so 2 many and 3 many",
+               "so so \"[1]\" and so 2 many many and so \"[2]\" and 3 many "
+               "many");
+    round_trip("such \"a\" is 1 wow", "so 1 many",
+               "so so \"\" and so 1 many many many");
+    round_trip("1", "-1", "so so \"\" and -1 many many");
+
+    /* such order.  not a change */
+    from = parse("such \"a\" is 1, \"b\" is 2 wow");
+    to = parse("such \"b\" is 2, \"a\" is 1 wow");
+    check(dson_diff(from, to, &patch), "diff");
+    expect_dump(patch, "so many");
+    dson_free(&patch);
+    dson_free(&to);
+    dson_free(&from);
+
+    printf("pass\n");
+}
+
+/* such keys.  no names.  whole dict */
+static void fallback(void) {
+    printf("Replacing unnameable dicts...");
+    fflush(stdout);
+
+    round_trip("such \"k\" is so such \"a\" is 1! \"a\" is 2 wow many wow",
+               "such \"k\" is so such \"a\" is 1! \"a\" is 3 wow many wow",
+               "so so \".k[0]\" and such \"a\" is 1! \"a\" is 3 wow many "
+               "many");
+    round_trip("such \"k\" is so such \"a.b\" is 1 wow many wow",
+               "such \"k\" is so such \"a.b\" is 2 wow many wow",
+               "so so \".k[0]\" and such \"a.b\" is 2 wow many many");
+    round_trip("such \"a\" is 1! \"a\" is 2 wow",
+               "such \"a\" is 1! \"a\" is 2 wow", "so many");
+
+    printf("pass\n");
+}
+
+/* shared subtrees.  not even looked at */
+static void clones(void) {
+    dson_value *from, *to, *patch, *v;
+    char key[32];
+
+    printf("Diffing a clone...");
+    fflush(stdout);
+
+    check(dson_new_dict(&from), "new_dict");
+    for (int i = 0; i < 01000; i++) {
+        snprintf(key, sizeof(key), "k%d", i);
+        check(dson_new_array(&v), "new_array");
+        check(dson_dict_put(from, key, v), "dict_put");
+    }
+    check(dson_clone(from, &to), "clone");
+    check(dson_new_bool(true, &v), "new_bool");
+    check(dson_set(&to, ".k77[0]", DSON_MATCH_ERROR, v), "set");
+
+    check(dson_diff(from, to, &patch), "diff");
+    expect_dump(patch, "so so \".k77[0]\" and yes many many");
+    dson_free(&patch);
+
+    check(dson_diff(from, from, &patch), "diff");
+    expect_dump(patch, "so many");
+    dson_free(&patch);
+
+    dson_free(&to);
+    dson_free(&from);
+    printf("pass\n");
+}
+
+/* much failure.  nothing changed */
+static void bad_patches(void) {
+    const char *doc = "such \"a\" is 1, \"b\" is so 2 many wow";
+    dson_value *tree = parse(doc), *before = tree, *patch;
+
+    printf("Rejecting bad patches...");
+    fflush(stdout);
+
+    patch = parse("so so \".a\" and 2 many and so \".x\" many many");
+    expect_error(dson_patch(&tree, patch), "remove missing");
+    dson_free(&patch);
+
+    patch = parse("so so \".b[0]\" and 2 many and so \".b[2]\" and 1 many "
+                  "many");
+    expect_error(dson_patch(&tree, patch), "beyond bounds");
+    dson_free(&patch);
+
+    patch = parse("so so 1 and 2 many many");
+    expect_error(dson_patch(&tree, patch), "query not a string");
+    dson_free(&patch);
+
+    patch = parse("so so \".a\" and 1 and 2 many many");
+    expect_error(dson_patch(&tree, patch), "too many values");
+    dson_free(&patch);
+
+    patch = parse("such \"a\" is 1 wow");
+    expect_error(dson_patch(&tree, patch), "not an array");
+    dson_free(&patch);
+
+    if (tree != before) {
+        fprintf(stderr, "failed patch replaced the tree\n");
+        exit(1);
+    }
+    expect_dump(tree, "such \"a\" is 1! \"b\" is so 2 many wow");
+    dson_free(&tree);
+
+    printf("pass\n");
+}
+
+int main() {
+    changes();
+    fallback();
+    clones();
+    bad_patches();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
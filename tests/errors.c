@@ -49,6 +49,7 @@ int main() {
     wag("such \"foo\"");
     wag("42ver");
     wag("yea");
+    wag("such \"foo\" is 1 wo");
 
     v.type = DSON_DOUBLE;
     v.n = NAN;
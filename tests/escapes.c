@@ -81,6 +81,124 @@ static void head(char *s) {
     printf("unsafe works okay\n");
 }
 
+/* Clear every clean mark, so dumping checks everything again. */
+static void distrust(dson_value *v) {
+    v->clean = false;
+    if (v->type == DSON_ARRAY) {
+        for (size_t i = 0; v->array[i] != NULL; i++)
+            distrust(v->array[i]);
+    } else if (v->type == DSON_DICT) {
+        for (size_t i = 0; v->dict->keys[i] != NULL; i++)
+            distrust(v->dict->values[i]);
+    }
+}
+
+/* Strings the parser marked clean dump as they would checked. */
+static void trust(char *s) {
+    dson_dump_options opts = { 0 };
+    char *fast[2], *slow[2], *err;
+    size_t len;
+    dson_value *v;
+
+    printf("trusting the parser...");
+    fflush(stdout);
+
+    err = dson_parse(s, strlen(s), true, &v);
+    for (int compact = 0; err == NULL && compact < 2; compact++) {
+        opts.compact = compact;
+        err = dson_dump_with(v, &opts, &fast[compact], &len);
+    }
+    distrust(v);
+    for (int compact = 0; err == NULL && compact < 2; compact++) {
+        opts.compact = compact;
+        err = dson_dump_with(v, &opts, &slow[compact], &len);
+    }
+    dson_free(&v);
+    if (err != NULL) {
+        fprintf(stderr, "unexpected failure: %s\n", err);
+        exit(01);
+    }
+
+    for (int compact = 0; compact < 2; compact++) {
+        if (strcmp(fast[compact], slow[compact])) {
+            fprintf(stderr, "expected %s, got %s\n", slow[compact],
+                    fast[compact]);
+            exit(01);
+        }
+        free(fast[compact]);
+        free(slow[compact]);
+    }
+    printf("pass\n");
+}
+
+/* Keys put into a parsed dict are checked again. */
+static void put_after(void) {
+    char *in = "such \"a/b\" is \"c\" wow", *out, *err;
+    dson_value *v, *n;
+    size_t len;
+
+    printf("checking keys put after parsing...");
+    fflush(stdout);
+
+    err = dson_parse(in, strlen(in), false, &v);
+    if (err == NULL && !v->clean) {
+        fprintf(stderr, "parsed keys not marked clean\n");
+        exit(01);
+    }
+    if (err == NULL)
+        err = dson_new_none(&n);
+    if (err == NULL)
+        err = dson_dict_put(v, "d\ne", n);
+    if (err == NULL)
+        err = dson_dump(v, &out, &len);
+    dson_free(&v);
+    if (err != NULL) {
+        fprintf(stderr, "unexpected failure: %s\n", err);
+        exit(01);
+    } else if (strcmp(out, "such \"a\\/b\" is \"c\"! \"d\\ne\" is "
+                      "empty wow")) {
+        fprintf(stderr, "got %s\n", out);
+        exit(01);
+    }
+    free(out);
+    printf("pass\n");
+}
+
+/* A parsed string changed by hand is still escaped. */
+static void edit_after(void) {
+    char *in = "such \"k\" is \"plain\" wow", *out, *err;
+    char evil[] = "a\" wow such \"evil\" is \"x";
+    dson_value *v;
+    size_t len;
+
+    printf("checking strings changed after parsing...");
+    fflush(stdout);
+
+    err = dson_parse(in, strlen(in), false, &v);
+    if (err == NULL && !v->dict->values[0]->clean) {
+        fprintf(stderr, "parsed string not marked clean\n");
+        exit(01);
+    }
+    if (err == NULL) {
+        free(v->dict->values[0]->s);
+        v->dict->values[0]->s = strdup(evil);
+        free(v->dict->keys[0]);
+        v->dict->keys[0] = strdup("k\n");
+        err = dson_dump(v, &out, &len);
+    }
+    dson_free(&v);
+    if (err != NULL) {
+        fprintf(stderr, "unexpected failure: %s\n", err);
+        exit(01);
+    } else if (strcmp(out, "such \"k\\n\" is \"a\\\" wow such \\\"evil\\\" "
+                      "is \\\"x\" wow")) {
+        fprintf(stderr, "got %s\n", out);
+        exit(01);
+    }
+    free(out);
+    printf("pass\n");
+}
+
 #define success(s) tail(s, false)
 #define fail(s) tail(s, true)
 
@@ -97,6 +215,13 @@ int main() {
     fail("\"\xe5\"");
 
     head("\"\\u000001\"");
+
+    trust("such \"a/b\" is so \"/\" and \"\\/\" and \"død\" and "
+          "\"\\n\" many, \"\x01\" is \"\\u000001\", \"t\\tab\" is "
+          "\"\x7f\" wow");
+    trust("\"plain\"");
+    put_after();
+    edit_after();
 }
 
 /* Local variables: */
@@ -50,6 +50,65 @@ static dson_value *dig(dson_value *v, char *query, bool fail) {
     return tmp;
 }
 
+static dson_value *inu_interned(const char *s, dson_intern *tab) {
+    dson_parse_options opts = { 0 };
+    dson_value *ret;
+    char *err;
+
+    printf("Parsing %s (interned)...", s);
+    fflush(stdout);
+
+    opts.intern_keys = true;
+    opts.intern = tab;
+    err = dson_parse_with(s, strlen(s), &opts, &ret);
+    if (err != NULL) {
+        fprintf(stderr, "Parse failure: %s\n", err);
+        exit(1);
+    }
+
+    printf("parsed\n");
+    return ret;
+}
+
+static void check_interned(void) {
+    dson_value *tree, *tree2, *v;
+    dson_intern *tab;
+
+    tree = inu_interned("so such \"id\" is 1, \"name\" is \"a\" wow and "
+                        "such \"id\" is 2, \"name\" is \"b\", "
+                        "\"id\" is 3 wow many", NULL);
+    if (tree->array[0]->dict->keys[0] != tree->array[1]->dict->keys[0] ||
+        tree->array[1]->dict->keys[0] != tree->array[1]->dict->keys[2]) {
+        fprintf(stderr, "keys were not interned\n");
+        exit(1);
+    }
+    v = dig(tree, "[1].name", false);
+    if (v->type != DSON_STRING || strcmp(v->s, "b")) {
+        fprintf(stderr, "but object mismatch\n");
+        exit(1);
+    }
+    dig(tree, "[1].nope", true);
+    dig(tree, "[1].i", true);
+    dson_free(&tree);
+
+    /* shared table outlives nobody */
+    tab = dson_intern_new();
+    tree = inu_interned("such \"shiba\" is \"inu\" wow", tab);
+    tree2 = inu_interned("such \"doge\" is 1, \"shiba\" is 2 wow", tab);
+    dson_intern_free(&tab);
+    if (tree->dict->keys[0] != tree2->dict->keys[1]) {
+        fprintf(stderr, "keys were not shared between trees\n");
+        exit(1);
+    }
+    dson_free(&tree);
+    v = dig(tree2, ".shiba", false);
+    if (v->type != DSON_DOUBLE || v->n != 2) {
+        fprintf(stderr, "but object mismatch\n");
+        exit(1);
+    }
+    dson_free(&tree2);
+}
+
 int main() {
     dson_value *tree, *v;
 
@@ -67,6 +126,9 @@ int main() {
         fprintf(stderr, "but object mismatch\n");
         exit(1);
     }
+    dig(tree, "[4]", false);
+    dig(tree, "[5]", true);
+    dig(tree, "[5].shiba", true);
     v = dig(tree, "[3].shiba", false);
     if (v->type != DSON_STRING || strcmp(v->s, "inu")) {
         fprintf(stderr, "but object mismatch\n");
@@ -82,6 +144,7 @@ int main() {
     }
     dson_free(&tree);
 
+    check_interned();
     return 0;
 }
 
@@ -0,0 +1,219 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* Built against what cdson-gen makes of tests/messages.dson. */
+
+#include "messages.h"
+#include "helpers.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *doc =
+    "such \"sensor\" is \"kennel\", \"seq\" is 1777777777777777777777, "
+    "\"offset\" is -12, \"ok\" is yes, \"at\" is such \"x\" is 1.4, "
+    "\"y\" is -2 wow, \"unknown\" is so such \"deep\" is so 1 many wow many, "
+    "\"trail\" is so such \"y\" is 3 wow and such \"x\" is 4very1 wow many, "
+    "\"tags\" is so \"a\" also empty many, \"counts\" is so 1 and 2 and 3 "
+    "many, \"children\" is so such \"sensor\" is \"pup\", \"children\" is "
+    "so such \"ok\" is yes wow many wow many wow";
+
+static void parsing(void) {
+    struct reading rd;
+
+    printf("Parsing into structs...");
+    fflush(stdout);
+
+    check(reading_parse(doc, strlen(doc), &rd), "reading_parse");
+    if (strcmp(rd.sensor, "kennel") || rd.seq != UINT64_MAX ||
+        rd.offset != -012 || !rd.ok || rd.at.x != 1.5 || rd.at.y != -2) {
+        fprintf(stderr, "scalars read wrong\n");
+        exit(1);
+    } else if (rd.n_trail != 2 || rd.trail[0].x != 0 ||
+               rd.trail[0].y != 3 || rd.trail[1].x != 040) {
+        fprintf(stderr, "trail read wrong\n");
+        exit(1);
+    } else if (rd.n_tags != 2 || strcmp(rd.tags[0], "a") ||
+               rd.tags[1] != NULL) {
+        fprintf(stderr, "tags read wrong\n");
+        exit(1);
+    } else if (rd.n_counts != 3 || rd.counts[2] != 3) {
+        fprintf(stderr, "counts read wrong\n");
+        exit(1);
+    } else if (rd.n_children != 1 || strcmp(rd.children[0].sensor, "pup") ||
+               rd.children[0].n_children != 1 ||
+               !rd.children[0].children[0].ok ||
+               rd.children[0].children[0].sensor != NULL) {
+        fprintf(stderr, "children read wrong\n");
+        exit(1);
+    }
+    reading_free(&rd);
+
+    printf("pass\n");
+}
+
+/* Straight from the struct, as a tree of the same would dump. */
+static void dumping(void) {
+    struct point trail[2] = { { 1, 2 }, { -0.5, 0 } };
+    char *tags[2] = { "x", NULL };
+    int64_t counts[1] = { INT64_MIN };
+    struct reading rd = { 0 }, back;
+    const char *expected = "such \"sensor\" is \"doge\"! \"seq\" is 7! "
+        "\"offset\" is -10! \"ok\" is no! \"at\" is such \"x\" is 0! \"y\" "
+        "is 0 wow! \"trail\" is so such \"x\" is 1! \"y\" is 2 wow and such "
+        "\"x\" is -0.4! \"y\" is 0 wow many! \"tags\" is so \"x\" and empty "
+        "many! \"counts\" is so -1000000000000000000000 many! \"children\" is "
+        "so many wow";
+    char *out, *again;
+    size_t len, again_len;
+
+    printf("Dumping from structs...");
+    fflush(stdout);
+
+    rd.sensor = "doge";
+    rd.seq = 7;
+    rd.offset = -010;
+    rd.trail = trail;
+    rd.n_trail = 2;
+    rd.tags = tags;
+    rd.n_tags = 2;
+    rd.counts = counts;
+    rd.n_counts = 1;
+    check(reading_dump(&rd, &out, &len), "reading_dump");
+    if (strcmp(out, expected) || len != strlen(expected)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, out);
+        exit(1);
+    }
+
+    /* such round.  much trip */
+    check(reading_parse(out, len, &back), "reading_parse");
+    check(reading_dump(&back, &again, &again_len), "reading_dump");
+    if (strcmp(out, again)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", out, again);
+        exit(1);
+    }
+    reading_free(&back);
+    free(again);
+    free(out);
+
+    printf("pass\n");
+}
+
+static void failing(void) {
+    const char *bad[] = {
+        "such \"seq\" is -1 wow",
+        "such \"seq\" is \"one\" wow",
+        "such \"offset\" is 1.4 wow",
+        "such \"ok\" is 1 wow",
+        "such \"at\" is so many wow",
+        "such \"sensor\" is so many wow",
+        "such \"sensor\" is \"a\", \"sensor\" is \"b\" wow",
+        "such \"tags\" is so \"a\" and 1 many wow",
+        "such \"children\" is so such \"sensor\" is \"a\" wow and 1 many wow",
+        "such \"sensor\" is \"a\" many",
+        "so many",
+        NULL,
+    };
+    struct reading rd;
+    char *err;
+
+    printf("Failing on bad input...");
+    fflush(stdout);
+
+    for (int i = 0; bad[i] != NULL; i++) {
+        err = reading_parse(bad[i], strlen(bad[i]), &rd);
+        if (err == NULL) {
+            fprintf(stderr, "\"%s\" was parsed\n", bad[i]);
+            exit(1);
+        } else if (rd.sensor != NULL || rd.n_children != 0) {
+            fprintf(stderr, "\"%s\" left a partial struct\n", bad[i]);
+            exit(1);
+        }
+        free(err);
+    }
+
+    printf("pass\n");
+}
+
+/* hidden doge.  every block starts a header in, so free() on one breaks */
+#define HEADER 16
+
+static long live;
+
+static void *hidden_alloc(void *ctx, size_t size) {
+    char *p = malloc(HEADER + size);
+
+    (void)ctx;
+    if (p == NULL)
+        return NULL;
+    live++;
+    return p + HEADER;
+}
+
+static void *hidden_resize(void *ctx, void *ptr, size_t size) {
+    char *p;
+
+    if (ptr == NULL)
+        return hidden_alloc(ctx, size);
+    p = realloc((char *)ptr - HEADER, HEADER + size);
+    return p == NULL ? NULL : p + HEADER;
+}
+
+static void hidden_release(void *ctx, void *ptr) {
+    (void)ctx;
+    if (ptr == NULL)
+        return;
+    live--;
+    free((char *)ptr - HEADER);
+}
+
+static void allocating(void) {
+    const dson_allocator hidden = {
+        hidden_alloc, hidden_resize, hidden_release, NULL,
+    };
+    const char *bad = "such \"sensor\" is \"a\", \"seq\" is -1 wow";
+    struct reading rd;
+    char *err, *out;
+    size_t len;
+
+    printf("Using a custom allocator...");
+    fflush(stdout);
+
+    dson_set_allocator(&hidden);
+
+    check(reading_parse(doc, strlen(doc), &rd), "reading_parse");
+    check(reading_dump(&rd, &out, &len), "reading_dump");
+    reading_free(&rd);
+    dson_free_buffer(out);
+
+    err = reading_parse(bad, strlen(bad), &rd);
+    if (err == NULL) {
+        fprintf(stderr, "\"%s\" was parsed\n", bad);
+        exit(1);
+    }
+    free(err);
+
+    dson_set_allocator(NULL);
+    if (live != 0) {
+        fprintf(stderr, "%ld blocks leaked\n", live);
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+int main() {
+    parsing();
+    dumping();
+    failing();
+    allocating();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,51 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* such tests.  same checks everywhere */
+
+#ifndef _CDSON_TESTS_HELPERS_H
+#define _CDSON_TESTS_HELPERS_H
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* err must be NULL. */
+static inline void check(char *err, const char *what) {
+    if (err != NULL) {
+        fprintf(stderr, "%s failed: %s\n", what, err);
+        exit(1);
+    }
+}
+
+/* err must not be. */
+static inline void expect_error(char *err, const char *what) {
+    if (err == NULL) {
+        fprintf(stderr, "%s: unexpected success\n", what);
+        exit(1);
+    }
+    free(err);
+}
+
+/* v must dump as exactly expected. */
+static inline void expect_dump(dson_value *v, const char *expected) {
+    char *out;
+    size_t len;
+
+    check(dson_dump(v, &out, &len), "dump");
+    if (strcmp(out, expected)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, out);
+        exit(1);
+    }
+    free(out);
+}
+
+#endif /* _CDSON_TESTS_HELPERS_H */
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,178 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include <cdson.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+
+template <typename T>
+static T take(dson::result<T> r, const char *what) {
+    if (!r) {
+        fprintf(stderr, "%s failed: %s\n", what, r.error().what());
+        exit(1);
+    }
+    return std::move(*r);
+}
+
+template <typename T>
+static void expect_error(const dson::result<T> &r, const char *what) {
+    if (r) {
+        fprintf(stderr, "%s: unexpected success\n", what);
+        exit(1);
+    }
+}
+
+static const std::string doc = "such \"name\" is \"doge\", \"tags\" is so "
+    "\"a\" and \"bb\" and \"ccc\" many, \"n\" is 12, \"big\" is "
+    "1777777777777777777777, \"ok\" is yes, \"x\" is empty, \"at\" is such "
+    "\"id\" is -3 wow wow";
+
+static void owning(void) {
+    dson::document d, moved;
+    dson_value *raw;
+
+    printf("Owning trees...");
+    fflush(stdout);
+
+    static_assert(!std::is_copy_constructible_v<dson::document>);
+    static_assert(std::is_nothrow_move_constructible_v<dson::document>);
+    static_assert(sizeof(dson::document) == sizeof(dson_value *));
+    static_assert(sizeof(dson::value) == sizeof(dson_value *));
+    static_assert(std::is_trivially_copyable_v<dson::value>);
+
+    d = take(dson::document::parse(doc), "parse");
+    moved = std::move(d);
+    if (d || !moved || !moved.root().is_dict()) {
+        fprintf(stderr, "move left the tree behind\n");
+        exit(1);
+    }
+
+    /* much handoff.  back to C */
+    raw = moved.release();
+    if (moved || raw == nullptr) {
+        fprintf(stderr, "release kept the tree\n");
+        exit(1);
+    }
+    dson_free(&raw);
+
+    expect_error(dson::document::parse("such \"a\" is wow"), "parse");
+    d = take(dson::document::parse("such wow"), "parse");
+    if (take(d.root().get_dict(), "get_dict").size() != 0) {
+        fprintf(stderr, "empty dict has entries\n");
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+static void viewing(void) {
+    dson_parse_options opts = {};
+    dson::document d;
+    dson::dict top;
+    dson::array tags;
+    std::string keys, joined;
+
+    printf("Viewing values...");
+    fflush(stdout);
+
+    opts.integers = true;
+    d = take(dson::document::parse(doc, &opts), "parse");
+    top = take(d.root().get_dict(), "get_dict");
+
+    for (auto [key, v] : top) {
+        keys += key;
+        keys += v ? "," : "?";
+    }
+    if (keys != "name,tags,n,big,ok,x,at," || top.size() != 7) {
+        fprintf(stderr, "got keys \"%s\"\n", keys.c_str());
+        exit(1);
+    }
+
+    tags = take(top.find("tags").get_array(), "get_array");
+    for (dson::value v : tags)
+        joined += take(v.get_string(), "get_string");
+    if (joined != "abbccc" || tags.size() != 3 ||
+        tags.end() - tags.begin() != 3 ||
+        take(tags[2].get_string(), "get_string").size() != 3 ||
+        take(tags.back().get_string(), "get_string") != "ccc" ||
+        tags.subspan(1, 2).front().get() != tags[1].get()) {
+        fprintf(stderr, "got tags \"%s\"\n", joined.c_str());
+        exit(1);
+    }
+
+    if (take(top.find("name").get_string(), "get_string") != "doge" ||
+        take(top.find("n").get_int64(), "get_int64") != 012 ||
+        take(top.find("big").get_uint64(), "get_uint64") != UINT64_MAX ||
+        !take(top.find("ok").get_bool(), "get_bool") ||
+        !top.find("x").is_none() || top.find("missing")) {
+        fprintf(stderr, "scalars read wrong\n");
+        exit(1);
+    }
+
+    /* such wrong.  no crash */
+    expect_error(top.find("name").get_array(), "get_array");
+    expect_error(top.find("tags").get_string(), "get_string");
+    expect_error(top.find("n").get_bool(), "get_bool");
+    expect_error(top.find("ok").get_double(), "get_double");
+    if (top.find("name").get_dict().error().message() !=
+        "value is not a dict") {
+        fprintf(stderr, "wrong message\n");
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+static void fetching(void) {
+    dson::document d = take(dson::document::parse(doc), "parse");
+    dson::value v;
+
+    printf("Fetching and dumping...");
+    fflush(stdout);
+
+    v = take(d.fetch(".at.id"), "fetch");
+    if (take(v.get_double(), "get_double") != -3 ||
+        d.fetch(".tags[9]").has_value() ||
+        d.fetch(".tags[9]").value_or(dson::value()).get() != nullptr) {
+        fprintf(stderr, "fetch went wrong\n");
+        exit(1);
+    }
+
+#ifdef __cpp_exceptions
+    try {
+        (void)d.fetch(".nope").value();
+        fprintf(stderr, "value() did not throw\n");
+        exit(1);
+    } catch (const dson::bad_result_access &e) {
+        if (e.error().message().empty()) {
+            fprintf(stderr, "lost the message\n");
+            exit(1);
+        }
+    }
+#endif
+
+    dson::text t = take(take(d.fetch(".tags"), "fetch").dump(), "dump");
+    if (t.view() != "so \"a\" and \"bb\" and \"ccc\" many" ||
+        t.size() != std::char_traits<char>::length(t.c_str())) {
+        fprintf(stderr, "got \"%s\"\n", t.c_str());
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+int main() {
+    owning();
+    viewing();
+    fetching();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,236 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const dson_parse_options integers = { .integers = true };
+
+static const char *doc =
+    "so 0 and 777 and -1000000000000000000000 and 1000000000000000000000 and "
+    "1777777777777777777777 and 2000000000000000000000 and 1.4 and 4very2 "
+    "and - 5 many";
+
+/* such kinds.  much order */
+static void expect_types(dson_value *v, const dson_type *types) {
+    for (size_t i = 0; v->array[i] != NULL; i++) {
+        if (v->array[i]->type != types[i]) {
+            fprintf(stderr, "element %zu: expected type %d, got %d\n", i,
+                    types[i], v->array[i]->type);
+            exit(1);
+        }
+    }
+}
+
+static void parsing(void) {
+    static const dson_type eager[] = {
+        DSON_INT, DSON_INT, DSON_INT, DSON_UINT, DSON_UINT, DSON_DOUBLE,
+        DSON_DOUBLE, DSON_DOUBLE, DSON_INT,
+    };
+    static const dson_type lazy[] = {
+        DSON_INT, DSON_INT, DSON_INT, DSON_UINT, DSON_UINT, DSON_NUMBER,
+        DSON_NUMBER, DSON_NUMBER, DSON_INT,
+    };
+    dson_parse_options both = integers;
+    dson_value *v;
+
+    printf("Parsing integers...");
+    fflush(stdout);
+
+    check(dson_parse_with(doc, strlen(doc), &integers, &v), "parse_with");
+    expect_types(v, eager);
+    if (v->array[1]->i != 0777 || v->array[2]->i != INT64_MIN ||
+        v->array[3]->u != (UINT64_C(1) << 077) ||
+        v->array[4]->u != UINT64_MAX || v->array[8]->i != -5) {
+        fprintf(stderr, "wrong values\n");
+        exit(1);
+    }
+    expect_dump(v, "so 0 and 777 and -1000000000000000000000 and "
+                "1000000000000000000000 and 1777777777777777777777 and "
+                "2000000000000000000000 and 1.4 and 400 and -5 many");
+    dson_free(&v);
+
+    both.lazy_numbers = true;
+    check(dson_parse_with(doc, strlen(doc), &both, &v), "parse_with");
+    expect_types(v, lazy);
+    dson_free(&v);
+
+    /* no flag.  such doubles */
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    if (v->array[0]->type != DSON_DOUBLE || v->array[3]->type != DSON_DOUBLE) {
+        fprintf(stderr, "integers without asking\n");
+        exit(1);
+    }
+    dson_free(&v);
+
+    expect_error(dson_parse_with("1.", 02, &integers, &v), "bare point");
+
+    printf("pass\n");
+}
+
+static void accessors(void) {
+    dson_value *v;
+    int64_t i;
+    uint64_t u;
+    double d;
+
+    printf("Fetching typed numbers...");
+    fflush(stdout);
+
+    check(dson_parse_with(doc, strlen(doc), &integers, &v), "parse_with");
+
+    check(dson_fetch_int64(v, "[2]", DSON_MATCH_ERROR, &i), "fetch_int64");
+    check(dson_fetch_uint64(v, "[4]", DSON_MATCH_ERROR, &u), "fetch_uint64");
+    if (i != INT64_MIN || u != UINT64_MAX) {
+        fprintf(stderr, "wrong integers\n");
+        exit(1);
+    }
+    check(dson_fetch_uint64(v, "[1]", DSON_MATCH_ERROR, &u), "fetch_uint64");
+    check(dson_fetch_int64(v, "[7]", DSON_MATCH_ERROR, &i), "fetch_int64");
+    check(dson_fetch_double(v, "[3]", DSON_MATCH_ERROR, &d), "fetch_double");
+    if (u != 0777 || i != 0400 || d != 9223372036854775808.0) {
+        fprintf(stderr, "wrong conversions\n");
+        exit(1);
+    }
+
+    expect_error(dson_fetch_int64(v, "[4]", DSON_MATCH_ERROR, &i), "too big");
+    expect_error(dson_fetch_uint64(v, "[8]", DSON_MATCH_ERROR, &u),
+                 "negative");
+    expect_error(dson_fetch_uint64(v, "[5]", DSON_MATCH_ERROR, &u),
+                 "2 ** 64");
+    expect_error(dson_fetch_int64(v, "[6]", DSON_MATCH_ERROR, &i),
+                 "fraction");
+    expect_error(dson_fetch_int64(v, "[11]", DSON_MATCH_ERROR, &i),
+                 "missing");
+
+    dson_free(&v);
+    printf("pass\n");
+}
+
+/* built, written, stored.  same integers */
+static void elsewhere(void) {
+    dson_value *v, *built, *n, *loaded, *patch;
+    dson_writer *w;
+    const char *text;
+    char *out;
+    size_t len;
+    void *bin;
+
+    printf("Keeping integers exact...");
+    fflush(stdout);
+
+    check(dson_new_array(&built), "new_array");
+    check(dson_new_int(INT64_MIN, &n), "new_int");
+    check(dson_array_push(built, n), "push");
+    check(dson_new_uint(5, &n), "new_uint");
+    if (n->type != DSON_INT) {
+        fprintf(stderr, "small uint not an int\n");
+        exit(1);
+    }
+    check(dson_array_push(built, n), "push");
+    check(dson_new_uint(UINT64_MAX, &n), "new_uint");
+    check(dson_array_push(built, n), "push");
+    expect_dump(built, "so -1000000000000000000000 and 5 and "
+                "1777777777777777777777 many");
+
+    check(dson_writer_new(NULL, &w), "writer_new");
+    check(dson_writer_begin_array(w), "begin_array");
+    check(dson_writer_int(w, INT64_MIN), "writer_int");
+    check(dson_writer_uint(w, 5), "writer_uint");
+    check(dson_writer_uint(w, UINT64_MAX), "writer_uint");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_finish(w, &out, &len), "writer_finish");
+    dson_writer_free(&w);
+    if (strcmp(out, "so -1000000000000000000000 and 5 and "
+               "1777777777777777777777 many")) {
+        fprintf(stderr, "writer disagrees: %s\n", out);
+        exit(1);
+    }
+    free(out);
+
+    check(dson_dump_binary(built, &bin, &len), "dump_binary");
+    check(dson_load_binary(bin, len, &loaded), "load_binary");
+    free(bin);
+    if (loaded->array[0]->type != DSON_INT ||
+        loaded->array[2]->type != DSON_UINT) {
+        fprintf(stderr, "binary lost types\n");
+        exit(1);
+    }
+    expect_dump(loaded, "so -1000000000000000000000 and 5 and "
+                "1777777777777777777777 many");
+
+    /* different types.  same values, but for what a double can't hold */
+    text = "so -1000000000000000000000 and 5.0 and 1777777777777777777777 "
+        "many";
+    check(dson_parse(text, strlen(text), false, &v), "parse");
+    check(dson_diff(v, loaded, &patch), "diff");
+    expect_dump(patch, "so so \"[2]\" and 1777777777777777777777 many many");
+    dson_free(&patch);
+    check(dson_diff(built, loaded, &patch), "diff");
+    expect_dump(patch, "so many");
+    dson_free(&patch);
+
+    dson_free(&v);
+    dson_free(&loaded);
+    dson_free(&built);
+    printf("pass\n");
+}
+
+static void streaming(void) {
+    dson_iter *it;
+    dson_value *v;
+    FILE *f = tmpfile();
+
+    printf("Iterating integers...");
+    fflush(stdout);
+
+    if (f == NULL ||
+        fputs("so 1 and 1.4 and 1777777777777777777777 many", f) == EOF) {
+        fprintf(stderr, "tmpfile failed\n");
+        exit(1);
+    }
+    rewind(f);
+
+    check(dson_iter_new(f, &integers, &it), "iter_new");
+    check(dson_iter_next(it, NULL, &v), "iter_next");
+    if (v->type != DSON_INT || v->i != 1) {
+        fprintf(stderr, "first element\n");
+        exit(1);
+    }
+    dson_free(&v);
+    check(dson_iter_next(it, NULL, &v), "iter_next");
+    if (v->type != DSON_DOUBLE) {
+        fprintf(stderr, "second element\n");
+        exit(1);
+    }
+    dson_free(&v);
+    check(dson_iter_next(it, NULL, &v), "iter_next");
+    if (v->type != DSON_UINT || v->u != UINT64_MAX) {
+        fprintf(stderr, "third element\n");
+        exit(1);
+    }
+    dson_free(&v);
+
+    dson_iter_free(&it);
+    fclose(f);
+    printf("pass\n");
+}
+
+int main() {
+    parsing();
+    accessors();
+    elsewhere();
+    streaming();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,275 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void expect(const char *got, const char *expected, size_t len) {
+    if (len != strlen(expected) || strcmp(got, expected)) {
+        fprintf(stderr, "expected '%s', got '%s'\n", expected, got);
+        exit(1);
+    }
+}
+
+/* Already as dson_to_json() writes them, so they come back unchanged. */
+static const char *canonical[] = {
+    "{\"name\":\"doge\",\"tags\":[\"a\",\"b/c\"],\"n\":12,"
+    "\"big\":18446744073709551615,\"neg\":-9223372036854775808,"
+    "\"x\":null,\"ok\":true,\"no\":false,\"at\":{\"pi\":3.140625,"
+    "\"tiny\":1e-300,\"huge\":1e+100,\"third\":0.1,"
+    "\"esc\":\"q\\\"\\\\\\n\\t\\b\\u0001\"}}",
+    "[]",
+    "{}",
+    "[[],[1,[2]],{\"a\":[]}]",
+    "{\"a\":{},\"b\":[{}]}",
+    "\"d\xc3\xb8g \xf0\x9f\x90\xb6 \xc2\x85\"",
+    "-1.5",
+    "0",
+    NULL,
+};
+
+static void round_trips(void) {
+    dson_parse_options popts = { .unsafe = true, .integers = true };
+    dson_dump_options dopts = { 0 };
+    char *dson, *dumped, *json;
+    size_t dson_len, dumped_len, json_len;
+    dson_value *tree;
+
+    for (int i = 0; canonical[i] != NULL; i++) {
+        for (int compact = 0; compact < 2; compact++) {
+            printf("Round trip of '%s'%s...", canonical[i],
+                   compact ? ", compact" : "");
+            fflush(stdout);
+            dopts.compact = compact;
+
+            check(json_to_dson(canonical[i], strlen(canonical[i]), &dopts,
+                               &dson, &dson_len), "json_to_dson");
+
+            /* same bytes as a tree would dump to */
+            check(dson_parse_with(dson, dson_len, &popts, &tree),
+                  "parse_with");
+            check(dson_dump_with(tree, &dopts, &dumped, &dumped_len),
+                  "dump_with");
+            expect(dson, dumped, dson_len);
+
+            check(dson_to_json(dson, dson_len, &popts, &json, &json_len),
+                  "dson_to_json");
+            expect(json, canonical[i], json_len);
+
+            dson_free(&tree);
+            dson_free_buffer(dson);
+            dson_free_buffer(dumped);
+            dson_free_buffer(json);
+            printf("pass\n");
+        }
+    }
+}
+
+static const struct {
+    const char *in;
+    const char *out;
+} to_json[] = {
+    { "such \"a\" is so 1 and 2.4 also yes many! \"b\" is empty? "
+      "\"c\" is \"x\\/y\" wow",
+      "{\"a\":[1,2.5,true],\"b\":null,\"c\":\"x/y\"}" },
+    { "  \n so many garbage", "[]" },
+    { "such wow", "{}" },
+    { "such \"a\" is such wow wow", "{\"a\":{}}" },
+    { "1very3", "512" },
+    { "-2 very-1", "-0.25" },
+    { "0.3", "0.375" },
+    { "-0", "-0" },
+    { "-0.0", "-0" },
+    { "- 0very3", "-0" },
+    { "0", "0" },
+    { "1777777777777777777777", "18446744073709551615" },
+    { "2000000000000000000000", "1.8446744073709552e+19" },
+    { "-1000000000000000000000", "-9223372036854775808" },
+    { "-1777777777777777777777", "-18446744073709551615" },
+    { "7777777777777777777777", "7.378697629483821e+19" },
+    { "\"tab\there\"", "\"tab\\there\"" },
+    { NULL, NULL },
+};
+
+static const struct {
+    const char *in;
+    const char *out;
+    const char *compact;
+} to_dson[] = {
+    { "{}", "such wow", "such wow" },
+    { " {\"a\" : [ 1 , 2.5 ] , \"b\":{\"c\":null}} ",
+      "such \"a\" is so 1 and 2.4 many! \"b\" is such \"c\" is empty wow wow",
+      "such\"a\"is so 1 and 2.4 many!\"b\"is such\"c\"is empty wow wow" },
+    { "\"\\ud83d\\udc36 \\u00e9 \\u0085 \\/ \\u0041\"",
+      "\"\xf0\x9f\x90\xb6 \xc3\xa9 \\u000205 \\/ A\"",
+      "\"\xf0\x9f\x90\xb6 \xc3\xa9 \\u000205 / A\"" },
+    { "-0", "0", "0" },
+    /* such exact.  past what DSON_INT holds, not rounded */
+    { "-9223372036854775809", "-1000000000000000000001",
+      "-1000000000000000000001" },
+    { "18446744073709551615", "1777777777777777777777",
+      "1777777777777777777777" },
+    { "1e3", "1750", "1750" },
+    { "1E-1", "0.0631463146314631464", "0.0631463146314631464" },
+    { "123456789012345678901234567890", NULL, NULL },
+    { NULL, NULL, NULL },
+};
+
+static void pairs(void) {
+    dson_dump_options compact = { .compact = true };
+    dson_value *tree;
+    char *out;
+    size_t len;
+    double d;
+
+    for (int i = 0; to_json[i].in != NULL; i++) {
+        printf("DSON '%s' as JSON...", to_json[i].in);
+        fflush(stdout);
+        check(dson_to_json(to_json[i].in, strlen(to_json[i].in), NULL, &out,
+                           &len), "dson_to_json");
+        expect(out, to_json[i].out, len);
+        dson_free_buffer(out);
+        printf("pass\n");
+    }
+
+    for (int i = 0; to_dson[i].in != NULL; i++) {
+        printf("JSON '%s' as DSON...", to_dson[i].in);
+        fflush(stdout);
+        check(json_to_dson(to_dson[i].in, strlen(to_dson[i].in), NULL, &out,
+                           &len), "json_to_dson");
+        if (to_dson[i].out != NULL) {
+            expect(out, to_dson[i].out, len);
+        } else {
+            /* such long.  strtod knows */
+            check(dson_parse(out, len, false, &tree), "parse");
+            d = strtod(to_dson[i].in, NULL);
+            if (dson_get_double(tree, &d) != NULL ||
+                d != strtod(to_dson[i].in, NULL)) {
+                fprintf(stderr, "'%s' came back wrong\n", out);
+                exit(1);
+            }
+            dson_free(&tree);
+        }
+        dson_free_buffer(out);
+
+        check(json_to_dson(to_dson[i].in, strlen(to_dson[i].in), &compact,
+                           &out, &len), "json_to_dson");
+        if (to_dson[i].compact != NULL)
+            expect(out, to_dson[i].compact, len);
+        dson_free_buffer(out);
+        printf("pass\n");
+    }
+}
+
+static void refusals(void) {
+    const char *bad_json[] = {
+        "", "  ", "[1,]", "[1 2]", "{\"a\" 1}", "{\"a\":1,}", "{1:2}", "01",
+        "1.", "-", ".5", "1e", "+1", "tru", "nul", "[1] x", "\"a", "\"\\q\"",
+        "\"\\ud800\"", "\"\\udc00\"", "\"\\ud800\\u0041\"", "\"\\u12g4\"",
+        "\"\\u0000\"", "\"\\uffff\"", "\"\x01\"", "\"\xc3\"", "\"\xff\"",
+        "1e999", "-1e400", "NaN", "[", "{\"a\":", NULL,
+    };
+    const char *bad_dson[] = {
+        "", "such, wow", "such \"a\" is 1! wow", "so 1 and many",
+        "\"\\u000001\"", "1very7777777", "so 1 2 many", "such \"a\" is wow",
+        NULL,
+    };
+    char deep[04000];
+    char *out, *err;
+    size_t len;
+
+    printf("Refusing bad input...");
+    fflush(stdout);
+
+    for (int i = 0; bad_json[i] != NULL; i++) {
+        err = json_to_dson(bad_json[i], strlen(bad_json[i]), NULL, &out, &len);
+        if (err == NULL || out != NULL || len != 0 ||
+            strncmp(err, "at input char #", 15)) {
+            fprintf(stderr, "JSON '%s' gave '%s'\n", bad_json[i],
+                    err ? err : "pass");
+            exit(1);
+        }
+        free(err);
+    }
+    for (int i = 0; bad_dson[i] != NULL; i++) {
+        err = dson_to_json(bad_dson[i], strlen(bad_dson[i]), NULL, &out, &len);
+        if (err == NULL || out != NULL || len != 0) {
+            fprintf(stderr, "DSON '%s' passed\n", bad_dson[i]);
+            exit(1);
+        }
+        free(err);
+    }
+
+    /* deep doge.  no stack */
+    memset(deep, '[', sizeof(deep) - 1);
+    deep[sizeof(deep) - 1] = '\0';
+    err = json_to_dson(deep, strlen(deep), NULL, &out, &len);
+    if (err == NULL || strstr(err, "nesting deeper") == NULL) {
+        fprintf(stderr, "deep input gave '%s'\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+
+    err = json_to_dson("1 ", 1, NULL, &out, &len);
+    if (err == NULL) {
+        fprintf(stderr, "unterminated input passed\n");
+        exit(1);
+    }
+    free(err);
+
+    printf("pass\n");
+}
+
+static void counting(void) {
+    const char *json = "{\"a\":[1,2,{\"b\":\"c\"}],\"d\":true}";
+    dson_dump_options dopts = { 0 };
+    dson_parse_options popts = { 0 };
+    dson_stats from_json, from_dson;
+    char *dson, *back;
+    size_t dson_len, back_len;
+
+    printf("Counting...");
+    fflush(stdout);
+
+    dopts.stats = &from_json;
+    check(json_to_dson(json, strlen(json), &dopts, &dson, &dson_len),
+          "json_to_dson");
+    popts.stats = &from_dson;
+    check(dson_to_json(dson, dson_len, &popts, &back, &back_len),
+          "dson_to_json");
+    expect(back, json, back_len);
+
+    if (from_json.nodes != 7 || from_json.max_depth != 3 ||
+        from_json.bytes != dson_len || from_dson.nodes != 7 ||
+        from_dson.max_depth != 3 || from_dson.bytes != back_len) {
+        fprintf(stderr, "got %llu/%llu nodes, depth %llu/%llu\n",
+                (unsigned long long)from_json.nodes,
+                (unsigned long long)from_dson.nodes,
+                (unsigned long long)from_json.max_depth,
+                (unsigned long long)from_dson.max_depth);
+        exit(1);
+    }
+
+    dson_free_buffer(dson);
+    dson_free_buffer(back);
+    printf("pass\n");
+}
+
+int main() {
+    round_trips();
+    pairs();
+    refusals();
+    counting();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
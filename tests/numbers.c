@@ -0,0 +1,162 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const dson_parse_options lazy = { .lazy_numbers = true };
+
+/* eager and lazy.  same double */
+static void as_double(const char *text, double expected) {
+    dson_value *eager, *late;
+    double d;
+
+    printf("Reading \"%s\"...", text);
+    fflush(stdout);
+
+    check(dson_parse(text, strlen(text), false, &eager), "parse");
+    check(dson_parse_with(text, strlen(text), &lazy, &late), "parse_with");
+    if (eager->type != DSON_DOUBLE || late->type != DSON_NUMBER) {
+        fprintf(stderr, "wrong types %d and %d\n", eager->type, late->type);
+        exit(1);
+    }
+    check(dson_get_double(late, &d), "get_double");
+    if (eager->n != expected || d != expected) {
+        fprintf(stderr, "expected %a, got %a and %a\n", expected, eager->n,
+                d);
+        exit(1);
+    }
+
+    dson_free(&late);
+    dson_free(&eager);
+    printf("pass\n");
+}
+
+static void as_int(const char *text, int64_t expected) {
+    dson_value *v;
+    int64_t i;
+
+    printf("Reading \"%s\" as an integer...", text);
+    fflush(stdout);
+
+    check(dson_parse_with(text, strlen(text), &lazy, &v), "parse_with");
+    check(dson_get_int64(v, &i), "get_int64");
+    if (i != expected) {
+        fprintf(stderr, "expected %lld, got %lld\n", (long long)expected,
+                (long long)i);
+        exit(1);
+    }
+    dson_free(&v);
+    printf("pass\n");
+}
+
+static void not_int(const char *text) {
+    dson_value *v;
+    int64_t i;
+
+    printf("Refusing \"%s\" as an integer...", text);
+    fflush(stdout);
+
+    check(dson_parse_with(text, strlen(text), &lazy, &v), "parse_with");
+    expect_error(dson_get_int64(v, &i), "get_int64");
+    dson_free(&v);
+    printf("pass\n");
+}
+
+static void conversion(void) {
+    as_double("0", 0);
+    as_double("-5.2", -5.25);
+    as_double("0.001", 0.001953125);
+    as_double("0.12", 0.15625);
+    as_double("1.4very1", 12);
+    as_double("1very-12", ldexp(1, -036));
+    as_double("- 3 .4 very 2", -224);
+    as_double("7VERY+1", 56);
+
+    /* such tie.  much round */
+    as_double("400000000000000001", ldexp(1, 065));
+    as_double("400000000000000003", ldexp(1, 065) + 4);
+    as_double("400000000000000001.0001", ldexp(1, 065) + 2);
+    as_double("0.252525252525252525252525252525", 0x1.5555555555555p-2);
+
+    as_int("0", 0);
+    as_int("-0", 0);
+    as_int("777", 0777);
+    as_int("400000000000000001", (INT64_C(1) << 065) + 1);
+    as_int("777777777777777777777", INT64_MAX);
+    as_int("-1000000000000000000000", INT64_MIN);
+    as_int("1.4very1", 12);
+    as_int("1000very-3", 1);
+
+    not_int("1000000000000000000000");
+    not_int("-1000000000000000000001");
+    not_int("0.4");
+    not_int("1very-1");
+    not_int("1very77777777777777");
+}
+
+/* such forward.  much verbatim */
+static void untouched(void) {
+    const char *doc = "such \"a\" is so 1.40 and 5very+2 and - 3 many! \"b\" "
+        "is 777777777777777777777 wow";
+    dson_value *v, *eager, *patch, *loaded;
+    void *bin;
+    size_t len;
+    int64_t i;
+    double d;
+
+    printf("Forwarding lazy numbers...");
+    fflush(stdout);
+
+    check(dson_parse_with(doc, strlen(doc), &lazy, &v), "parse_with");
+    expect_dump(v, "such \"a\" is so 1.40 and 5very+2 and - 3 many! \"b\" is "
+                "777777777777777777777 wow");
+
+    check(dson_parse(doc, strlen(doc), false, &eager), "parse");
+    expect_dump(eager, "such \"a\" is so 1.4 and 500 and -3 many! \"b\" is "
+                "1000000000000000000000 wow");
+
+    /* same values but one.  eager rounded 2 ** 077 - 1 up */
+    check(dson_diff(v, eager, &patch), "diff");
+    expect_dump(patch, "so so \".b\" and 1000000000000000000000 many many");
+    dson_free(&patch);
+
+    check(dson_dump_binary(v, &bin, &len), "dump_binary");
+    check(dson_load_binary(bin, len, &loaded), "load_binary");
+    expect_dump(loaded, "such \"a\" is so 1.4 and 500 and -3 many! \"b\" is "
+                "1000000000000000000000 wow");
+    free(bin);
+    dson_free(&loaded);
+
+    check(dson_fetch(v, ".a[0]", DSON_MATCH_ERROR, &loaded), "fetch");
+    expect_error(dson_get_int64(loaded, &i), "fraction as int");
+    check(dson_fetch(v, ".b", DSON_MATCH_ERROR, &loaded), "fetch");
+    check(dson_get_int64(loaded, &i), "get_int64");
+    if (i != INT64_MAX) {
+        fprintf(stderr, "lost precision\n");
+        exit(1);
+    }
+    expect_error(dson_get_double(v, &d), "dict as double");
+
+    dson_free(&eager);
+    dson_free(&v);
+    printf("pass\n");
+}
+
+int main() {
+    conversion();
+    untouched();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,143 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include <cdson.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+template <typename T>
+static T take(dson::result<T> r, const char *what) {
+    if (!r) {
+        fprintf(stderr, "%s failed: %s\n", what, r.error().what());
+        exit(1);
+    }
+    return std::move(*r);
+}
+
+template <typename T>
+static void expect_error(const dson::result<T> &r, const char *message) {
+    if (r) {
+        fprintf(stderr, "%s: unexpected success\n", message);
+        exit(1);
+    } else if (strcmp(r.error().what(), message)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", message,
+                r.error().what());
+        exit(1);
+    }
+}
+
+static const std::string doc = "such \"meta\" is such \"items\" is so "
+    "such \"id\" is 1 wow and such \"id\" is 2 wow and 3 and such \"id\" is "
+    "-4, \"id\" is 5 wow many, \"name\" is \"doge\" wow, \"ok\" is yes, "
+    "\"\" is 6, \"big\" is 1777777777777777777777 wow";
+
+/* such compile.  much check */
+using items_id = dson::path<".meta.items[3].id">;
+static_assert(items_id::steps.size() == 4);
+static_assert(!items_id::steps[0].is_index && items_id::steps[0].n == 4);
+static_assert(items_id::steps[1].n == 5 && items_id::steps[1].end == 11);
+static_assert(items_id::steps[2].is_index && items_id::steps[2].n == 3);
+static_assert(items_id::steps[3].hash == dson::detail::fnv1a("id", 2));
+static_assert(dson::path<"">::steps.empty());
+static_assert(dson::path<"[12]">::steps[0].n == 12); /* decimal, as fetch */
+
+/* Every path here again through dson_fetch(), for the same answer. */
+template <dson::fixed_string Q>
+static void agree(const dson::document &d, uint8_t match) {
+    dson::result<dson::value> ours = dson::get<dson::value>(d, dson::path<Q>{},
+                                                            match);
+    dson::result<dson::value> theirs = d.fetch(Q.s, match);
+
+    if (ours.has_value() != theirs.has_value() ||
+        (ours && ours->get() != theirs->get())) {
+        fprintf(stderr, "%s disagrees with dson_fetch()\n", Q.s);
+        exit(1);
+    }
+}
+
+static void walking(const dson_parse_options *opts) {
+    dson::document d = take(dson::document::parse(doc, opts), "parse");
+
+    for (uint8_t match = DSON_MATCH_FIRST; match <= DSON_MATCH_ERROR;
+         match++) {
+        agree<"">(d, match);
+        agree<".meta">(d, match);
+        agree<".meta.items[0].id">(d, match);
+        agree<".meta.items[3].id">(d, match);
+        agree<".meta.items[4]">(d, match);
+        agree<".meta.items[2].id">(d, match);
+        agree<".meta.name">(d, match);
+        agree<".meta.nope">(d, match);
+        agree<".">(d, match);
+        agree<"[0]">(d, match);
+        agree<".meta.items.id">(d, match);
+    }
+}
+
+static void typed(void) {
+    dson_parse_options opts = {};
+    dson::document d;
+
+    printf("Reading typed values...");
+    fflush(stdout);
+
+    opts.integers = true;
+    d = take(dson::document::parse(doc, &opts), "parse");
+
+    if (take(dson::get<int64_t>(d, items_id{}), "get") != -4 ||
+        take(dson::get<int64_t>(d, items_id{}, DSON_MATCH_LAST),
+             "get") != 5 ||
+        take(dson::get<std::string_view>(d, dson::path<".meta.name">{}),
+             "get") != "doge" ||
+        !take(dson::get<bool>(d, dson::path<".ok">{}), "get") ||
+        take(dson::get<double>(d, dson::path<".">{}), "get") != 6 ||
+        take(dson::get<uint64_t>(d, dson::path<".big">{}), "get") !=
+        UINT64_MAX ||
+        take(dson::get<dson::array>(d, dson::path<".meta.items">{}),
+             "get").size() != 4 ||
+        take(dson::get<dson::dict>(d.root(), dson::path<".meta">{}),
+             "get").size() != 2) {
+        fprintf(stderr, "read wrong\n");
+        exit(1);
+    }
+
+    /* such wrong.  says where */
+    expect_error(dson::get<int64_t>(d, items_id{}, DSON_MATCH_ERROR),
+                 "duplicate matching keys in dict at .meta.items[3].id");
+    expect_error(dson::get<int64_t>(d, dson::path<".meta.items[9].id">{}),
+                 "index is beyond array bounds at .meta.items[9]");
+    expect_error(dson::get<int64_t>(d, dson::path<".meta.name.x">{}),
+                 "type mismatch: expected DICT, but query disagreed at "
+                 ".meta.name.x");
+    expect_error(dson::get<int64_t>(d, dson::path<".meta.name">{}),
+                 "value is not a number");
+    expect_error(dson::get<std::string_view>(d, dson::path<".ok">{}),
+                 "value is not a string");
+    expect_error(dson::get<bool>(dson::value(), dson::path<".ok">{}),
+                 "input tree cannot be NULL");
+
+    printf("pass\n");
+}
+
+int main() {
+    dson_parse_options opts = {};
+
+    printf("Walking as dson_fetch() does...");
+    fflush(stdout);
+    walking(nullptr);
+    opts.intern_keys = true;
+    walking(&opts);
+    printf("pass\n");
+
+    typed();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
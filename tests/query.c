@@ -0,0 +1,173 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *doc =
+    "such \"users\" is so "
+    "such \"name\" is \"shibe\", \"id\" is 1 wow and "
+    "such \"name\" is \"doge\", \"id\" is 2, \"pets\" is so "
+    "such \"name\" is \"inu\", \"id\" is 3 wow many wow and "
+    "such \"id\" is 4 wow and "
+    "such \"name\" is \"kabosu\", \"id\" is 5 wow many, "
+    "\"id\" is 6, \"dupes\" is such \"k\" is 1! \"k\" is 2 wow wow";
+
+static void expect(dson_value *tree, const char *query, uint8_t match,
+                   const char *expected) {
+    dson_value *results;
+    char *out;
+    size_t len;
+
+    printf("Querying \"%s\"...", query);
+    fflush(stdout);
+
+    check(dson_query(tree, query, match, &results), "query");
+    check(dson_dump(results, &out, &len), "dump");
+    if (strcmp(out, expected)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", expected, out);
+        exit(1);
+    }
+    free(out);
+    dson_free(&results);
+    printf("pass\n");
+}
+
+static void queries(dson_value *tree) {
+    expect(tree, "", DSON_MATCH_FIRST, "so such \"users\" is so such \"name\" "
+           "is \"shibe\"! \"id\" is 1 wow and such \"name\" is \"doge\"! "
+           "\"id\" is 2! \"pets\" is so such \"name\" is \"inu\"! \"id\" is 3 "
+           "wow many wow and such \"id\" is 4 wow and such \"name\" is "
+           "\"kabosu\"! \"id\" is 5 wow many! \"id\" is 6! \"dupes\" is such "
+           "\"k\" is 1! \"k\" is 2 wow wow many");
+    expect(tree, ".users[1].id", DSON_MATCH_FIRST, "so 2 many");
+    expect(tree, ".users[*].name", DSON_MATCH_FIRST,
+           "so \"shibe\" and \"doge\" and \"kabosu\" many");
+    expect(tree, ".users[1:3].id", DSON_MATCH_FIRST, "so 2 and 4 many");
+    expect(tree, ".users[2:].id", DSON_MATCH_FIRST, "so 4 and 5 many");
+    expect(tree, ".users[:1].id", DSON_MATCH_FIRST, "so 1 many");
+    expect(tree, ".users[3:1].id", DSON_MATCH_FIRST, "so many");
+    expect(tree, ".users[7]", DSON_MATCH_FIRST, "so many");
+    expect(tree, ".users.name", DSON_MATCH_FIRST, "so many");
+    expect(tree, ".users[0].*", DSON_MATCH_FIRST, "so \"shibe\" and 1 many");
+    expect(tree, "..id", DSON_MATCH_FIRST,
+           "so 1 and 2 and 3 and 4 and 5 and 6 many");
+    expect(tree, ".users..name", DSON_MATCH_FIRST,
+           "so \"shibe\" and \"doge\" and \"inu\" and \"kabosu\" many");
+    expect(tree, "..pets[*].id", DSON_MATCH_FIRST, "so 3 many");
+    expect(tree, ".dupes..*", DSON_MATCH_FIRST, "so 1 and 2 many");
+    expect(tree, ".dupes.k", DSON_MATCH_LAST, "so 2 many");
+    expect(tree, "..k", DSON_MATCH_FIRST, "so 1 many");
+}
+
+/* every value below.  arrays and dicts, either inside the other */
+static void wildcards(void) {
+    static const struct {
+        const char *doc;
+        const char *expected;
+    } cases[] = {
+        { "so 1 and 2 many", "so 1 and 2 many" },
+        { "such \"a\" is so 1 and such \"b\" is 2 wow many wow",
+          "so so 1 and such \"b\" is 2 wow many and 1 and such \"b\" is 2 "
+          "wow and 2 many" },
+        { "so such \"a\" is so 3 many wow and 4 many",
+          "so such \"a\" is so 3 many wow and so 3 many and 3 and 4 many" },
+        { "7", "so many" },
+        { NULL, NULL },
+    };
+    dson_value *tree;
+
+    for (int i = 0; cases[i].doc != NULL; i++) {
+        check(dson_parse(cases[i].doc, strlen(cases[i].doc), false, &tree),
+              "parse");
+        expect(tree, "..*", DSON_MATCH_FIRST, cases[i].expected);
+        dson_free(&tree);
+    }
+}
+
+static bool count_to_three(void *ctx, dson_value *v) {
+    size_t *n = ctx;
+
+    (void)v;
+    return ++*n < 3;
+}
+
+static void others(dson_value *tree) {
+    dson_value *results, *copy;
+    size_t n = 0;
+    char *err;
+
+    printf("Stopping early and failing...");
+    fflush(stdout);
+
+    check(dson_query_each(tree, "..id", DSON_MATCH_FIRST, count_to_three, &n),
+          "query_each");
+    if (n != 3) {
+        fprintf(stderr, "callback ran %zu times\n", n);
+        exit(1);
+    }
+
+    expect_error(dson_query(tree, "..k", DSON_MATCH_ERROR, &results),
+                 "duplicate keys");
+    expect_error(dson_query(tree, "users", DSON_MATCH_FIRST, &results),
+                 "no leading delimiter");
+    expect_error(dson_query(tree, ".users[", DSON_MATCH_FIRST, &results),
+                 "unclosed");
+    err = dson_query(tree, ".users[1", DSON_MATCH_FIRST, &results);
+    if (err == NULL || strcmp(err, "query ends inside array access "
+                              "(missing ']'?)")) {
+        fprintf(stderr, "unclosed index gave \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    expect_error(dson_query(tree, ".users[]", DSON_MATCH_FIRST, &results),
+                 "empty index");
+    expect_error(dson_query(tree, ".users[a]", DSON_MATCH_FIRST, &results),
+                 "bad index");
+    expect_error(dson_query(tree, "..", DSON_MATCH_FIRST, &results),
+                 "descent without key");
+    expect_error(dson_query(tree, ".a]", DSON_MATCH_FIRST, &results),
+                 "stray bracket");
+
+    /* such results.  outlive the tree */
+    check(dson_clone(tree, &copy), "clone");
+    check(dson_query(copy, ".users[*].name", DSON_MATCH_FIRST, &results),
+          "query");
+    dson_free(&copy);
+    if (results->array[2]->type != DSON_STRING ||
+        strcmp(results->array[2]->s, "kabosu")) {
+        fprintf(stderr, "lost results\n");
+        exit(1);
+    }
+    dson_free(&results);
+
+    printf("pass\n");
+}
+
+int main() {
+    dson_parse_options interned = { .intern_keys = true };
+    dson_value *tree;
+
+    check(dson_parse(doc, strlen(doc), false, &tree), "parse");
+    queries(tree);
+    others(tree);
+    dson_free(&tree);
+
+    check(dson_parse_with(doc, strlen(doc), &interned, &tree), "parse_with");
+    queries(tree);
+    dson_free(&tree);
+
+    wildcards();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
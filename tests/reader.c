@@ -0,0 +1,253 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Every token of doc, one letter each, with keys and strings after them. */
+static void tokens(const char *doc, const dson_parse_options *opts,
+                   char *seen, size_t size) {
+    static const char letters[] = "-vadke";
+    dson_reader *r;
+    dson_token tok;
+    size_t len = 0;
+
+    check(dson_reader_new(doc, strlen(doc), opts, &r), "reader_new");
+    do {
+        check(dson_reader_next(r, &tok), "reader_next");
+        len += snprintf(seen + len, size - len, "%c", letters[tok.kind]);
+        if (tok.kind == DSON_TOKEN_KEY ||
+            (tok.kind == DSON_TOKEN_VALUE &&
+             tok.value.type == DSON_STRING)) {
+            len += snprintf(seen + len, size - len, "%s", tok.value.s);
+            free(tok.value.s);
+        } else if (tok.kind == DSON_TOKEN_VALUE) {
+            len += snprintf(seen + len, size - len, "%d", tok.value.type);
+        }
+    } while (tok.kind != DSON_TOKEN_DONE);
+    dson_reader_free(&r);
+}
+
+static void order(void) {
+    const char *doc = "  such \"a\" is so 1 also \"s\" and no many! \"b\" is "
+        "such \"c\" is empty wow? \"d\" is so many wow  ";
+    dson_parse_options opts = { 0 };
+    char seen[256];
+
+    printf("Reading tokens in order...");
+    fflush(stdout);
+
+    tokens(doc, NULL, seen, sizeof(seen));
+    if (strcmp(seen, "dkaav2vsv1ekbdkcv0ekdaee-")) {
+        fprintf(stderr, "got \"%s\"\n", seen);
+        exit(1);
+    }
+
+    /* such options.  numbers as asked */
+    opts.integers = true;
+    tokens("so 1 and 1.4 many", &opts, seen, sizeof(seen));
+    if (strcmp(seen, "av7v2e-")) {
+        fprintf(stderr, "got \"%s\"\n", seen);
+        exit(1);
+    }
+    opts.lazy_numbers = true;
+    tokens("so 1 and 1.4 many", &opts, seen, sizeof(seen));
+    if (strcmp(seen, "av7v6e-")) {
+        fprintf(stderr, "got \"%s\"\n", seen);
+        exit(1);
+    }
+
+    /* such wow.  empty */
+    tokens("such \"a\" is such wow! \"b\" is so many wow", NULL, seen,
+           sizeof(seen));
+    if (strcmp(seen, "dkadekbaee-")) {
+        fprintf(stderr, "got \"%s\"\n", seen);
+        exit(1);
+    }
+
+    tokens("\"alone\"", NULL, seen, sizeof(seen));
+    if (strcmp(seen, "valone-")) {
+        fprintf(stderr, "got \"%s\"\n", seen);
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+static void skipping(void) {
+    const char *doc = "such \"skip\" is so such \"x\" is so \"deep\" many wow "
+        "many, \"keep\" is 3, \"also\" is \"gone\" wow";
+    dson_reader *r;
+    dson_token tok;
+    char *err;
+
+    printf("Skipping values...");
+    fflush(stdout);
+
+    check(dson_reader_new(doc, strlen(doc), NULL, &r), "reader_new");
+    err = dson_reader_skip(r);
+    check(dson_reader_next(r, &tok), "reader_next");
+    if (err != NULL || tok.kind != DSON_TOKEN_DONE) {
+        fprintf(stderr, "whole document not skipped\n");
+        exit(1);
+    }
+    dson_reader_free(&r);
+
+    check(dson_reader_new(doc, strlen(doc), NULL, &r), "reader_new");
+    check(dson_reader_next(r, &tok), "reader_next");
+    err = dson_reader_skip(r);
+    if (err == NULL) {
+        fprintf(stderr, "skipped with no value next\n");
+        exit(1);
+    }
+    free(err);
+    for (int i = 0; i < 3; i++) {
+        check(dson_reader_next(r, &tok), "reader_next");
+        if (tok.kind != DSON_TOKEN_KEY) {
+            fprintf(stderr, "expected a key, got %d\n", tok.kind);
+            exit(1);
+        }
+        free(tok.value.s);
+        if (i != 1) {
+            check(dson_reader_skip(r), "reader_skip");
+            continue;
+        }
+        check(dson_reader_next(r, &tok), "reader_next");
+        if (tok.kind != DSON_TOKEN_VALUE || tok.value.n != 3) {
+            fprintf(stderr, "expected 3\n");
+            exit(1);
+        }
+    }
+    check(dson_reader_next(r, &tok), "reader_next");
+    if (tok.kind != DSON_TOKEN_END) {
+        fprintf(stderr, "expected the end, got %d\n", tok.kind);
+        exit(1);
+    }
+    dson_reader_free(&r);
+
+    printf("pass\n");
+}
+
+static void failing(void) {
+    const char *bad[] = {
+        "so 1 and many",
+        "such \"a\" was 1 wow",
+        "such \"a\" is 1 many",
+        "so 1 also",
+        "such \"a\" is 1, wow",
+        "such, wow",
+        "sox",
+        "",
+        NULL,
+    };
+    dson_reader *r;
+    dson_token tok;
+    char *err;
+
+    printf("Failing on bad input...");
+    fflush(stdout);
+
+    for (int i = 0; bad[i] != NULL; i++) {
+        check(dson_reader_new(bad[i], strlen(bad[i]), NULL, &r),
+              "reader_new");
+        do {
+            err = dson_reader_next(r, &tok);
+            if (err == NULL && tok.value.type == DSON_STRING)
+                free(tok.value.s);
+        } while (err == NULL && tok.kind != DSON_TOKEN_DONE);
+        if (err == NULL) {
+            fprintf(stderr, "\"%s\" was read\n", bad[i]);
+            exit(1);
+        }
+        free(err);
+
+        /* much broken.  stays so */
+        err = dson_reader_next(r, &tok);
+        if (err == NULL) {
+            fprintf(stderr, "read on after failing\n");
+            exit(1);
+        }
+        free(err);
+        dson_reader_free(&r);
+    }
+
+    printf("pass\n");
+}
+
+/* Tokens into a writer make what a tree into dson_dump() would. */
+static void rewrite(void) {
+    const char *doc = "such \"users\" is so such \"name\" is \"shibe\", "
+        "\"id\" is 42very3 wow also such \"name\" is \"doge\", \"tags\" is so "
+        "yes and no and empty many, \"id\" is -1.4 wow many! \"n\" is 7 wow";
+    dson_value *tree;
+    dson_reader *r;
+    dson_writer *w;
+    dson_token tok;
+    char *dumped, *written, *err = NULL;
+    size_t dumped_len, written_len;
+
+    printf("Rewriting from tokens...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &tree), "parse");
+    check(dson_dump(tree, &dumped, &dumped_len), "dump");
+    dson_free(&tree);
+
+    check(dson_reader_new(doc, strlen(doc), NULL, &r), "reader_new");
+    check(dson_writer_new(NULL, &w), "writer_new");
+    while (err == NULL) {
+        check(dson_reader_next(r, &tok), "reader_next");
+        if (tok.kind == DSON_TOKEN_DONE)
+            break;
+        else if (tok.kind == DSON_TOKEN_ARRAY)
+            err = dson_writer_begin_array(w);
+        else if (tok.kind == DSON_TOKEN_DICT)
+            err = dson_writer_begin_dict(w);
+        else if (tok.kind == DSON_TOKEN_END)
+            err = dson_writer_end(w);
+        else if (tok.kind == DSON_TOKEN_KEY)
+            err = dson_writer_key(w, tok.value.s);
+        else if (tok.value.type == DSON_STRING)
+            err = dson_writer_string(w, tok.value.s);
+        else if (tok.value.type == DSON_DOUBLE)
+            err = dson_writer_double(w, tok.value.n);
+        else if (tok.value.type == DSON_BOOL)
+            err = dson_writer_bool(w, tok.value.b);
+        else
+            err = dson_writer_none(w);
+        if (tok.value.type == DSON_STRING)
+            free(tok.value.s);
+    }
+    check(err, "write");
+    check(dson_writer_finish(w, &written, &written_len), "writer_finish");
+    dson_writer_free(&w);
+    dson_reader_free(&r);
+
+    if (written_len != dumped_len || strcmp(written, dumped)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", dumped, written);
+        exit(1);
+    }
+    free(written);
+    free(dumped);
+
+    printf("pass\n");
+}
+
+int main() {
+    order();
+    skipping();
+    failing();
+    rewrite();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
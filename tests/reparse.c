@@ -0,0 +1,227 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* the whole document, once edited */
+#define ALL SIZE_MAX
+
+static dson_stats stats;
+static const dson_parse_options spans = {
+    .spans = true, .intern_keys = true, .stats = &stats,
+};
+
+static char *dump(dson_value *v) {
+    char *out;
+    size_t len;
+
+    check(dson_dump(v, &out, &len), "dump");
+    return out;
+}
+
+/* Replace the first occurrence of old in *text with new, describing it in
+ * *e. */
+static void edit(char **text, const char *old, const char *new,
+                 dson_edit *e) {
+    char *at = strstr(*text, old), *out;
+    size_t len = strlen(*text);
+
+    if (at == NULL) {
+        fprintf(stderr, "no \"%s\" to edit\n", old);
+        exit(1);
+    }
+    e->start = at - *text;
+    e->removed = strlen(old);
+    e->inserted = strlen(new);
+
+    out = malloc(len - e->removed + e->inserted + 1);
+    if (out == NULL)
+        exit(1);
+    memcpy(out, *text, e->start);
+    memcpy(out + e->start, new, e->inserted);
+    strcpy(out + e->start + e->inserted, at + e->removed);
+    free(*text);
+    *text = out;
+}
+
+/* reparsed.  parsed.  same doge */
+static void expect_fresh(dson_value *v, const char *text) {
+    dson_value *fresh;
+    char *a, *b;
+
+    check(dson_parse(text, strlen(text), false, &fresh), "parse");
+    a = dump(v);
+    b = dump(fresh);
+    if (strcmp(a, b)) {
+        fprintf(stderr, "reparse gave \"%s\", parse gave \"%s\"\n", a, b);
+        exit(1);
+    }
+    free(a);
+    free(b);
+    dson_free(&fresh);
+}
+
+/* Apply an edit, reparse, and check both the result and how much of the
+ * text was parsed again. */
+static void step(dson_value **v, char **text, const char *old,
+                 const char *new, size_t expect_bytes) {
+    dson_edit e;
+
+    edit(text, old, new, &e);
+    check(dson_reparse(v, *text, strlen(*text), &e, &spans), "reparse");
+    expect_fresh(*v, *text);
+    if (expect_bytes == ALL)
+        expect_bytes = strlen(*text);
+    if (stats.bytes != expect_bytes) {
+        fprintf(stderr, "\"%s\" -> \"%s\": reparsed %llu bytes, not %zu\n",
+                old, new, (unsigned long long)stats.bytes, expect_bytes);
+        exit(1);
+    }
+}
+
+static void localized(void) {
+    char *text = strdup("such \"a\" is so 1 and 2 many! \"b\" is such \"c\" "
+                        "is \"x\" wow! \"d\" is yes wow");
+    dson_value *v, *clone, *c;
+    dson_edit e;
+
+    printf("Reparsing small edits...");
+    fflush(stdout);
+
+    check(dson_parse_with(text, strlen(text), &spans, &v), "parse_with");
+
+    step(&v, &text, "2", "3 and 4", strlen("so 1 and 3 and 4 many"));
+    step(&v, &text, "\"x\"", "\"xyz\"", strlen("such \"c\" is \"xyz\" wow"));
+    step(&v, &text, "yes", "no", ALL);
+    step(&v, &text, "1 and", "so 5 many and", strlen("so so 5 many and 3 and "
+                                                     "4 many"));
+    step(&v, &text, "5", "6", strlen("so 6 many"));
+
+    /* alone, too much.  together, fine */
+    step(&v, &text, "6", "6 many and so 10", strlen("so so 6 many and so "
+                                                     "10 many and 3 and 4 "
+                                                     "many"));
+
+    /* interned like its neighbors */
+    check(dson_fetch(v, ".b", DSON_MATCH_ERROR, &c), "fetch");
+    if (c->dict->intern != v->dict->intern) {
+        fprintf(stderr, "reparsed dict has its own key table\n");
+        exit(1);
+    }
+
+    /* such clone.  shared root replaced, not changed */
+    check(dson_clone(v, &clone), "clone");
+    step(&v, &text, "6", "7", ALL);
+    check(dson_fetch(clone, ".a[0][0]", DSON_MATCH_ERROR, &c), "fetch");
+    if (c->type != DSON_DOUBLE || c->n != 6) {
+        fprintf(stderr, "clone changed\n");
+        exit(1);
+    }
+    dson_free(&clone);
+
+    /* such mistake.  nothing changes */
+    edit(&text, "\"xyz\"", "\"xyz", &e);
+    expect_error(dson_reparse(&v, text, strlen(text), &e, &spans),
+                 "unterminated string");
+    edit(&text, "\"xyz", "\"xyz\"", &e);
+    expect_fresh(v, text);
+
+    free(text);
+    dson_free(&v);
+    printf("pass\n");
+}
+
+static void refusals(void) {
+    dson_parse_options none = { 0 }, lazy = { .spans = true,
+                                              .lazy_numbers = true };
+    const char *text = "so 1 many";
+    dson_edit e = { 03, 01, 01 };
+    dson_value *v;
+
+    printf("Refusing to reparse...");
+    fflush(stdout);
+
+    check(dson_parse(text, strlen(text), false, &v), "parse");
+    expect_error(dson_reparse(&v, text, strlen(text), &e, &none), "no spans");
+    expect_error(dson_reparse(&v, text, strlen(text), &e, &lazy), "lazy");
+    e.inserted = 0100;
+    expect_error(dson_reparse(&v, text, strlen(text), &e, &spans), "bounds");
+
+    /* never had spans.  whole thing, then */
+    e.inserted = 01;
+    check(dson_reparse(&v, text, strlen(text), &e, &spans), "reparse");
+    expect_fresh(v, text);
+    dson_free(&v);
+
+    printf("pass\n");
+}
+
+/* big document.  one small change */
+static void large(void) {
+    size_t n = 040000, len = 0, cap = n * 060;
+    char *text = malloc(cap);
+    dson_footprint with, without;
+    dson_value *v, *plain;
+    char key[32], *a, *b;
+
+    printf("Reparsing one entry of %zu...", n);
+    fflush(stdout);
+
+    if (text == NULL)
+        exit(1);
+    len += sprintf(text, "such");
+    for (size_t i = 0; i < n; i++) {
+        len += sprintf(text + len, "%s\"k%zu\" is so %zo and yes many",
+                       i ? ". " : " ", i, i);
+    }
+    len += sprintf(text + len, " wow");
+
+    check(dson_parse_with(text, len, &spans, &v), "parse_with");
+    check(dson_parse(text, len, false, &plain), "parse");
+    check(dson_tree_stats(v, &with), "tree_stats");
+    check(dson_tree_stats(plain, &without), "tree_stats");
+    if (with.node_bytes != without.node_bytes +
+        (n + 1) * 2 * sizeof(size_t)) {
+        fprintf(stderr, "spans not counted\n");
+        exit(1);
+    }
+    dson_free(&plain);
+
+    snprintf(key, sizeof(key), " %zo and", n / 2);
+    step(&v, &text, key, " no and", strlen("so no and yes many"));
+
+    check(dson_fetch(v, ".k8192[0]", DSON_MATCH_ERROR, &plain), "fetch");
+    a = dump(plain);
+    check(dson_fetch(v, ".k8193[0]", DSON_MATCH_ERROR, &plain), "fetch");
+    b = dump(plain);
+    if (strcmp(a, "no") || strcmp(b, "20001")) {
+        fprintf(stderr, "wrong entries: %s, %s\n", a, b);
+        exit(1);
+    }
+    free(a);
+    free(b);
+
+    dson_free(&v);
+    free(text);
+    printf("pass\n");
+}
+
+int main() {
+    localized();
+    refusals();
+    large();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
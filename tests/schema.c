@@ -0,0 +1,366 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *users_schema =
+    "such \"type\" is \"dict\", \"required\" is so \"users\" many, "
+    "\"closed\" is yes, \"keys\" is such "
+    "\"users\" is such \"type\" is \"array\", \"max_items\" is 4, "
+    "\"items\" is such \"type\" is \"dict\", "
+    "\"required\" is so \"name\" also \"id\" many, "
+    "\"keys\" is such \"name\" is such \"type\" is \"string\", "
+    "\"min_length\" is 1, \"max_length\" is 10 wow, "
+    "\"id\" is such \"type\" is \"integer\", \"min\" is 0 wow, "
+    "\"note\" is empty wow wow wow, "
+    "\"version\" is such \"type\" is so \"number\" also \"none\" many wow "
+    "wow wow";
+
+static const struct {
+    const char *doc;
+    const char *error; /* NULL if it passes */
+} cases[] = {
+    { "such \"users\" is so such \"name\" is \"doge\", \"id\" is 1 wow "
+      "also such \"id\" is 2, \"name\" is \"shibe\", \"note\" is so yes "
+      "many, \"other\" is 4 wow many, \"version\" is 1.4 wow", NULL },
+    { "such \"users\" is so many, \"version\" is empty wow", NULL },
+    { "such \"version\" is 1 wow",
+      "at top: missing required key \"users\"" },
+    { "such \"users\" is so many, \"extra\" is 1 wow",
+      "at .extra: key \"extra\" is not allowed here" },
+    { "such \"users\" is so such \"name\" is \"doge\", \"id\" is 1 wow "
+      "and such \"name\" is \"123456789\", \"id\" is 2 wow many wow",
+      "at .users[1].name: string is longer than 8 bytes" },
+    { "such \"users\" is so such \"name\" is \"\", \"id\" is 1 wow many wow",
+      "at .users[0].name: string is shorter than 1 bytes" },
+    { "such \"users\" is so such \"name\" is \"a\", \"id\" is 1.4 wow "
+      "many wow", "at .users[0].id: number is not an integer" },
+    { "such \"users\" is so such \"name\" is \"a\", \"id\" is -1 wow "
+      "many wow", "at .users[0].id: -1 is below the minimum of 0" },
+    { "such \"users\" is so such \"name\" is \"a\" wow many wow",
+      "at .users[0]: missing required key \"id\"" },
+    { "such \"users\" is so such \"name\" is \"a\", \"id\" is 1 wow and "
+      "such \"name\" is \"a\", \"id\" is 1 wow and such \"name\" is \"a\", "
+      "\"id\" is 1 wow and such \"name\" is \"a\", \"id\" is 1 wow and "
+      "such \"name\" is \"a\", \"id\" is 1 wow many wow",
+      "at .users: array has more than 4 elements" },
+    { "such \"users\" is so many, \"version\" is \"one\" wow",
+      "at .version: string is not allowed here" },
+    { "so many", "at top: array is not allowed here" },
+    { NULL, NULL },
+};
+
+static dson_schema *compiled(const char *text) {
+    dson_value *tree;
+    dson_schema *s;
+
+    check(dson_parse(text, strlen(text), false, &tree), "parse schema");
+    check(dson_schema_compile(tree, &s), "schema_compile");
+    dson_free(&tree);
+    return s;
+}
+
+static void compiling(void) {
+    const char *bad[] = {
+        "such \"typo\" is \"dict\" wow",
+        "such \"type\" is \"doge\" wow",
+        "such \"type\" is 4 wow",
+        "such \"required\" is \"name\" wow",
+        "such \"required\" is so 1 many wow",
+        "such \"max_items\" is -1 wow",
+        "such \"min\" is \"low\" wow",
+        "such \"closed\" is 1 wow",
+        "such \"items\" is so many wow",
+        "such \"keys\" is such \"a\" is empty! \"a\" is empty wow wow",
+        "yes",
+        NULL,
+    };
+    dson_value *tree;
+    dson_schema *s;
+    char *err;
+
+    printf("Refusing bad schemas...");
+    fflush(stdout);
+
+    for (int i = 0; bad[i] != NULL; i++) {
+        check(dson_parse(bad[i], strlen(bad[i]), false, &tree), "parse");
+        err = dson_schema_compile(tree, &s);
+        if (err == NULL || s != NULL) {
+            fprintf(stderr, "\"%s\" compiled\n", bad[i]);
+            exit(1);
+        }
+        free(err);
+        dson_free(&tree);
+    }
+
+    /* such permissive.  anything goes */
+    s = compiled("empty");
+    check(dson_parse("so 1 many", 9, false, &tree), "parse");
+    check(dson_schema_validate(tree, s), "validate");
+    dson_free(&tree);
+    dson_schema_free(&s);
+
+    printf("pass\n");
+}
+
+static void validating(void) {
+    dson_schema *s = compiled(users_schema);
+    dson_value *tree;
+    char *err;
+
+    printf("Validating trees...");
+    fflush(stdout);
+
+    /* twice.  nothing left over from last time */
+    for (int round = 0; round < 2; round++) {
+        for (int i = 0; cases[i].doc != NULL; i++) {
+            check(dson_parse(cases[i].doc, strlen(cases[i].doc), false,
+                             &tree), "parse");
+            err = dson_schema_validate(tree, s);
+            if ((err == NULL) != (cases[i].error == NULL) ||
+                (err != NULL && strcmp(err, cases[i].error))) {
+                fprintf(stderr, "case %d: expected \"%s\", got \"%s\"\n", i,
+                        cases[i].error ? cases[i].error : "pass",
+                        err ? err : "pass");
+                exit(1);
+            }
+            free(err);
+            dson_free(&tree);
+        }
+    }
+    dson_schema_free(&s);
+
+    printf("pass\n");
+}
+
+static void parsing(void) {
+    dson_parse_options opts = { 0 };
+    const char *message, *early;
+    dson_value *tree;
+    char *err;
+
+    printf("Validating while parsing...");
+    fflush(stdout);
+
+    opts.schema = compiled(users_schema);
+    for (int lazy = 0; lazy < 2; lazy++) {
+        opts.lazy_numbers = lazy;
+        for (int i = 0; cases[i].doc != NULL; i++) {
+            err = dson_parse_with(cases[i].doc, strlen(cases[i].doc), &opts,
+                                  &tree);
+            if ((err == NULL) != (cases[i].error == NULL)) {
+                fprintf(stderr, "case %d: expected \"%s\", got \"%s\"\n", i,
+                        cases[i].error ? cases[i].error : "pass",
+                        err ? err : "pass");
+                exit(1);
+            } else if (err == NULL) {
+                dson_free(&tree);
+                continue;
+            }
+
+            /* same trouble.  told by position instead */
+            message = strchr(cases[i].error, ':') + 2;
+            if (strncmp(err, "at input char #", 15) ||
+                strstr(err, message) == NULL) {
+                fprintf(stderr, "case %d: expected \"%s\", got \"%s\"\n", i,
+                        message, err);
+                exit(1);
+            }
+            free(err);
+        }
+    }
+
+    /* much early.  never reads the rest */
+    early = "such \"users\" is \"none\" wow garbage";
+    err = dson_parse_with(early, strlen(early), &opts, &tree);
+    if (err == NULL || strstr(err, "string is not allowed here") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    early = "such \"users\" is so 1 and garbage";
+    err = dson_parse_with(early, strlen(early), &opts, &tree);
+    if (err == NULL || strcmp(err, "at input char #19: number is not "
+                              "allowed here")) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    dson_schema_free(&opts.schema);
+
+    printf("pass\n");
+}
+
+static void iterating(void) {
+    const char *doc =
+        "so such \"name\" is \"doge\", \"id\" is 1 wow also such \"id\" is "
+        "2 wow and such \"name\" is \"x\", \"id\" is 3 wow many";
+    dson_parse_options opts = { 0 };
+    dson_iter *it;
+    dson_value *v;
+    char *err;
+    FILE *f;
+    int n = 0;
+
+    printf("Validating while iterating...");
+    fflush(stdout);
+
+    opts.schema = compiled("such \"items\" is such \"required\" is "
+                           "so \"name\" many wow wow");
+    f = tmpfile();
+    if (f == NULL || fputs(doc, f) == EOF)
+        exit(1);
+    rewind(f);
+
+    check(dson_iter_new(f, &opts, &it), "iter_new");
+    while (1) {
+        err = dson_iter_next(it, NULL, &v);
+        if (err != NULL)
+            break;
+        dson_free(&v);
+        n++;
+    }
+    if (n != 1 || strstr(err, "missing required key \"name\"") == NULL) {
+        fprintf(stderr, "after %d: %s\n", n, err);
+        exit(1);
+    }
+    free(err);
+    dson_iter_free(&it);
+    dson_schema_free(&opts.schema);
+
+    /* the whole, at the end */
+    opts.schema = compiled("such \"max_items\" is 2 wow");
+    rewind(f);
+    check(dson_iter_new(f, &opts, &it), "iter_new");
+    /* such last.  its element and the end come together */
+    for (n = 0; n < 2; n++) {
+        check(dson_iter_next(it, NULL, &v), "iter_next");
+        dson_free(&v);
+    }
+    err = dson_iter_next(it, NULL, &v);
+    if (err == NULL || strstr(err, "more than 2 elements") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    dson_iter_free(&it);
+    dson_schema_free(&opts.schema);
+
+    opts.schema = compiled("such \"type\" is \"dict\" wow");
+    rewind(f);
+    check(dson_iter_new(f, &opts, &it), "iter_new");
+    err = dson_iter_next(it, NULL, &v);
+    if (err == NULL || strstr(err, "array is not allowed here") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    dson_iter_free(&it);
+    dson_schema_free(&opts.schema);
+    fclose(f);
+
+    printf("pass\n");
+}
+
+/* One compiled schema, two documents open on it at once. */
+static void sharing(void) {
+    const char *docs[2] = {
+        "such \"a\" is 1, \"b\" is 2 wow",
+        "such \"b\" is 1, \"c\" is 2 wow",
+    };
+    dson_parse_options opts = { 0 };
+    char rules[2048], doc[2048], *err, *k;
+    dson_iter *it[2];
+    dson_value *tree, *v;
+    size_t len = 0;
+    FILE *f[2];
+
+    printf("Sharing one schema...");
+    fflush(stdout);
+
+    opts.schema = compiled("such \"required\" is so \"a\" also \"b\" many "
+                           "wow");
+    for (int i = 0; i < 2; i++) {
+        f[i] = tmpfile();
+        if (f[i] == NULL || fputs(docs[i], f[i]) == EOF)
+            exit(1);
+        rewind(f[i]);
+        check(dson_iter_new(f[i], &opts, &it[i]), "iter_new");
+    }
+
+    /* such interleave.  each keeps its own keys */
+    check(dson_iter_next(it[0], &k, &v), "iter_next");
+    dson_free_buffer(k);
+    dson_free(&v);
+    check(dson_iter_next(it[1], &k, &v), "iter_next");
+    dson_free_buffer(k);
+    dson_free(&v);
+    err = dson_iter_next(it[1], &k, &v);
+    if (err == NULL || strstr(err, "missing required key \"a\"") == NULL) {
+        fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+        exit(1);
+    }
+    free(err);
+    check(dson_iter_next(it[0], &k, &v), "iter_next");
+    dson_free_buffer(k);
+    dson_free(&v);
+
+    for (int i = 0; i < 2; i++) {
+        dson_iter_free(&it[i]);
+        fclose(f[i]);
+    }
+    dson_schema_free(&opts.schema);
+
+    /* many keys.  more than one word of them */
+    len = snprintf(rules, sizeof(rules), "such \"required\" is so ");
+    for (int i = 0; i < 65; i++) {
+        len += snprintf(rules + len, sizeof(rules) - len, "%s\"k%d\"",
+                        i ? " and " : "", i);
+    }
+    snprintf(rules + len, sizeof(rules) - len, " many wow");
+    opts.schema = compiled(rules);
+    for (int missing = 64; missing <= 65; missing++) {
+        len = snprintf(doc, sizeof(doc), "such ");
+        for (int i = 0; i < 65; i++) {
+            if (i != missing) {
+                len += snprintf(doc + len, sizeof(doc) - len,
+                                "\"k%d\" is empty, ", i);
+            }
+        }
+        snprintf(doc + len, sizeof(doc) - len, "\"k0\" is empty wow");
+        check(dson_parse(doc, strlen(doc), false, &tree), "parse");
+        err = dson_schema_validate(tree, opts.schema);
+        dson_free(&tree);
+        if ((missing == 64) != (err != NULL) ||
+            (err != NULL && strstr(err, "missing required key \"k64\"") ==
+             NULL)) {
+            fprintf(stderr, "got \"%s\"\n", err ? err : "pass");
+            exit(1);
+        }
+        free(err);
+    }
+    dson_schema_free(&opts.schema);
+
+    printf("pass\n");
+}
+
+int main() {
+    compiling();
+    validating();
+    parsing();
+    iterating();
+    sharing();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -71,6 +71,7 @@ int main() {
     very("such \"foo\" is such \"shiba\" is \"inu\", \"doge\" is yes wow wow");
     very("such \"foo\" is so \"bar\" also \"baz\" and \"fizzbuzz\" many wow");
     very("such \"foo\" is 42, \"bar\" is 42very3 wow");
+    very("such \"foo\" is such wow, \"bar\" is so such wow many wow");
 }
 
 /* Local variables: */
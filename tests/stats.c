@@ -0,0 +1,207 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void expect(const char *what, uint64_t got, uint64_t expected) {
+    if (got != expected) {
+        fprintf(stderr, "%s: expected %llu, got %llu\n", what,
+                (unsigned long long)expected, (unsigned long long)got);
+        exit(1);
+    }
+}
+
+/* much tally.  the library should agree */
+static uint64_t calls, requested;
+
+static void *tally_alloc(void *ctx, size_t size) {
+    (void)ctx;
+    calls++;
+    requested += size;
+    return malloc(size);
+}
+
+static void *tally_resize(void *ctx, void *ptr, size_t size) {
+    (void)ctx;
+    calls++;
+    requested += size;
+    return realloc(ptr, size);
+}
+
+static void tally_release(void *ctx, void *ptr) {
+    (void)ctx;
+    free(ptr);
+}
+
+static const char *doc = "so 1 and \"ab\" and such \"k\" is so many wow many";
+
+static void counting(void) {
+    dson_allocator a = { tally_alloc, tally_resize, tally_release, NULL };
+    dson_parse_options opts = { 0 };
+    dson_dump_options dopts = { 0 };
+    dson_stats s;
+    dson_value *v;
+    char *out;
+    size_t len;
+
+    printf("Counting parse and dump...");
+    fflush(stdout);
+
+    dson_set_allocator(&a);
+    opts.stats = &s;
+    calls = requested = 0;
+    check(dson_parse_with(doc, strlen(doc), &opts, &v), "parse_with");
+    expect("parse bytes", s.bytes, strlen(doc));
+    expect("parse nodes", s.nodes, 5);
+    expect("parse depth", s.max_depth, 3);
+    expect("parse allocs", s.allocs, calls);
+    expect("parse alloc bytes", s.alloc_bytes, requested);
+
+    dopts.stats = &s;
+    calls = requested = 0;
+    check(dson_dump_with(v, &dopts, &out, &len), "dump_with");
+    expect("dump bytes", s.bytes, len);
+    expect("dump nodes", s.nodes, 5);
+    expect("dump depth", s.max_depth, 3);
+    expect("dump allocs", s.allocs, calls);
+    expect("dump alloc bytes", s.alloc_bytes, requested);
+    tally_release(NULL, out);
+    dson_free(&v);
+    dson_set_allocator(NULL);
+
+    check(dson_parse_with("\"lone\"", 6, &opts, &v), "parse_with");
+    expect("scalar depth", s.max_depth, 0);
+    expect("scalar nodes", s.nodes, 1);
+    dson_free(&v);
+
+    printf("pass\n");
+}
+
+/* failed call.  stats filled.  then left alone */
+static void after_error(void) {
+    dson_parse_options opts = { 0 };
+    dson_stats s, copy;
+    dson_value *v;
+    char *err;
+
+    printf("Counting a failed parse...");
+    fflush(stdout);
+
+    opts.stats = &s;
+    err = dson_parse_with("so 1 and wow", 12, &opts, &v);
+    if (err == NULL) {
+        fprintf(stderr, "unexpected success\n");
+        exit(1);
+    }
+    free(err);
+    expect("failed parse nodes", s.nodes, 1);
+
+    copy = s;
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    dson_free(&v);
+    if (memcmp(&copy, &s, sizeof(s))) {
+        fprintf(stderr, "stats changed after the call returned\n");
+        exit(1);
+    }
+
+    printf("pass\n");
+}
+
+static void footprint(void) {
+    dson_parse_options opts = { 0 };
+    dson_footprint f;
+    dson_value *v;
+
+    printf("Measuring tree footprint...");
+    fflush(stdout);
+
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    check(dson_tree_stats(v, &f), "tree_stats");
+    expect("nodes", f.nodes, 5);
+    expect("node bytes", f.node_bytes,
+           5 * sizeof(dson_value) + sizeof(dson_dict));
+    expect("string bytes", f.string_bytes, 3);
+    expect("key bytes", f.key_bytes, 2);
+    expect("pointer bytes", f.pointer_bytes, (4 + 4 + 1) * sizeof(void *));
+    expect("depth", f.max_depth, 3);
+    dson_free(&v);
+
+    opts.intern_keys = true;
+    check(dson_parse_with(doc, strlen(doc), &opts, &v), "parse_with");
+    check(dson_tree_stats(v, &f), "tree_stats");
+    expect("interned key bytes", f.key_bytes, 0);
+    dson_free(&v);
+
+    printf("pass\n");
+}
+
+static void aggregate(void) {
+    dson_stats total = { 0 }, a = { 1, 2, 3, 4, 5, 6 }, b = { 10, 20, 30,
+                                                              40, 2, 60 };
+
+    printf("Aggregating...");
+    fflush(stdout);
+
+    dson_stats_add(&total, &a);
+    dson_stats_add(&total, &b);
+    expect("bytes", total.bytes, 11);
+    expect("nodes", total.nodes, 22);
+    expect("allocs", total.allocs, 33);
+    expect("alloc bytes", total.alloc_bytes, 44);
+    expect("max depth", total.max_depth, 5);
+    expect("ns", total.ns, 66);
+
+    printf("pass\n");
+}
+
+/* one element per call.  bytes add up */
+static void iterating(void) {
+    dson_parse_options opts = { 0 };
+    dson_stats s, total = { 0 };
+    dson_iter *it;
+    dson_value *v;
+    FILE *f;
+
+    printf("Counting iteration...");
+    fflush(stdout);
+
+    f = tmpfile();
+    fputs(doc, f);
+    rewind(f);
+
+    opts.stats = &s;
+    check(dson_iter_new(f, &opts, &it), "iter_new");
+    do {
+        check(dson_iter_next(it, NULL, &v), "iter_next");
+        dson_stats_add(&total, &s);
+        dson_free(&v);
+    } while (s.nodes != 0);
+    dson_iter_free(&it);
+    fclose(f);
+
+    expect("iterated bytes", total.bytes, strlen(doc));
+    expect("iterated depth", total.max_depth, 3);
+
+    printf("pass\n");
+}
+
+int main() {
+    counting();
+    after_error();
+    footprint();
+    aggregate();
+    iterating();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,289 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include <cdson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *logs =
+    "such \"level\" is \"info\", \"n\" is 1 wow\n"
+    "such \"level\" is \"warn\", \"n\" is 2 wow\n"
+    "\n"
+    "so yes and 42 many 5 \"fin\"\n";
+
+static const char *expected[] = {
+    "such \"level\" is \"info\"! \"n\" is 1 wow",
+    "such \"level\" is \"warn\"! \"n\" is 2 wow",
+    "so yes and 42 many",
+    "5",
+    "\"fin\"",
+    NULL,
+};
+
+static void same(dson_value *v, const char *want) {
+    char *out, *err;
+    size_t len;
+
+    err = dson_dump(v, &out, &len);
+    if (err != NULL) {
+        fprintf(stderr, "dump failed: %s\n", err);
+        exit(1);
+    } else if (strcmp(out, want)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", want, out);
+        exit(1);
+    }
+    free(out);
+}
+
+static void check_next(void) {
+    const char *p = logs;
+    dson_value *v;
+    size_t consumed, i = 0;
+    char *err;
+
+    printf("Parsing one at a time...");
+    fflush(stdout);
+
+    while (1) {
+        err = dson_parse_next(p, strlen(p), NULL, &consumed, &v);
+        if (err != NULL) {
+            fprintf(stderr, "parse failed: %s\n", err);
+            exit(1);
+        } else if (v == NULL) {
+            break;
+        }
+
+        same(v, expected[i++]);
+        dson_free(&v);
+        p += consumed;
+    }
+    if (expected[i] != NULL || *p != '\0') {
+        fprintf(stderr, "stopped early after %zu documents\n", i);
+        exit(1);
+    }
+    printf("pass\n");
+}
+
+static void check_batch(size_t max, size_t want_n) {
+    dson_parse_options opts = { 0 };
+    dson_value *v;
+    size_t consumed, i;
+    char *err;
+
+    printf("Parsing batch of up to %zu...", max);
+    fflush(stdout);
+
+    opts.intern_keys = true;
+    err = dson_parse_batch(logs, strlen(logs), &opts, max, &consumed, &v);
+    if (err != NULL) {
+        fprintf(stderr, "parse failed: %s\n", err);
+        exit(1);
+    }
+    for (i = 0; v->array[i] != NULL; i++)
+        same(v->array[i], expected[i]);
+    if (i != want_n) {
+        fprintf(stderr, "expected %zu documents, got %zu\n", want_n, i);
+        exit(1);
+    } else if (max == 0 && consumed != strlen(logs)) {
+        fprintf(stderr, "only consumed %zu bytes\n", consumed);
+        exit(1);
+    } else if (max == 2 && strncmp(logs + consumed, "so yes", 6)) {
+        fprintf(stderr, "stopped in the wrong place: %s\n", logs + consumed);
+        exit(1);
+    }
+
+    /* one table for the whole batch */
+    if (v->array[0]->dict->keys[0] != v->array[1]->dict->keys[0]) {
+        fprintf(stderr, "keys not interned across the batch\n");
+        exit(1);
+    }
+    dson_free(&v);
+    printf("pass\n");
+}
+
+static void check_bad(void) {
+    const char *s = "yes\nno\nsuch \"broken\" wow\nyes";
+    dson_value *v;
+    size_t consumed;
+    char *err;
+
+    printf("Parsing a bad batch...");
+    fflush(stdout);
+
+    err = dson_parse_batch(s, strlen(s), NULL, 0, &consumed, &v);
+    if (err == NULL) {
+        fprintf(stderr, "unexpected success\n");
+        exit(1);
+    }
+    printf("expected failure: %s\n", err);
+    free(err);
+}
+
+static FILE *spill(const char *s) {
+    FILE *f = tmpfile();
+
+    if (f == NULL || fputs(s, f) == EOF) {
+        fprintf(stderr, "tmpfile failed\n");
+        exit(1);
+    }
+    rewind(f);
+    return f;
+}
+
+/* big export.  one element at a time */
+static void check_iter(void) {
+    dson_iter *it;
+    dson_value *v;
+    size_t i, n = 20000, big = 300000;
+    char *err, *big_str;
+    FILE *f = tmpfile();
+
+    printf("Iterating over %zu elements...", n);
+    fflush(stdout);
+
+    big_str = malloc(big + 1);
+    memset(big_str, 'w', big);
+    big_str[big] = '\0';
+
+    fputs("so ", f);
+    for (i = 0; i < n; i++) {
+        if (i == n / 2)
+            fprintf(f, "\"%s\" also ", big_str);
+        fprintf(f, "such \"i\" is %zo, \"s\" is \"%zu\" wow and ", i, i);
+    }
+    fputs("1234567 many", f);
+    rewind(f);
+
+    err = dson_iter_new(f, NULL, &it);
+    for (i = 0; err == NULL; i++) {
+        err = dson_iter_next(it, NULL, &v);
+        if (err != NULL || v == NULL)
+            break;
+
+        if (i == n / 2) {
+            if (v->type != DSON_STRING || strcmp(v->s, big_str)) {
+                fprintf(stderr, "big element mangled\n");
+                exit(1);
+            }
+        } else if (i == n + 1) {
+            if (v->type != DSON_DOUBLE || v->n != 01234567) {
+                fprintf(stderr, "last element mangled\n");
+                exit(1);
+            }
+        } else if (v->type != DSON_DICT ||
+                   v->dict->values[0]->n != (i > n / 2 ? i - 1 : i)) {
+            fprintf(stderr, "element %zu mangled\n", i);
+            exit(1);
+        }
+        dson_free(&v);
+    }
+    if (err != NULL) {
+        fprintf(stderr, "iteration failed: %s\n", err);
+        exit(1);
+    } else if (i != n + 2) {
+        fprintf(stderr, "expected %zu elements, got %zu\n", n + 2, i);
+        exit(1);
+    }
+
+    dson_iter_free(&it);
+    fclose(f);
+    free(big_str);
+    printf("pass\n");
+}
+
+static void check_iter_dict(void) {
+    const char *keys[] = { "shiba", "doge", NULL };
+    dson_iter *it;
+    dson_value *v;
+    char *err, *k;
+    FILE *f;
+
+    printf("Iterating over a dict...");
+    fflush(stdout);
+
+    f = spill("  such \"shiba\" is so 1 many, \"doge\" is yes wow");
+    err = dson_iter_new(f, NULL, &it);
+    for (size_t i = 0; err == NULL; i++) {
+        err = dson_iter_next(it, &k, &v);
+        if (err != NULL || v == NULL) {
+            if (err == NULL && keys[i] != NULL) {
+                fprintf(stderr, "stopped early\n");
+                exit(1);
+            }
+            break;
+        } else if (keys[i] == NULL || strcmp(k, keys[i])) {
+            fprintf(stderr, "unexpected key %s\n", k);
+            exit(1);
+        }
+        free(k);
+        dson_free(&v);
+    }
+    if (err != NULL) {
+        fprintf(stderr, "iteration failed: %s\n", err);
+        exit(1);
+    }
+    dson_iter_free(&it);
+    fclose(f);
+
+    /* such wow.  nothing to give */
+    f = spill("such wow");
+    err = dson_iter_new(f, NULL, &it);
+    if (err == NULL)
+        err = dson_iter_next(it, &k, &v);
+    if (err != NULL || k != NULL || v != NULL) {
+        fprintf(stderr, "empty dict: %s\n", err ? err : "gave an entry");
+        exit(1);
+    }
+    dson_iter_free(&it);
+    fclose(f);
+    printf("pass\n");
+}
+
+static void check_iter_bad(const char *s) {
+    dson_iter *it;
+    dson_value *v;
+    char *err;
+    FILE *f;
+
+    printf("Iterating over %s...", s);
+    fflush(stdout);
+
+    f = spill(s);
+    err = dson_iter_new(f, NULL, &it);
+    while (err == NULL) {
+        err = dson_iter_next(it, NULL, &v);
+        if (err == NULL && v == NULL)
+            break;
+        dson_free(&v);
+    }
+    if (err == NULL) {
+        fprintf(stderr, "unexpected success\n");
+        exit(1);
+    }
+    printf("expected failure: %s\n", err);
+    free(err);
+    dson_iter_free(&it);
+    fclose(f);
+}
+
+int main() {
+    check_next();
+    check_batch(0, 5);
+    check_batch(2, 2);
+    check_bad();
+    check_iter();
+    check_iter_dict();
+    check_iter_bad("so 1 and 2 and");
+    check_iter_bad("so 1 and \"2 many");
+    check_iter_bad("yes");
+    check_iter_bad("such \"a\" is 1, wow");
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
@@ -0,0 +1,152 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+#include "helpers.h"
+
+#include <cdson.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* writer output.  dump output.  same doge */
+static void same_as_dump(dson_writer *w, const char *doc) {
+    dson_value *v;
+    char *written, *dumped;
+    size_t written_len, dumped_len;
+
+    check(dson_writer_finish(w, &written, &written_len), "writer_finish");
+    dson_writer_free(&w);
+
+    check(dson_parse(doc, strlen(doc), false, &v), "parse");
+    check(dson_dump(v, &dumped, &dumped_len), "dump");
+    dson_free(&v);
+
+    if (written_len != dumped_len || strcmp(written, dumped)) {
+        fprintf(stderr, "expected \"%s\", got \"%s\"\n", dumped, written);
+        exit(1);
+    }
+    free(written);
+    free(dumped);
+}
+
+static void nested(void) {
+    dson_writer *w;
+
+    printf("Writing nested containers...");
+    fflush(stdout);
+
+    check(dson_writer_new(NULL, &w), "writer_new");
+    check(dson_writer_begin_dict(w), "begin_dict");
+    check(dson_writer_key(w, "shiba"), "key");
+    check(dson_writer_string(w, "inu/\"\xe5\x9d\x8e\""), "string");
+    check(dson_writer_key(w, "doge"), "key");
+    check(dson_writer_begin_array(w), "begin_array");
+    check(dson_writer_double(w, -5.5), "double");
+    check(dson_writer_bool(w, true), "bool");
+    check(dson_writer_none(w), "none");
+    check(dson_writer_begin_dict(w), "begin_dict");
+    check(dson_writer_key(w, "a"), "key");
+    check(dson_writer_bool(w, false), "bool");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_begin_array(w), "begin_array");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_key(w, "doge"), "key");
+    check(dson_writer_double(w, 8), "double");
+    check(dson_writer_end(w), "end");
+    same_as_dump(w, "such \"shiba\" is \"inu\\/\\\"\xe5\x9d\x8e\\\"\", "
+                 "\"doge\" is so -5.4 and yes and empty and such \"a\" is no "
+                 "wow and so many many, \"doge\" is 10 wow");
+
+    check(dson_writer_new(NULL, &w), "writer_new");
+    check(dson_writer_string(w, "lone"), "string");
+    same_as_dump(w, "\"lone\"");
+
+    printf("pass\n");
+}
+
+/* such mistakes.  nothing written.  carry on */
+static void misuse(void) {
+    dson_writer *w;
+    char *out;
+    size_t len;
+
+    printf("Rejecting misuse...");
+    fflush(stdout);
+
+    check(dson_writer_new(NULL, &w), "writer_new");
+    expect_error(dson_writer_end(w), "end with nothing open");
+    expect_error(dson_writer_key(w, "k"), "key outside dict");
+    expect_error(dson_writer_finish(w, &out, &len), "finish empty");
+    check(dson_writer_begin_dict(w), "begin_dict");
+    expect_error(dson_writer_none(w), "value without key");
+    check(dson_writer_key(w, "k"), "key");
+    expect_error(dson_writer_key(w, "k"), "two keys");
+    expect_error(dson_writer_end(w), "end with key pending");
+    expect_error(dson_writer_double(w, NAN), "NaN");
+    check(dson_writer_begin_array(w), "begin_array");
+    expect_error(dson_writer_key(w, "k"), "key in array");
+    expect_error(dson_writer_finish(w, &out, &len), "finish while open");
+    check(dson_writer_double(w, 1), "double");
+    check(dson_writer_end(w), "end");
+    check(dson_writer_end(w), "end");
+    expect_error(dson_writer_bool(w, true), "second document");
+    same_as_dump(w, "such \"k\" is so 1 many wow");
+
+    check(dson_writer_new(NULL, &w), "writer_new");
+    check(dson_writer_begin_array(w), "begin_array");
+    expect_error(dson_writer_string(w, "\xff"), "bad UTF-8");
+    expect_error(dson_writer_end(w), "end after failure");
+    dson_writer_free(&w);
+
+    printf("pass\n");
+}
+
+static void large(void) {
+    dson_dump_options opts = { 0 };
+    dson_stats s;
+    dson_writer *w;
+    char key[32], *out;
+    size_t len, n = 0200000;
+
+    printf("Writing %zu entries...", n);
+    fflush(stdout);
+
+    opts.stats = &s;
+    check(dson_writer_new(&opts, &w), "writer_new");
+    check(dson_writer_begin_dict(w), "begin_dict");
+    for (size_t i = 0; i < n; i++) {
+        snprintf(key, sizeof(key), "k%zu", i);
+        check(dson_writer_key(w, key), "key");
+        check(dson_writer_begin_array(w), "begin_array");
+        check(dson_writer_double(w, i), "double");
+        check(dson_writer_end(w), "end");
+    }
+    check(dson_writer_end(w), "end");
+    check(dson_writer_finish(w, &out, &len), "writer_finish");
+    dson_writer_free(&w);
+
+    if (s.bytes != len || s.nodes != 1 + 2 * n || s.max_depth != 2 ||
+        s.allocs == 0) {
+        fprintf(stderr, "bad stats\n");
+        exit(1);
+    }
+    free(out);
+
+    printf("pass\n");
+}
+
+int main() {
+    nested();
+    misuse();
+    large();
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */
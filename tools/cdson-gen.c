@@ -0,0 +1,696 @@
+/* This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at https://mozilla.org/MPL/2.0/. */
+/* such software.  many freedoms. */
+
+/* Usage: cdson-gen schema.dson out.h out.c
+ *
+ * Generates C that parses DSON straight into your structs and dumps straight
+ * from them, with no dson_value trees and no key lookups along the way.  The
+ * schema is itself DSON: a dict of struct names, each a dict of its fields
+ * and their types, in order.  A type is one of "bool", "double", "int"
+ * (int64_t), "uint" (uint64_t), "string" (char *, empty for NULL), or the
+ * name of a struct defined earlier, embedded whole; or an array of one of
+ * those, written so "type" many, which becomes a pointer and an n_ count.
+ * Arrays may also hold the struct being defined.
+ *
+ *     such "point" is such "x" is "double" , "y" is "double" wow ,
+ *          "track" is such "name" is "string" ,
+ *                          "points" is so "point" many wow wow
+ *
+ * For each struct, out.h then declares:
+ *
+ *     char *point_parse(const char *input, size_t length, struct point *out);
+ *     char *point_dump(const struct point *in, char **out, size_t *len_out);
+ *     void point_free(struct point *p);
+ *
+ * which behave as dson_parse(), dson_dump() and dson_free() would.  Keys the
+ * schema doesn't name are skipped when parsing, and fields absent from the
+ * input are left zero. */
+
+#include <cdson.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define KIND_BOOL 0
+#define KIND_DOUBLE 1
+#define KIND_INT 2
+#define KIND_UINT 3
+#define KIND_STRING 4
+#define KIND_STRUCT 5
+
+static const char *const kind_names[] = {
+    "bool", "double", "int", "uint", "string",
+};
+static const char *const c_types[] = {
+    "bool ", "double ", "int64_t ", "uint64_t ", "char *",
+};
+static const char *const writers[] = {
+    "dson_writer_bool", "dson_writer_double", "dson_writer_int",
+    "dson_writer_uint", "gen_write_string",
+};
+static const char *const readers[] = {
+    "gen_bool", "gen_double", "gen_int", "gen_uint", "gen_string",
+};
+
+typedef struct {
+    const char *name;
+    int kind;
+    const char *ref; /* struct name, for KIND_STRUCT */
+    bool array;
+} field;
+
+typedef struct {
+    const char *name;
+    field *fields;
+    size_t n_fields;
+} record;
+
+typedef struct {
+    record *records;
+    size_t n_records;
+} schema;
+
+/* Emitted verbatim at the top of every generated source. */
+static const char helpers[] =
+    "/* Strings in tokens are ours to free. */\n"
+    "static void gen_drop(dson_token *tok) {\n"
+    "    if (tok != NULL && tok->kind == DSON_TOKEN_VALUE &&\n"
+    "        tok->value.type == DSON_STRING) {\n"
+    "        dson_free_buffer(tok->value.s);\n"
+    "        tok->value.s = NULL;\n"
+    "    }\n"
+    "}\n"
+    "\n"
+    "/* \"where: what\", for free(), or dson_out_of_memory. */\n"
+    "static char *gen_fail(dson_token *tok, const char *where,\n"
+    "                      const char *what) {\n"
+    "    size_t len = strlen(where) + strlen(what) + 3;\n"
+    "    char *msg = malloc(len);\n"
+    "\n"
+    "    gen_drop(tok);\n"
+    "    if (msg != NULL)\n"
+    "        snprintf(msg, len, \"%s: %s\", where, what);\n"
+    "    return msg != NULL ? msg : dson_out_of_memory;\n"
+    "}\n"
+    "\n"
+    "/* As gen_fail(), around an error from the library. */\n"
+    "static char *gen_wrap(dson_token *tok, const char *where, char *err) {\n"
+    "    char *msg = gen_fail(tok, where, err);\n"
+    "\n"
+    "    if (err != dson_out_of_memory)\n"
+    "        free(err);\n"
+    "    return msg;\n"
+    "}\n"
+    "\n"
+    "static char *gen_bool(dson_token *tok, bool *out, const char *where) {\n"
+    "    if (tok->kind != DSON_TOKEN_VALUE || tok->value.type != DSON_BOOL)\n"
+    "        return gen_fail(tok, where, \"expected a bool\");\n"
+    "    *out = tok->value.b;\n"
+    "    return NULL;\n"
+    "}\n"
+    "\n"
+    "static char *gen_double(dson_token *tok, double *out,\n"
+    "                        const char *where) {\n"
+    "    char *err;\n"
+    "\n"
+    "    if (tok->kind != DSON_TOKEN_VALUE)\n"
+    "        return gen_fail(tok, where, \"expected a number\");\n"
+    "    err = dson_get_double(&tok->value, out);\n"
+    "    return err == NULL ? NULL : gen_wrap(tok, where, err);\n"
+    "}\n"
+    "\n"
+    "static char *gen_int(dson_token *tok, int64_t *out,\n"
+    "                     const char *where) {\n"
+    "    char *err;\n"
+    "\n"
+    "    if (tok->kind != DSON_TOKEN_VALUE)\n"
+    "        return gen_fail(tok, where, \"expected a number\");\n"
+    "    err = dson_get_int64(&tok->value, out);\n"
+    "    return err == NULL ? NULL : gen_wrap(tok, where, err);\n"
+    "}\n"
+    "\n"
+    "static char *gen_uint(dson_token *tok, uint64_t *out,\n"
+    "                      const char *where) {\n"
+    "    char *err;\n"
+    "\n"
+    "    if (tok->kind != DSON_TOKEN_VALUE)\n"
+    "        return gen_fail(tok, where, \"expected a number\");\n"
+    "    err = dson_get_uint64(&tok->value, out);\n"
+    "    return err == NULL ? NULL : gen_wrap(tok, where, err);\n"
+    "}\n"
+    "\n"
+    "/* Takes the token's string.  empty is NULL. */\n"
+    "static char *gen_string(dson_token *tok, char **out,\n"
+    "                        const char *where) {\n"
+    "    if (tok->kind == DSON_TOKEN_VALUE &&\n"
+    "        tok->value.type == DSON_NONE) {\n"
+    "        *out = NULL;\n"
+    "        return NULL;\n"
+    "    } else if (tok->kind != DSON_TOKEN_VALUE ||\n"
+    "               tok->value.type != DSON_STRING) {\n"
+    "        return gen_fail(tok, where, \"expected a string\");\n"
+    "    }\n"
+    "    *out = tok->value.s;\n"
+    "    tok->value.s = NULL;\n"
+    "    return NULL;\n"
+    "}\n"
+    "\n"
+    "static char *gen_write_string(dson_writer *w, const char *s) {\n"
+    "    return s == NULL ? dson_writer_none(w) : dson_writer_string(w, s);\n"
+    "}\n"
+    "\n"
+    "/* arr, holding n of *cap, with room for one more; or NULL. */\n"
+    "static void *gen_grow(void *arr, size_t n, size_t *cap, size_t size) {\n"
+    "    size_t want = *cap == 0 ? 8 : *cap * 2;\n"
+    "\n"
+    "    if (n < *cap)\n"
+    "        return arr;\n"
+    "    if (want > SIZE_MAX / size)\n"
+    "        return NULL;\n"
+    "    arr = realloc(arr, want * size);\n"
+    "    if (arr != NULL)\n"
+    "        *cap = want;\n"
+    "    return arr;\n"
+    "}\n";
+
+static bool is_ident(const char *s) {
+    if (!(*s == '_' || (*s >= 'a' && *s <= 'z') || (*s >= 'A' && *s <= 'Z')))
+        return false;
+    for (s++; *s != '\0'; s++) {
+        if (!(*s == '_' || (*s >= 'a' && *s <= 'z') ||
+              (*s >= 'A' && *s <= 'Z') || (*s >= '0' && *s <= '9'))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void fail(const char *fmt, const char *what) {
+    fprintf(stderr, "cdson-gen: ");
+    fprintf(stderr, fmt, what);
+    fprintf(stderr, "\n");
+    exit(1);
+}
+
+static const record *find_record(const schema *sc, size_t upto,
+                                 const char *name) {
+    for (size_t i = 0; i < upto; i++) {
+        if (!strcmp(sc->records[i].name, name))
+            return &sc->records[i];
+    }
+    return NULL;
+}
+
+/* One field's type: a name, or so "name" many. */
+static void read_type(const schema *sc, size_t self, dson_value *v,
+                      field *f) {
+    const char *t;
+
+    if (v->type == DSON_ARRAY) {
+        if (v->array[0] == NULL || v->array[1] != NULL ||
+            v->array[0]->type != DSON_STRING) {
+            fail("field %s: arrays take exactly one type name", f->name);
+        }
+        f->array = true;
+        v = v->array[0];
+    } else if (v->type != DSON_STRING) {
+        fail("field %s: type must be a name or an array of one", f->name);
+    }
+
+    t = v->s;
+    for (int k = KIND_BOOL; k < KIND_STRUCT; k++) {
+        if (!strcmp(t, kind_names[k])) {
+            f->kind = k;
+            return;
+        }
+    }
+
+    /* wow nesting.  embedded ones must be complete already */
+    f->kind = KIND_STRUCT;
+    f->ref = t;
+    if (find_record(sc, self, t) != NULL)
+        return;
+    if (f->array && !strcmp(t, sc->records[self].name))
+        return;
+    fail("unknown type \"%s\" (structs must be defined before use)", t);
+}
+
+static void read_schema(dson_value *root, schema *sc) {
+    dson_dict *d, *fields;
+    record *rec;
+    size_t n;
+    char buf[512];
+
+    if (root->type != DSON_DICT)
+        fail("%s", "schema must be a dict of structs");
+    d = root->dict;
+
+    for (n = 0; d->keys[n] != NULL; n++);
+    sc->records = calloc(n, sizeof(*sc->records));
+    if (sc->records == NULL)
+        fail("%s", "out of memory");
+
+    for (size_t i = 0; i < n; i++) {
+        rec = &sc->records[i];
+        rec->name = d->keys[i];
+        if (!is_ident(rec->name))
+            fail("struct name \"%s\" is not a C identifier", rec->name);
+        if (find_record(sc, i, rec->name) != NULL)
+            fail("struct %s is defined twice", rec->name);
+        if (d->values[i]->type != DSON_DICT)
+            fail("struct %s must be a dict of fields", rec->name);
+
+        fields = d->values[i]->dict;
+        for (rec->n_fields = 0; fields->keys[rec->n_fields] != NULL;
+             rec->n_fields++);
+        if (rec->n_fields == 0)
+            fail("struct %s has no fields", rec->name);
+        rec->fields = calloc(rec->n_fields, sizeof(*rec->fields));
+        if (rec->fields == NULL)
+            fail("%s", "out of memory");
+
+        for (size_t j = 0; j < rec->n_fields; j++) {
+            rec->fields[j].name = fields->keys[j];
+            if (!is_ident(fields->keys[j]))
+                fail("field name \"%s\" is not a C identifier",
+                     fields->keys[j]);
+            read_type(sc, i, fields->values[j], &rec->fields[j]);
+        }
+
+        /* such clash.  n_ counts belong to arrays */
+        for (size_t j = 0; j < rec->n_fields; j++) {
+            for (size_t k = 0; k < rec->n_fields; k++) {
+                snprintf(buf, sizeof(buf), "n_%s", rec->fields[k].name);
+                if ((j != k &&
+                     !strcmp(rec->fields[j].name, rec->fields[k].name)) ||
+                    (rec->fields[k].array &&
+                     !strcmp(rec->fields[j].name, buf))) {
+                    fail("field %s is defined twice", rec->fields[j].name);
+                }
+            }
+        }
+    }
+    sc->n_records = n;
+}
+
+static const char *c_type(const field *f, char *buf, size_t size) {
+    if (f->kind != KIND_STRUCT)
+        return c_types[f->kind];
+    snprintf(buf, size, "struct %s ", f->ref);
+    return buf;
+}
+
+static void emit_header(FILE *h, const schema *sc, const char *from,
+                        const char *guard) {
+    const record *rec;
+    char buf[512];
+
+    fprintf(h, "/* Generated by cdson-gen from %s.  Do not edit. */\n\n",
+            from);
+    fprintf(h, "#ifndef %s\n#define %s\n\n#include <cdson.h>\n\n", guard,
+            guard);
+
+    for (size_t i = 0; i < sc->n_records; i++) {
+        rec = &sc->records[i];
+        fprintf(h, "struct %s {\n", rec->name);
+        for (size_t j = 0; j < rec->n_fields; j++) {
+            const field *f = &rec->fields[j];
+
+            if (f->array) {
+                fprintf(h, "    %s*%s;\n    size_t n_%s;\n",
+                        c_type(f, buf, sizeof(buf)), f->name, f->name);
+            } else {
+                fprintf(h, "    %s%s;\n", c_type(f, buf, sizeof(buf)),
+                        f->name);
+            }
+        }
+        fprintf(h, "};\n\n");
+
+        fprintf(h,
+                "char *%s_parse(const char *input, size_t length,\n"
+                "    struct %s *out);\n"
+                "char *%s_dump(const struct %s *in, char **out,\n"
+                "    size_t *len_out);\n"
+                "void %s_free(struct %s *p);\n\n",
+                rec->name, rec->name, rec->name, rec->name, rec->name,
+                rec->name);
+    }
+    fprintf(h, "#endif /* %s */\n", guard);
+}
+
+/* Read one of f's values from the token in tok into lvalue. */
+static void emit_read_one(FILE *c, const record *rec, const field *f,
+                          const char *lvalue) {
+    if (f->kind == KIND_STRUCT) {
+        fprintf(c, "read_%s(r, tok, &%s)", f->ref, lvalue);
+        return;
+    }
+    fprintf(c, "%s(tok, &%s, \"%s.%s\")", readers[f->kind], lvalue,
+            rec->name, f->name);
+}
+
+static void emit_array_reader(FILE *c, const record *rec, const field *f) {
+    char lvalue[512];
+
+    /* counted before it's read, so _free() sees half-read ones */
+    snprintf(lvalue, sizeof(lvalue), "out->%s[out->n_%s++]", f->name,
+             f->name);
+    fprintf(c,
+            "static char *read_%s_%s(dson_reader *r, dson_token *tok,\n"
+            "    struct %s *out) {\n"
+            "    size_t cap = 0;\n"
+            "    void *grown;\n"
+            "    char *err;\n"
+            "\n"
+            "    if (tok->kind != DSON_TOKEN_ARRAY)\n"
+            "        return gen_fail(tok, \"%s.%s\", \"expected an array\");\n"
+            "    while (true) {\n"
+            "        err = dson_reader_next(r, tok);\n"
+            "        if (err != NULL || tok->kind == DSON_TOKEN_END)\n"
+            "            return err;\n"
+            "        grown = gen_grow(out->%s, out->n_%s, &cap,\n"
+            "                         sizeof(*out->%s));\n"
+            "        if (grown == NULL)\n"
+            "            return gen_fail(tok, \"%s.%s\", \"out of memory\");\n"
+            "        out->%s = grown;\n"
+            "        memset(&out->%s[out->n_%s], 0, sizeof(*out->%s));\n"
+            "        err = ",
+            rec->name, f->name, rec->name, rec->name, f->name, f->name,
+            f->name, f->name, rec->name, f->name, f->name, f->name, f->name,
+            f->name);
+    emit_read_one(c, rec, f, lvalue);
+    fprintf(c,
+            ";\n"
+            "        if (err != NULL)\n"
+            "            return err;\n"
+            "    }\n"
+            "}\n\n");
+}
+
+static void emit_reader(FILE *c, const record *rec) {
+    const field *f;
+    char lvalue[512];
+
+    fprintf(c,
+            "static char *read_%s(dson_reader *r, dson_token *tok,\n"
+            "    struct %s *out) {\n"
+            "    bool seen[%zu] = { false };\n"
+            "    size_t i;\n"
+            "    char *key, *err;\n"
+            "\n"
+            "    if (tok->kind != DSON_TOKEN_DICT)\n"
+            "        return gen_fail(tok, \"%s\", \"expected a dict\");\n"
+            "    while (true) {\n"
+            "        err = dson_reader_next(r, tok);\n"
+            "        if (err != NULL || tok->kind == DSON_TOKEN_END)\n"
+            "            return err;\n"
+            "\n"
+            "        key = tok->value.s;\n",
+            rec->name, rec->name, rec->n_fields, rec->name);
+    for (size_t j = 0; j < rec->n_fields; j++) {
+        fprintf(c, "        %sif (!strcmp(key, \"%s\"))\n"
+                "            i = %zu;\n",
+                j == 0 ? "" : "else ", rec->fields[j].name, j);
+    }
+    fprintf(c,
+            "        else\n"
+            "            i = %zu;\n"
+            "        dson_free_buffer(key);\n"
+            "\n"
+            "        if (i == %zu) {\n"
+            "            err = dson_reader_skip(r);\n"
+            "            if (err != NULL)\n"
+            "                return err;\n"
+            "            continue;\n"
+            "        } else if (seen[i]) {\n"
+            "            return gen_fail(NULL, \"%s\", \"duplicate key\");\n"
+            "        }\n"
+            "        seen[i] = true;\n"
+            "\n"
+            "        err = dson_reader_next(r, tok);\n"
+            "        if (err != NULL)\n"
+            "            return err;\n"
+            "        switch (i) {\n",
+            rec->n_fields, rec->n_fields, rec->name);
+
+    for (size_t j = 0; j < rec->n_fields; j++) {
+        f = &rec->fields[j];
+        fprintf(c, "        case %zu:\n            err = ", j);
+        if (f->array) {
+            fprintf(c, "read_%s_%s(r, tok, out)", rec->name, f->name);
+        } else {
+            snprintf(lvalue, sizeof(lvalue), "out->%s", f->name);
+            emit_read_one(c, rec, f, lvalue);
+        }
+        fprintf(c, ";\n            break;\n");
+    }
+    fprintf(c,
+            "        }\n"
+            "        if (err != NULL)\n"
+            "            return err;\n"
+            "    }\n"
+            "}\n\n");
+}
+
+static void emit_write_one(FILE *c, const field *f, const char *rvalue) {
+    if (f->kind == KIND_STRUCT)
+        fprintf(c, "write_%s(w, &%s)", f->ref, rvalue);
+    else
+        fprintf(c, "%s(w, %s)", writers[f->kind], rvalue);
+}
+
+static void emit_writer(FILE *c, const record *rec) {
+    const field *f;
+    char rvalue[512];
+
+    fprintf(c,
+            "static char *write_%s(dson_writer *w, const struct %s *in) {\n"
+            "    char *err;\n"
+            "\n"
+            "    err = dson_writer_begin_dict(w);\n",
+            rec->name, rec->name);
+    for (size_t j = 0; j < rec->n_fields; j++) {
+        f = &rec->fields[j];
+        fprintf(c,
+                "    if (err == NULL)\n"
+                "        err = dson_writer_key(w, \"%s\");\n",
+                f->name);
+        if (!f->array) {
+            snprintf(rvalue, sizeof(rvalue), "in->%s", f->name);
+            fprintf(c, "    if (err == NULL)\n        err = ");
+            emit_write_one(c, f, rvalue);
+            fprintf(c, ";\n");
+            continue;
+        }
+
+        snprintf(rvalue, sizeof(rvalue), "in->%s[i]", f->name);
+        fprintf(c,
+                "    if (err == NULL)\n"
+                "        err = dson_writer_begin_array(w);\n"
+                "    for (size_t i = 0; err == NULL && i < in->n_%s; i++)\n"
+                "        err = ",
+                f->name);
+        emit_write_one(c, f, rvalue);
+        fprintf(c,
+                ";\n"
+                "    if (err == NULL)\n"
+                "        err = dson_writer_end(w);\n");
+    }
+    fprintf(c,
+            "    if (err == NULL)\n"
+            "        err = dson_writer_end(w);\n"
+            "    return err;\n"
+            "}\n\n");
+}
+
+static void emit_free(FILE *c, const record *rec) {
+    const field *f;
+
+    fprintf(c, "void %s_free(struct %s *p) {\n", rec->name, rec->name);
+    for (size_t j = 0; j < rec->n_fields; j++) {
+        f = &rec->fields[j];
+        if (f->array && (f->kind == KIND_STRING || f->kind == KIND_STRUCT)) {
+            fprintf(c, "    for (size_t i = 0; i < p->n_%s; i++)\n", f->name);
+            if (f->kind == KIND_STRING)
+                fprintf(c, "        dson_free_buffer(p->%s[i]);\n", f->name);
+            else
+                fprintf(c, "        %s_free(&p->%s[i]);\n", f->ref, f->name);
+        }
+        if (f->array)
+            fprintf(c, "    free(p->%s);\n", f->name);
+        else if (f->kind == KIND_STRING)
+            fprintf(c, "    dson_free_buffer(p->%s);\n", f->name);
+        else if (f->kind == KIND_STRUCT)
+            fprintf(c, "    %s_free(&p->%s);\n", f->ref, f->name);
+    }
+    fprintf(c, "    memset(p, 0, sizeof(*p));\n}\n\n");
+}
+
+static void emit_entry_points(FILE *c, const record *rec) {
+    const char *n = rec->name;
+
+    fprintf(c,
+            "char *%s_parse(const char *input, size_t length,\n"
+            "    struct %s *out) {\n"
+            "    dson_parse_options opts = { 0 };\n"
+            "    dson_reader *r;\n"
+            "    dson_token tok;\n"
+            "    char *err;\n"
+            "\n"
+            "    memset(out, 0, sizeof(*out));\n"
+            "    opts.lazy_numbers = true;\n"
+            "    opts.integers = true;\n"
+            "    err = dson_reader_new(input, length, &opts, &r);\n"
+            "    if (err != NULL)\n"
+            "        return err;\n"
+            "\n"
+            "    err = dson_reader_next(r, &tok);\n"
+            "    if (err == NULL)\n"
+            "        err = read_%s(r, &tok, out);\n"
+            "    dson_reader_free(&r);\n"
+            "    if (err != NULL)\n"
+            "        %s_free(out);\n"
+            "    return err;\n"
+            "}\n\n",
+            n, n, n, n);
+    fprintf(c,
+            "char *%s_dump(const struct %s *in, char **out,\n"
+            "    size_t *len_out) {\n"
+            "    dson_writer *w;\n"
+            "    char *err;\n"
+            "\n"
+            "    err = dson_writer_new(NULL, &w);\n"
+            "    if (err != NULL)\n"
+            "        return err;\n"
+            "\n"
+            "    err = write_%s(w, in);\n"
+            "    if (err == NULL)\n"
+            "        err = dson_writer_finish(w, out, len_out);\n"
+            "    dson_writer_free(&w);\n"
+            "    return err;\n"
+            "}\n\n",
+            n, n, n);
+}
+
+static void emit_source(FILE *c, const schema *sc, const char *from,
+                        const char *header) {
+    const record *rec;
+
+    fprintf(c, "/* Generated by cdson-gen from %s.  Do not edit. */\n\n",
+            from);
+    fprintf(c, "#include \"%s\"\n\n#include <stdio.h>\n#include <stdlib.h>\n"
+            "#include <string.h>\n\n", header);
+    fprintf(c, "%s\n", helpers);
+
+    for (size_t i = 0; i < sc->n_records; i++) {
+        rec = &sc->records[i];
+        fprintf(c,
+                "static char *read_%s(dson_reader *r, dson_token *tok,\n"
+                "    struct %s *out);\n"
+                "static char *write_%s(dson_writer *w,"
+                " const struct %s *in);\n",
+                rec->name, rec->name, rec->name, rec->name);
+    }
+    fprintf(c, "\n");
+
+    for (size_t i = 0; i < sc->n_records; i++) {
+        rec = &sc->records[i];
+        for (size_t j = 0; j < rec->n_fields; j++) {
+            if (rec->fields[j].array)
+                emit_array_reader(c, rec, &rec->fields[j]);
+        }
+        emit_reader(c, rec);
+        emit_writer(c, rec);
+        emit_free(c, rec);
+        emit_entry_points(c, rec);
+    }
+}
+
+static char *slurp(const char *path, size_t *len_out) {
+    FILE *f;
+    char *buf = NULL, *grown;
+    size_t len = 0, cap = 0, got;
+
+    f = fopen(path, "rb");
+    if (f == NULL)
+        fail("can't open %s", path);
+    do {
+        if (len + 1 >= cap) {
+            cap = cap == 0 ? 4096 : cap * 2;
+            grown = realloc(buf, cap);
+            if (grown == NULL)
+                fail("%s", "out of memory");
+            buf = grown;
+        }
+        got = fread(buf + len, 1, cap - len - 1, f);
+        len += got;
+    } while (got != 0);
+    if (ferror(f))
+        fail("error reading %s", path);
+    fclose(f);
+
+    buf[len] = '\0';
+    *len_out = len;
+    return buf;
+}
+
+static const char *base_name(const char *path) {
+    const char *slash = strrchr(path, '/');
+
+    return slash == NULL ? path : slash + 1;
+}
+
+int main(int argc, char *argv[]) {
+    schema sc = { 0 };
+    dson_value *root;
+    char *input, *err, guard[512];
+    const char *header;
+    size_t len, i;
+    FILE *h, *c;
+
+    if (argc != 4) {
+        fprintf(stderr, "usage: %s schema.dson out.h out.c\n", argv[0]);
+        return 1;
+    }
+
+    input = slurp(argv[1], &len);
+    err = dson_parse(input, len, false, &root);
+    if (err != NULL)
+        fail("bad schema: %s", err);
+    read_schema(root, &sc);
+
+    /* such guard.  much shout */
+    header = base_name(argv[2]);
+    for (i = 0; header[i] != '\0' && i < sizeof(guard) - 2; i++) {
+        guard[i + 1] = header[i] >= 'a' && header[i] <= 'z' ?
+            header[i] - 'a' + 'A' : header[i];
+        if (!is_ident((char[]){ 'A', guard[i + 1], '\0' }))
+            guard[i + 1] = '_';
+    }
+    guard[0] = '_';
+    guard[i + 1] = '\0';
+
+    h = fopen(argv[2], "w");
+    c = fopen(argv[3], "w");
+    if (h == NULL || c == NULL)
+        fail("%s", "can't open output files");
+    emit_header(h, &sc, base_name(argv[1]), guard);
+    emit_source(c, &sc, base_name(argv[1]), header);
+    if (fclose(h) != 0 || fclose(c) != 0)
+        fail("%s", "error writing output files");
+
+    for (i = 0; i < sc.n_records; i++)
+        free(sc.records[i].fields);
+    free(sc.records);
+    dson_free(&root);
+    free(input);
+    return 0;
+}
+
+/* Local variables: */
+/* c-basic-offset: 4 */
+/* indent-tabs-mode: nil */
+/* End: */